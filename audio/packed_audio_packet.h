@@ -22,12 +22,13 @@
 
 #include <stddef.h>
 #include "serialize.h"
+#include "ref.h"
 
 template <class T>
 class PlanarAudioPacket;
 
 template <class T>
-class PackedAudioPacket : public Serializable {
+class PackedAudioPacket : public Serializable, public RefCounted {
     public:
         PackedAudioPacket(size_t n_samples, size_t n_channels);
         PackedAudioPacket(void *data, size_t n_bytes);
@@ -27,6 +27,7 @@
 #include "mjpeg_codec.h"
 #include "svg_subprocess_character_generator.h"
 #include "png_subprocess_character_generator.h"
+#include "prepared_key.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -225,16 +226,33 @@ class CgFilter : public Filter<RawFrame> {
         virtual void filter(RawFrame *thing) {
             RawFrame *key = cg->output_pipe( ).get( );
 
-            if (key != NULL) {
+            if (key == NULL) {
+                prepared.invalidate( );
+                return;
+            }
+
+            if (UnchangedOverlay::is_unchanged(key)) {
+                /* reuse the last overlay */
+            } else if (key->pixel_format( ) == RawFrame::BGRAn8) {
+                prepared.update(key);
+            } else {
                 thing->draw->alpha_key(cg->x( ), cg->y( ), 
                     key, key->global_alpha( ));
-
                 delete key;
+                return;
             }
+
+            if (prepared.valid( ) && key->global_alpha( ) != 0) {
+                thing->draw->alpha_key(cg->x( ), cg->y( ),
+                    prepared, key->global_alpha( ));
+            }
+
+            delete key;
         }   
 
     protected:
         CharacterGenerator *cg;
+        PreparedKey prepared;
 };
 
 template <class T>
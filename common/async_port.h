@@ -57,6 +57,18 @@ class AsyncPort {
 
             return readbuf;
         }
+
+        /* as above; fresh is set if the value wasn't returned before */
+        T* get(bool &fresh) {
+            T* new_value = buf.exchange(NULL);
+            fresh = (new_value != NULL);
+            if (new_value != NULL) {
+                delete readbuf;
+                readbuf = new_value;
+            }
+
+            return readbuf;
+        }
     protected:
         T* readbuf;
         std::atomic<T*> buf;
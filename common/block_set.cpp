@@ -27,7 +27,10 @@ BlockSet::BlockSet( ) {
 }
 
 BlockSet::~BlockSet( ) {
-
+    /* we own any serialized object blocks (see add_object) */
+    for (BlockData &blk : blocks) {
+        delete blk.sstr;
+    }
 }
 
 void BlockSet::add_block(const char *label, void *data, size_t size) {
@@ -134,6 +137,7 @@ void BlockSet::begin_read(int fd, off_t start) {
         strncpy(data.label, hd.label, sizeof(hd.label));
         data.size = hd.size;
         data.data = NULL;
+        data.sstr = NULL;
         data.offset = -1;
         blocks.push_back(data);
 
@@ -42,6 +42,7 @@ class BlockSet {
         }
 
         void add_block(const char *label, void *data, size_t size);
+        /* the BlockSet takes ownership of sstr and deletes it */
         void add_block(const char *label, SerializeStream *sstr);
 
         /* serialize object and add as a block */
@@ -78,6 +79,8 @@ class BlockSet {
             return new T(dsstr);
         }
 
+        bool have_block(const char *label);
+
         void begin_read(int fd, off_t start);
         size_t write_all(int fd) const;
 
@@ -99,7 +102,6 @@ class BlockSet {
 
         size_t read_data(const char *label, void *data, size_t size);
         BlockData &find_block(const char *label);
-        bool have_block(const char *label);
 
         std::list<BlockData> blocks;
         int fd;
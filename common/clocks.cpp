@@ -35,3 +35,18 @@ uint64_t clock_monotonic_msec( ) {
 
     return ret;    
 }
+
+uint64_t clock_realtime_msec( ) {
+    uint64_t ret;
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+        perror("clock_gettime");
+    }
+
+    ret = ts.tv_sec;
+    ret *= 1000;
+    ret += (ts.tv_nsec / 1000000);
+
+    return ret;
+}
@@ -24,4 +24,7 @@
 
 uint64_t clock_monotonic_msec( );
 
+/* wall-clock time, msec since the epoch; comparable across machines */
+uint64_t clock_realtime_msec( );
+
 #endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OPENREPLAY_RECT_H
+#define _OPENREPLAY_RECT_H
+
+#include "types.h"
+
+/*
+ * An axis-aligned rectangle of pixels: [x, x + w) by [y, y + h).
+ * Used to describe damaged (changed) or covered parts of a frame.
+ */
+struct Rect {
+    coord_t x, y, w, h;
+
+    Rect( ) : x(0), y(0), w(0), h(0) { }
+    Rect(coord_t x_, coord_t y_, coord_t w_, coord_t h_) 
+            : x(x_), y(y_), w(w_), h(h_) { }
+
+    bool empty( ) const { return w == 0 || h == 0; }
+    unsigned int x1( ) const { return x + w; }
+    unsigned int y1( ) const { return y + h; }
+
+    /* smallest rectangle containing both */
+    void unite(const Rect &other) {
+        unsigned int nx0, ny0, nx1, ny1;
+
+        if (other.empty( )) {
+            return;
+        } else if (empty( )) {
+            *this = other;
+            return;
+        }
+
+        nx0 = (x < other.x) ? x : other.x;
+        ny0 = (y < other.y) ? y : other.y;
+        nx1 = (x1( ) > other.x1( )) ? x1( ) : other.x1( );
+        ny1 = (y1( ) > other.y1( )) ? y1( ) : other.y1( );
+
+        x = nx0;
+        y = ny0;
+        w = nx1 - nx0;
+        h = ny1 - ny0;
+    }
+
+    /* clip to the part also inside other */
+    void intersect(const Rect &other) {
+        unsigned int nx0, ny0, nx1, ny1;
+
+        nx0 = (x > other.x) ? x : other.x;
+        ny0 = (y > other.y) ? y : other.y;
+        nx1 = (x1( ) < other.x1( )) ? x1( ) : other.x1( );
+        ny1 = (y1( ) < other.y1( )) ? y1( ) : other.y1( );
+
+        if (nx1 <= nx0 || ny1 <= ny0) {
+            *this = Rect( );
+        } else {
+            x = nx0;
+            y = ny0;
+            w = nx1 - nx0;
+            h = ny1 - ny0;
+        }
+    }
+
+    bool operator==(const Rect &other) const {
+        return x == other.x && y == other.y 
+            && w == other.w && h == other.h;
+    }
+};
+
+#endif
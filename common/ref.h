@@ -17,132 +17,126 @@
  * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #ifndef _OPENREPLAY_REF_H
 #define _OPENREPLAY_REF_H
 
-template <class T>
-class ref { /* lowercased to emphasize how commonplace it should be */
+#include <stddef.h>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+/*
+ * Base for objects whose lifetime is managed by ref<T>. The count 
+ * lives in the object itself, so a ref is one pointer wide and taking
+ * another reference is a single atomic increment.
+ *
+ * Copying an object does not copy its count: the copy starts out 
+ * unreferenced. Objects never handed to a ref can still be deleted 
+ * the ordinary way.
+ */
+class RefCounted {
     public:
-        ref( ) {
-            /* initialize to a null state */
-            _impl = NULL;
+        RefCounted( ) : _refcnt(0) { }
+        RefCounted(const RefCounted &) : _refcnt(0) { }
+        RefCounted &operator=(const RefCounted &) { return *this; }
+
+        void add_ref( ) const { 
+            _refcnt.fetch_add(1, std::memory_order_relaxed); 
         }
 
-        virtual ~ref( ) {
-            /* decrement refcount on the implementation */
-            if (_impl != NULL) {
-                _impl->decref( );
-            }
+        /* returns true when the last reference was dropped */
+        bool release_ref( ) const {
+            return _refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1;
         }
 
-        ref(T* ptr) {
-            _impl = new _ref_impl;
-            _impl->refcnt = 1;
-            _impl->ptr = ptr;
+        unsigned int ref_count( ) const { 
+            return _refcnt.load(std::memory_order_acquire); 
         }
 
-        ref(const ref& src) {
-            /* copy impl. */
-            _impl = src->_impl;
+    private:
+        mutable std::atomic<unsigned int> _refcnt;
+};
 
-            /* increment reference counter */
-            _impl->incref( );
-        }
+/*
+ * Thread-safe intrusive reference to a RefCounted T. The last ref to 
+ * go away deletes the object. 
+ *
+ * Whatever a ref points at is treated as immutable while it is shared:
+ * call make_writable( ) before modifying it, which swaps in a private
+ * copy (T::clone( )) if anybody else still holds a reference. A single
+ * ref object is no more thread-safe than a plain pointer; give each 
+ * thread its own copy.
+ */
+template <class T>
+class ref { /* lowercased to emphasize how commonplace it should be */
+    public:
+        ref( ) : _ptr(NULL) { }
 
-        const ref& operator=(const ref& rhs) {
-            if (_impl != NULL) {
-                _impl->decref( );
-                _impl = NULL;
+        /* adopt a newly allocated object */
+        explicit ref(T *ptr) : _ptr(ptr) {
+            if (_ptr != NULL) {
+                _ptr->add_ref( );
             }
-
-            _impl = rhs->_impl;
-            _impl->incref( );
         }
 
-        const T& operator->() const {
-            if (_impl == NULL) {
-                throw std::runtime_error("null dereference"); 
+        ref(const ref &src) : _ptr(src._ptr) {
+            if (_ptr != NULL) {
+                _ptr->add_ref( );
             }
+        }
 
-            return *(_impl->ptr);
+        ref(ref &&src) : _ptr(src._ptr) {
+            src._ptr = NULL;
         }
 
-        T& operator->() {
-            if (_impl == NULL) {
-                throw std::runtime_error("null dereference"); 
-            }
+        ~ref( ) {
+            reset( );
+        }
 
-            return *(_impl->ptr);
+        ref &operator=(ref rhs) {
+            std::swap(_ptr, rhs._ptr);
+            return *this;
         }
 
-        bool is_null( ) {
-            if (_impl == NULL) {
-                return false;
-            } else {
-                return true;
+        T *operator->( ) const {
+            if (_ptr == NULL) {
+                throw std::runtime_error("null dereference");
             }
+            return _ptr;
         }
 
-        /* Is this thread-safe? Is it efficient? Right now, NO! */
-        ref<T> make_unique( ) {
-            if (_impl->refcnt == 1) {
-                /* already unique so just return a copy. */
-                return *this;
-            } else {
-                /* not unique... make a new copy */
-                return ref<T>(new T(*(_impl->ptr)));
-            }
+        T &operator*( ) const {
+            return *operator->( );
         }
 
-    protected:
-        struct _ref_impl {
-            T *ptr;
-            unsigned int refcnt;
-            _ref_impl( ) { refcnt = 0; }
-            void incref( ) {
-                /* don't care about the return */
-                __sync_add_and_fetch(&refcnt, 1); 
+        T *get( ) const { return _ptr; }
+        bool is_null( ) const { return _ptr == NULL; }
+        bool unique( ) const { return _ptr != NULL && _ptr->ref_count( ) == 1; }
+
+        void reset(T *ptr = NULL) {
+            if (ptr != NULL) {
+                ptr->add_ref( );
             }
-            
-            /* 
-             * Once decref( ) is called on a _ref_impl, the pointer to the
-             * _ref_impl should be discarded. IMMEDIATELY. This is important
-             * because the object deletes itself!
-             */
-            void decref( ) {
-                int new_rc;
-                new_rc = __sync_sub_and_fetch(&refcnt, 1);
-                if (new_rc == 0) {
-                    delete ptr;
-                    delete this;
-                }
+            if (_ptr != NULL && _ptr->release_ref( )) {
+                delete _ptr;
             }
-        } *_impl;
-};
-
-#if 0
-
-template <class T>
-class array_ref : public ref<T> {
-    public:
-        array_ref( ) : ref<T>( ) { }
-        array_ref::~array_ref( ) { }
-        array_ref(const array_ref& src) : ref<T>(src) { }
-        
-        const array_ref& operator=(const array_ref& rhs) {
-            assign(rhs->_impl);
-            return *this;
-        }
-
-        const T& operator[](int i) const {
-            
+            _ptr = ptr;
         }
 
-        T& operator[](int i) const {
-            
+        /* 
+         * Copy on write. Afterwards this ref is the only one to its 
+         * object. (If the other holders let go in the meantime, the copy
+         * was unnecessary but harmless.)
+         */
+        void make_writable( ) {
+            if (_ptr != NULL && _ptr->ref_count( ) > 1) {
+                reset(_ptr->clone( ));
+            }
         }
-}
 
-#endif
+    protected:
+        T *_ptr;
+};
 
 #endif
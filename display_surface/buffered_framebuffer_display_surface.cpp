@@ -0,0 +1,60 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "buffered_framebuffer_display_surface.h"
+
+#include <sys/ioctl.h>
+#include <linux/fb.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+BufferedFramebufferDisplaySurface::BufferedFramebufferDisplaySurface(
+        const char *fb) : FramebufferDisplaySurface(fb) {
+
+    /* draw into memory from now on; _real_data stays the screen */
+    _data = NULL;
+    alloc( );
+    memcpy(_data, _real_data, _pitch * _h);
+
+    vsync_supported = true;
+}
+
+void BufferedFramebufferDisplaySurface::flip( ) {
+    copy_damage(_real_data, _pitch);
+}
+
+bool BufferedFramebufferDisplaySurface::wait_vsync( ) {
+    __u32 crtc = 0;
+
+    if (!vsync_supported) {
+        return false;
+    }
+
+    while (ioctl(_fd, FBIO_WAITFORVSYNC, &crtc) != 0) {
+        if (errno != EINTR) {
+            perror("FBIO_WAITFORVSYNC (falling back to timed refresh)");
+            vsync_supported = false;
+            return false;
+        }
+    }
+
+    return true;
+}
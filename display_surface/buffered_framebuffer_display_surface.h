@@ -0,0 +1,46 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _BUFFERED_FRAMEBUFFER_DISPLAY_SURFACE_H
+#define _BUFFERED_FRAMEBUFFER_DISPLAY_SURFACE_H
+
+#include "framebuffer_display_surface.h"
+
+/*
+ * Framebuffer display that is drawn off-screen. flip( ) copies only the
+ * damaged regions into the visible framebuffer, so partly drawn tiles 
+ * are never shown. Copying instead of panning the virtual framebuffer
+ * keeps clear of the drivers that crash when asked to page flip.
+ *
+ * wait_vsync( ) uses FBIO_WAITFORVSYNC. If the driver doesn't support
+ * it, it returns false from then on and the caller falls back to timed
+ * pacing. Flipping right after the vertical blank keeps the copy out 
+ * of the scanout for all but the largest updates.
+ */
+class BufferedFramebufferDisplaySurface : public FramebufferDisplaySurface {
+    public:
+        BufferedFramebufferDisplaySurface(const char *fb = "/dev/fb0");
+        virtual void flip( );
+        virtual bool wait_vsync( );
+    protected:
+        bool vsync_supported;
+};
+
+#endif
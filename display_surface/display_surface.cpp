@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "display_surface.h"
+#include <string.h>
+
+/* past this many separate regions, just copy their bounding box */
+#define MAX_DAMAGE_RECTS 32
+
+void DisplaySurface::damage(const Rect &r) {
+    Rect clipped = r;
+    clipped.intersect(Rect(0, 0, _w, _h));
+
+    if (clipped.empty( )) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < dirty.size( ); i++) {
+        Rect both = dirty[i];
+        both.intersect(clipped);
+        if (both == clipped) {
+            /* already covered */
+            return;
+        }
+    }
+
+    if (dirty.size( ) < MAX_DAMAGE_RECTS) {
+        dirty.push_back(clipped);
+    } else {
+        for (unsigned int i = 1; i < dirty.size( ); i++) {
+            dirty[0].unite(dirty[i]);
+        }
+        dirty[0].unite(clipped);
+        dirty.resize(1);
+    }
+}
+
+/*
+ * Copy the damaged regions of the surface to a front buffer of the 
+ * same size and format, and forget the damage. Returns bytes copied.
+ */
+size_t DisplaySurface::copy_damage(uint8_t *front, size_t front_pitch) {
+    size_t copied = 0;
+    size_t bpp = pixel_size( );
+
+    if (dirty.empty( )) {
+        dirty.push_back(Rect(0, 0, _w, _h));
+    }
+
+    for (unsigned int i = 0; i < dirty.size( ); i++) {
+        const Rect &r = dirty[i];
+        size_t len = r.w * bpp;
+
+        for (coord_t y = r.y; y < r.y1( ); y++) {
+            memcpy(front + y * front_pitch + r.x * bpp, 
+                    _data + y * _pitch + r.x * bpp, len);
+        }
+
+        copied += len * r.h;
+    }
+
+    dirty.clear( );
+    return copied;
+}
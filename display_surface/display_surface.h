@@ -21,13 +21,33 @@
 #define _DISPLAY_SURFACE_H
 
 #include "raw_frame.h"
+#include "rect.h"
+#include <vector>
 
 class DisplaySurface : public RawFrame {
     public:
         virtual void flip( ) = 0;
+
+        /*
+         * Note a region redrawn since the last flip. Surfaces that 
+         * draw off-screen copy only the damaged regions when flipped
+         * (everything, if no damage was noted).
+         */
+        void damage(const Rect &r);
+
+        /*
+         * Block until the next vertical blank. Returns false if the
+         * display can't do that, in which case the caller paces itself.
+         */
+        virtual bool wait_vsync( ) { return false; }
+
     protected:
         DisplaySurface( ) { }
         virtual ~DisplaySurface( ) { };
+
+        size_t copy_damage(uint8_t *front, size_t front_pitch);
+
+        std::vector<Rect> dirty;
 };
 
 #endif
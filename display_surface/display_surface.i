@@ -19,3 +19,5 @@
 
 %include "mplayer_display_surface.i"
 %include "framebuffer_display_surface.i"
+%include "buffered_framebuffer_display_surface.i"
+%include "memory_display_surface.i"
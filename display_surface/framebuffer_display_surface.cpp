@@ -83,6 +83,11 @@ FramebufferDisplaySurface::~FramebufferDisplaySurface( ) {
         munmap(_real_data, screensize);
         close(_fd);
     }
+
+    /* keep ~RawFrame from trying to free( ) the mapping */
+    if (_data == _real_data) {
+        _data = NULL;
+    }
 }
 
 void FramebufferDisplaySurface::flip( ) {
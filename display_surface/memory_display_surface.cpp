@@ -0,0 +1,49 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "memory_display_surface.h"
+#include "xmalloc.h"
+#include <string.h>
+
+MemoryDisplaySurface::MemoryDisplaySurface(coord_t w, coord_t h) {
+    _w = w;
+    _h = h;
+    _pixel_format = BGRAn8;
+    _pitch = minpitch( );
+    alloc( );
+    make_ops( );
+
+    memset(_data, 0, _pitch * _h);
+    front = (uint8_t *) xmalloc(_pitch * _h, "MemoryDisplaySurface", 
+            "front");
+    memset(front, 0, _pitch * _h);
+
+    _flips = 0;
+    _bytes_copied = 0;
+}
+
+MemoryDisplaySurface::~MemoryDisplaySurface( ) {
+    free(front);
+}
+
+void MemoryDisplaySurface::flip( ) {
+    _bytes_copied += copy_damage(front, _pitch);
+    _flips++;
+}
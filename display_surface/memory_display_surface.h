@@ -0,0 +1,49 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _MEMORY_DISPLAY_SURFACE_H
+#define _MEMORY_DISPLAY_SURFACE_H
+
+#include "display_surface.h"
+#include <stdint.h>
+
+/*
+ * Headless display: a BGRAn8 back buffer that flips (copying damaged 
+ * regions, like BufferedFramebufferDisplaySurface) into a front buffer
+ * in memory. For benchmarking and testing the multiviewer without a
+ * screen; there is no vsync, so callers pace themselves.
+ */
+class MemoryDisplaySurface : public DisplaySurface {
+    public:
+        MemoryDisplaySurface(coord_t w = 1920, coord_t h = 1080);
+        ~MemoryDisplaySurface( );
+        virtual void flip( );
+
+        const uint8_t *front_buffer( ) const { return front; }
+        uint64_t flips( ) const { return _flips; }
+        uint64_t bytes_copied( ) const { return _bytes_copied; }
+
+    protected:
+        uint8_t *front;
+        uint64_t _flips;
+        uint64_t _bytes_copied;
+};
+
+#endif
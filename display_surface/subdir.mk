@@ -1,4 +1,7 @@
 display_surface_OBJECTS = \
+    display_surface/display_surface.o \
     display_surface/framebuffer_display_surface.o \
+    display_surface/buffered_framebuffer_display_surface.o \
+    display_surface/memory_display_surface.o \
     display_surface/mplayer_display_surface.o
 
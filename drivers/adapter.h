@@ -30,15 +30,73 @@ class OutputAdapter {
         virtual Pipe<IOAudioPacket *> *audio_input_pipe( ) { return NULL; }
         virtual RawFrame::FieldDominance output_dominance( ) { return RawFrame::UNKNOWN; }
         virtual ~OutputAdapter( ) { }
+
+        /*
+         * Output a video frame together with its audio (which may be NULL).
+         * Takes ownership of both. Adapters that can keep audio and video
+         * locked together override this; by default they are just written 
+         * to the separate pipes.
+         */
+        virtual void write_frame(RawFrame *video, IOAudioPacket *audio) {
+            input_pipe( ).put(video);
+            if (audio_input_pipe( ) != NULL && audio != NULL) {
+                audio_input_pipe( )->put(audio);
+            } else {
+                delete audio;
+            }
+        }
+
+        /* 
+         * Output health counters, for adapters that track them: 
+         * slots where no new frame was ready (repeated), slots missed 
+         * because the frame arrived after its deadline, frames 
+         * discarded to catch back up, and audio packets discarded 
+         * because the audio side fell behind.
+         */
+        virtual uint64_t underruns( ) { return 0; }
+        virtual uint64_t late_frames( ) { return 0; }
+        virtual uint64_t dropped_frames( ) { return 0; }
+        virtual uint64_t dropped_audio( ) { return 0; }
 };
 
 class InputAdapter {
     public:
+        /* what to throw away when the consumer falls behind */
+        enum DropPolicy { DROP_NEWEST, DROP_OLDEST };
+
         virtual Pipe<RawFrame *> &output_pipe( ) = 0;
         virtual Pipe<IOAudioPacket *> *audio_output_pipe( ) { return NULL; }
         virtual ~InputAdapter( ) { }
         virtual void start( ) = 0;
         virtual void rotate180( ) = 0;
+
+        /*
+         * Get the next video frame and the audio that came with it 
+         * (NULL if there's no audio). Use this rather than reading the
+         * two pipes: adapters that throw away stale frames do it here,
+         * so a frame never loses its audio to a drop.
+         */
+        virtual void read_frame(RawFrame *&video, IOAudioPacket *&audio) {
+            video = output_pipe( ).get( );
+            if (audio_output_pipe( ) != NULL) {
+                audio = audio_output_pipe( )->get( );
+            } else {
+                audio = NULL;
+            }
+        }
+
+        /*
+         * Capture queue tuning, for adapters that support it. Call before 
+         * start( ). Zero-copy mode hands out the capture hardware's own 
+         * buffers, which stay held until the consumer deletes the frame;
+         * the queue depth is limited to what the card can spare.
+         */
+        virtual void set_zero_copy(bool) { }
+        virtual void set_queue_depth(unsigned int) { }
+        virtual void set_drop_policy(DropPolicy) { }
+
+        /* frames discarded because the output pipe was full */
+        virtual uint64_t dropped_frames( ) { return 0; }
 };
 
 
@@ -22,13 +22,23 @@
 #include "DeckLinkAPI.h"
 #include "types.h"
 #include "audio_fifo.h"
+#include "output_scheduler.h"
+#include "clocks.h"
+#include "ref.h"
 
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h> // debug
+#include <atomic>
 
 #define IN_PIPE_SIZE 8
+#define IN_PIPE_MAX_SIZE 33
+/* 
+ * Capture buffers we let zero-copy frames hold at once. The SDK doesn't
+ * say how many the driver has; this leaves it enough to keep capturing.
+ */
+#define ZERO_COPY_MAX_FRAMES 6
 #define OUT_PIPE_SIZE 4
 
 struct decklink_norm {
@@ -204,17 +214,26 @@ RawFrame *create_raw_frame_from_decklink(IDeckLinkVideoFrame *frame,
     return ret;
 }
 
+/* card buffers held by an input's zero-copy frames, which may outlive it */
+struct DecklinkBufferCount : public RefCounted {
+    DecklinkBufferCount( ) : held(0) { }
+    std::atomic<unsigned int> held;
+};
+
 /* Adapter from IDeckLinkVideoFrame to RawFrame, enables zero-copy input */
 class DecklinkInputRawFrame : public RawFrame {
     public:
         DecklinkInputRawFrame(IDeckLinkVideoFrame *frame, 
-                RawFrame::PixelFormat pf) : RawFrame(pf) {
+                RawFrame::PixelFormat pf, 
+                const ref<DecklinkBufferCount> &count) 
+                : RawFrame(pf), _count(count) {
 
             void *dp;
 
             assert(frame != NULL);
 
             _frame = frame;
+            _count->held++;
 
             _frame->AddRef( ); 
 
@@ -232,9 +251,11 @@ class DecklinkInputRawFrame : public RawFrame {
             _frame->Release( );
             _frame = NULL;
             _data = NULL;
+            _count->held--;
         }
     protected:
         IDeckLinkVideoFrame *_frame;
+        ref<DecklinkBufferCount> _count;
 
         virtual void alloc( ) {
             throw std::runtime_error(
@@ -253,11 +274,11 @@ class DeckLinkOutputAdapter : public OutputAdapter,
                 RawFrame::PixelFormat pf_ = RawFrame::CbYCrY8422,
                 bool enable_audio = false, unsigned int n_channels = 2) 
                 : deckLink(NULL), 
-                deckLinkOutput(NULL), frame_counter(0),
-                last_frame(NULL), in_pipe(OUT_PIPE_SIZE), audio_in_pipe(NULL) {
+                deckLinkOutput(NULL),
+                in_pipe(OUT_PIPE_SIZE), audio_in_pipe(NULL) {
 
             frames_written = 0;
-            audio_adjust = 0;
+            playback_started = false;
             norm = norm_;
             assert(norm < sizeof(norms) / sizeof(struct decklink_norm));
             time_base = norms[norm].time_base;
@@ -266,16 +287,22 @@ class DeckLinkOutputAdapter : public OutputAdapter,
             pf = pf_;
             bpf = convert_pf(pf_); 
 
+            if (enable_audio) {
+                this->n_channels = n_channels;
+            } else {
+                this->n_channels = 0;
+            }
+
+            scheduler = new OutputScheduler(OUT_PIPE_SIZE, 
+                    frame_duration, time_base, this->n_channels);
+
             deckLink = find_card(card_index);
             configure_card( );
             open_card( );
             preroll_video_frames(5);
 
             if (enable_audio) {
-                this->n_channels = n_channels;
                 setup_audio( );
-            } else {
-                this->n_channels = 0;
             }
 
             start_video( );
@@ -357,25 +384,13 @@ class DeckLinkOutputAdapter : public OutputAdapter,
             IOAudioPacket *audio;
             uint32_t n_consumed;
 
-            if (!preroll) {
-                /* read from audio input pipe */
-                while (audio_in_pipe->data_ready( )) {
-                    /* maybe include a high-water mark to stop loop? */
-
-                    if (audio_adjust > 0) {
-                        /* 
-                         * insert dummy audio as needed to compensate for 
-                         * dropped video frames
-                         */
-                        audio = new IOAudioPacket(1601, n_channels);
-                        audio->zero( );
-                        audio_adjust--;
-                    } else {
-                        audio = audio_in_pipe->get( );
-                    }
-                    audio_fifo->add_packet(audio);
-                    delete audio;
-                }
+            /* 
+             * pick up the audio matched to each video slot scheduled so 
+             * far (silence for preroll and repeated or missed slots)
+             */
+            while ((audio = scheduler->next_audio( )) != NULL) {
+                audio_fifo->add_packet(audio);
+                delete audio;
             }
 
             if (audio_fifo->fill_samples( ) > 0) {
@@ -393,6 +408,15 @@ class DeckLinkOutputAdapter : public OutputAdapter,
         Pipe<IOAudioPacket *> *audio_input_pipe( ) { return audio_in_pipe; }
         AudioFIFO<int16_t> *audio_fifo;
 
+        void write_frame(RawFrame *video, IOAudioPacket *audio) {
+            scheduler->put(video, audio);
+        }
+
+        uint64_t underruns( ) { return scheduler->underruns( ); }
+        uint64_t late_frames( ) { return scheduler->late_frames( ); }
+        uint64_t dropped_frames( ) { return scheduler->dropped_frames( ); }
+        uint64_t dropped_audio( ) { return scheduler->dropped_audio( ); }
+
         RawFrame::FieldDominance output_dominance( ) { return dominance; }
     
     protected:        
@@ -401,12 +425,11 @@ class DeckLinkOutputAdapter : public OutputAdapter,
         
         BMDTimeScale time_base;
         BMDTimeValue frame_duration;
-        unsigned int frame_counter;
 
         unsigned int norm;
-        unsigned int audio_adjust;
 
-        RawFrame *last_frame;
+        OutputScheduler *scheduler;
+        volatile bool playback_started;
 
         Pipe<RawFrame *> in_pipe;
 
@@ -418,8 +441,6 @@ class DeckLinkOutputAdapter : public OutputAdapter,
         unsigned int n_channels;
         Pipe<IOAudioPacket *> *audio_in_pipe;
 
-        IOAudioPacket *current_audio_pkt;
-        uint32_t samples_written_from_current_audio_pkt;
         uint32_t frames_written;
 
         void open_card( ) {
@@ -464,12 +485,12 @@ class DeckLinkOutputAdapter : public OutputAdapter,
         }
 
         void setup_audio( ) {
-            IOAudioPacket preroll_audio(8008, n_channels);
-            preroll_audio.zero( );
-
+            /* 
+             * the preroll video frames already queued a frame's worth of
+             * silence each, so that is our audio preroll
+             */
             audio_in_pipe = new Pipe<IOAudioPacket *>(OUT_PIPE_SIZE);
             audio_fifo = new AudioFIFO<int16_t>(n_channels);
-            audio_fifo->add_packet(&preroll_audio);
 
             assert(deckLinkOutput != NULL);
 
@@ -600,41 +621,61 @@ class DeckLinkOutputAdapter : public OutputAdapter,
             frames_written++;
         }
 
+        /* 
+         * Frames written directly to the pipes (rather than through 
+         * write_frame) are handed to the scheduler here, one per slot,
+         * paired with whatever audio is waiting.
+         */
+        void take_pipe_input( ) {
+            RawFrame *video;
+            IOAudioPacket *audio = NULL;
+
+            if (!in_pipe.data_ready( )) {
+                return;
+            }
+
+            video = in_pipe.get( );
+            if (audio_in_pipe != NULL && audio_in_pipe->data_ready( )) {
+                audio = audio_in_pipe->get( );
+            }
+
+            if (!scheduler->try_put(video, audio)) {
+                delete video;
+                delete audio;
+            }
+        }
+
         void schedule_frame(IDeckLinkMutableVideoFrame *frame) {
-            RawFrame *input = NULL;
+            RawFrame *input;
+            BMDTimeValue now = -1, stream_time, display_time;
+            double playback_speed;
+            int64_t slot_time;
             void *data;
 
-            if (in_pipe.data_ready( )) {
-                input = in_pipe.get( );
-            } else if (last_frame != NULL) {
-                /* use the stale frame */
-                fprintf(stderr, "DeckLink: stale frame\n");
-                input = last_frame;
-                audio_adjust += 1; /* ugly hack */
-            } else {
-                /* this should likewise be a black frame */
-                input = NULL;
+            take_pipe_input( );
+
+            /* the card's own clock decides whether we are running late */
+            if (playback_started && deckLinkOutput->GetScheduledStreamTime(
+                    time_base, &stream_time, &playback_speed) == S_OK) {
+                now = stream_time;
             }
-            
+
+            input = scheduler->next_frame(now, slot_time);
+            display_time = slot_time;
+
+            /* 
+             * input stays owned by the scheduler. If nothing was ever 
+             * written, the frame goes out with whatever it had before.
+             */
             if (input != NULL) {
                 frame->GetBytes(&data);
                 input->unpack->CbYCrY8422((uint8_t *) data);
-            } else {
-                fprintf(stderr, "DeckLink: on fire\n");
-		audio_adjust += 1;
             }
             
             set_frame_timecode(frame);
 
             deckLinkOutput->ScheduleVideoFrame(frame, 
-                frame_counter * frame_duration, frame_duration, time_base);
-
-            frame_counter++;
-
-            if (last_frame != input) {
-                delete last_frame;
-                last_frame = input;
-            }
+                display_time, frame_duration, time_base);
         }
 
         void start_video( ) {
@@ -643,6 +684,8 @@ class DeckLinkOutputAdapter : public OutputAdapter,
                     "Failed to start scheduled playback!\n"
                 );
             }
+
+            playback_started = true;
         }
 
 };
@@ -656,12 +699,17 @@ class DeckLinkInputAdapter : public InputAdapter,
                 RawFrame::PixelFormat pf_ = RawFrame::CbYCrY8422,
                 bool enable_audio = false, unsigned int n_channels = 2,
                 bool enable_video = true)
-                : deckLink(NULL), out_pipe(IN_PIPE_SIZE) {
+                : deckLink(NULL), out_pipe(IN_PIPE_MAX_SIZE),
+                zero_copy_buffers(new DecklinkBufferCount) {
 
             audio_pipe = NULL;
             started = false;
             signal_lost = false;
             rotate = false;
+            zero_copy = false;
+            queue_depth = IN_PIPE_SIZE - 1;
+            drop_policy = DROP_NEWEST;
+            frames_dropped = 0;
             this->enable_video = enable_video;
 
             n_frames = 0;
@@ -677,7 +725,7 @@ class DeckLinkInputAdapter : public InputAdapter,
             open_input(norm_);
 
             if (enable_audio) {
-                audio_pipe = new Pipe<IOAudioPacket *>(IN_PIPE_SIZE);
+                audio_pipe = new Pipe<IOAudioPacket *>(IN_PIPE_MAX_SIZE);
             }
 
             this->n_channels = n_channels;
@@ -707,6 +755,53 @@ class DeckLinkInputAdapter : public InputAdapter,
             rotate = true;
         }
 
+        virtual void set_zero_copy(bool enable) {
+            zero_copy = enable;
+            set_queue_depth(queue_depth);
+        }
+
+        virtual void set_queue_depth(unsigned int depth) {
+            if (depth < 1) {
+                depth = 1;
+            } else if (depth > out_pipe.capacity( )) {
+                depth = out_pipe.capacity( );
+            }
+
+            /* queued frames each hold one of the card's buffers */
+            if (zero_copy && depth > ZERO_COPY_MAX_FRAMES) {
+                depth = ZERO_COPY_MAX_FRAMES;
+            }
+            queue_depth = depth;
+        }
+
+        virtual void set_drop_policy(DropPolicy policy) {
+            drop_policy = policy;
+        }
+
+        virtual uint64_t dropped_frames( ) {
+            return frames_dropped;
+        }
+
+        /*
+         * DROP_OLDEST happens here, on the consumer's side, so the 
+         * stale frame and its audio are thrown away together.
+         */
+        virtual void read_frame(RawFrame *&video, IOAudioPacket *&audio) {
+            for (;;) {
+                InputAdapter::read_frame(video, audio);
+
+                if (drop_policy != DROP_OLDEST 
+                        || out_pipe.fill( ) < queue_depth) {
+                    return;
+                }
+
+                fprintf(stderr, "DeckLink: dropping stale input frame\n");
+                delete video;
+                delete audio;
+                frames_dropped++;
+            }
+        }
+
         virtual HRESULT QueryInterface(REFIID iid, LPVOID *ppv) { 
             UNUSED(iid);
             UNUSED(ppv);
@@ -737,7 +832,6 @@ class DeckLinkInputAdapter : public InputAdapter,
         virtual HRESULT VideoInputFrameArrived(IDeckLinkVideoInputFrame *in,
                 IDeckLinkAudioInputPacket *audio_in) {
             
-            RawFrame *out;
             IOAudioPacket *audio_out;
 
             void *data;
@@ -764,20 +858,10 @@ class DeckLinkInputAdapter : public InputAdapter,
                  * we can't actually tell the card to just not send video,
                  * so if video is disabled, we just ignore the video frames...
                  */
-                if (enable_video) {
-                    out = create_raw_frame_from_decklink(in, pf, rotate);
-                    out->set_field_dominance(dominance);
-                    
-                    if (out_pipe.can_put( ) && started) {
-                        if (enable_video) {
-                            out_pipe.put(out);
-                            avsync++;
-                        }
-                    } else {
-                        fprintf(stderr, "DeckLink: dropping input frame\n");
-                        drop_audio++;
-                        delete out;
-                    }
+                if (enable_video && started) {
+                    queue_video_frame(in);
+                } else if (enable_video) {
+                    drop_audio++;
                 }
             } 
 
@@ -848,10 +932,54 @@ class DeckLinkInputAdapter : public InputAdapter,
         uint64_t start_time;
 
         bool rotate;
+        bool zero_copy;
+
+        unsigned int queue_depth;
+        DropPolicy drop_policy;
+        std::atomic<uint64_t> frames_dropped;
+        ref<DecklinkBufferCount> zero_copy_buffers;
 
         int avsync;
         unsigned int drop_audio;
 
+        /*
+         * Put a captured frame on the output pipe. With DROP_NEWEST, a 
+         * frame that would go past the queue depth is dropped here; 
+         * DROP_OLDEST lets the queue run longer and read_frame( ) 
+         * catches up. In zero-copy mode the card's own buffer is passed
+         * along and returned to the card when the consumer deletes the 
+         * frame, unless too many are held already.
+         */
+        void queue_video_frame(IDeckLinkVideoInputFrame *in) {
+            RawFrame *out;
+            unsigned int limit;
+
+            if (drop_policy == DROP_NEWEST) {
+                limit = queue_depth;
+            } else {
+                limit = out_pipe.capacity( );
+            }
+
+            if (out_pipe.fill( ) >= limit) {
+                fprintf(stderr, "DeckLink: dropping input frame\n");
+                frames_dropped++;
+                drop_audio++;
+                return;
+            }
+
+            if (zero_copy && !rotate 
+                    && zero_copy_buffers->held < ZERO_COPY_MAX_FRAMES) {
+                out = new DecklinkInputRawFrame(in, pf, zero_copy_buffers);
+            } else {
+                out = create_raw_frame_from_decklink(in, pf, rotate);
+            }
+            out->set_field_dominance(dominance);
+            out->set_capture_time(clock_monotonic_msec( ));
+
+            out_pipe.put(out);
+            avsync++;
+        }
+
         Pipe<IOAudioPacket *> *audio_pipe;
 
         void open_input(unsigned int norm) {
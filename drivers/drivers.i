@@ -17,8 +17,31 @@
  * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-class InputAdapter;
-class OutputAdapter;
+%include "stdint.i"
+
+%{
+    #include "adapter.h"
+%}
+
+%nodefaultctor InputAdapter;
+class InputAdapter {
+    public:
+        enum DropPolicy { DROP_NEWEST, DROP_OLDEST };
+
+        virtual void set_zero_copy(bool);
+        virtual void set_queue_depth(unsigned int);
+        virtual void set_drop_policy(DropPolicy);
+        uint64_t dropped_frames( );
+};
+
+%nodefaultctor OutputAdapter;
+class OutputAdapter {
+    public:
+        uint64_t underruns( );
+        uint64_t late_frames( );
+        uint64_t dropped_frames( );
+        uint64_t dropped_audio( );
+};
 
 %include "decklink.i"
 %include "v4l2_input.i"
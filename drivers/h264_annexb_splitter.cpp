@@ -0,0 +1,166 @@
+/*
+ * Copyright 2015 Exavideo LLC.
+ * 
+ * This file is part of exacore.
+ * 
+ * exacore is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * exacore is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with exacore.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "h264_annexb_splitter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PARSE_BUF_SIZE 4194304
+#define PARSE_BUF_MAX 33554432
+
+H264AnnexBSplitter::H264AnnexBSplitter( ) {
+    buf_size = PARSE_BUF_SIZE;
+    buf = new uint8_t[buf_size];
+    reset_parser( );
+}
+
+H264AnnexBSplitter::~H264AnnexBSplitter( ) {
+    delete [] buf;
+}
+
+/*
+ * Find the next 00 00 01 start code in [p, end). memchr for the 01 
+ * is vectorized by libc and skips along much faster than checking 
+ * every byte; in coded data a 01 byte turns up only now and then.
+ */
+static const uint8_t *find_start_code(const uint8_t *p, const uint8_t *end) {
+    const uint8_t *q = p + 2;
+
+    while (q < end) {
+        q = (const uint8_t *) memchr(q, 0x01, end - q);
+        if (q == NULL) {
+            return NULL;
+        }
+
+        if (q[-1] == 0x00 && q[-2] == 0x00) {
+            return q - 2;
+        }
+
+        q++;
+    }
+
+    return NULL;
+}
+
+void H264AnnexBSplitter::reset_parser( ) {
+    bytes_in_buf = 0;
+    au_start = 0;
+    scan_pos = 0;
+    au_has_vcl = false;
+}
+
+uint8_t *H264AnnexBSplitter::read_space(size_t min_space, size_t &space) {
+    /* make room: slide the unfinished access unit to the front */
+    if (buf_size - bytes_in_buf < min_space && au_start > 0) {
+        memmove(buf, buf + au_start, bytes_in_buf - au_start);
+        bytes_in_buf -= au_start;
+        scan_pos -= au_start;
+        au_start = 0;
+    }
+
+    /* an access unit bigger than the buffer: grow, or give up on it */
+    if (buf_size - bytes_in_buf < min_space) {
+        if (buf_size < PARSE_BUF_MAX) {
+            uint8_t *new_buf = new uint8_t[2 * buf_size];
+            memcpy(new_buf, buf, bytes_in_buf);
+            delete [] buf;
+            buf = new_buf;
+            buf_size *= 2;
+        } else {
+            fprintf(stderr, "H264AnnexBSplitter: oversized "
+                "access unit, resyncing\n");
+            reset_parser( );
+        }
+    }
+
+    space = buf_size - bytes_in_buf;
+    return buf + bytes_in_buf;
+}
+
+void H264AnnexBSplitter::commit_read(size_t n) {
+    bytes_in_buf += n;
+    scan_nal_units( );
+}
+
+/*
+ * Walk the start codes that arrived since last time, splitting 
+ * access units where H.264 says a new one begins (7.4.1.2.3): at an
+ * access unit delimiter, SEI, SPS, PPS or NAL types 14-18, or at the
+ * first slice of a new picture, whichever comes first after a picture's
+ * slices.
+ */
+void H264AnnexBSplitter::scan_nal_units( ) {
+    const uint8_t *end = buf + bytes_in_buf;
+    const uint8_t *sc;
+    size_t nal_start;
+    uint8_t *hdr;
+    int type;
+    bool vcl, first_slice;
+
+    for (;;) {
+        sc = find_start_code(buf + scan_pos, end);
+
+        /* need the NAL header and the byte after it */
+        if (sc == NULL || sc + 5 > end) {
+            break;
+        }
+
+        nal_start = sc - buf;
+        hdr = buf + nal_start + 3;
+
+        /* a 4-byte start code's leading zero belongs to this NAL */
+        if (nal_start > au_start && buf[nal_start - 1] == 0x00) {
+            nal_start--;
+        }
+
+        type = hdr[0] & 0x1f;
+        vcl = (type >= 1 && type <= 5);
+
+        /* first_mb_in_slice is ue(v); its code for 0 is a single 1 bit */
+        first_slice = vcl && (hdr[1] & 0x80);
+
+        if (au_has_vcl && (first_slice || type == 6 || type == 7 
+                || type == 8 || type == 9 || (type >= 14 && type <= 18))) {
+            send_access_unit(nal_start);
+            au_start = nal_start;
+            au_has_vcl = false;
+        }
+
+        if (vcl) {
+            au_has_vcl = true;
+        }
+
+        scan_pos = (hdr - buf) + 1;
+    }
+
+    if (sc != NULL) {
+        /* found a start code, but not its header yet: look again here */
+        scan_pos = sc - buf;
+    } else if (bytes_in_buf > 3 && scan_pos < bytes_in_buf - 3) {
+        /* a start code may straddle the end of what we have */
+        scan_pos = bytes_in_buf - 3;
+    }
+}
+
+void H264AnnexBSplitter::send_access_unit(size_t end) {
+    if (end > au_start) {
+        access_unit(buf + au_start, end - au_start);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2015 Exavideo LLC.
+ * 
+ * This file is part of exacore.
+ * 
+ * exacore is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * exacore is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with exacore.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _H264_ANNEXB_SPLITTER_H
+#define _H264_ANNEXB_SPLITTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Splits an H.264 Annex B byte stream, arriving in arbitrary pieces,
+ * into access units. Read into the space given by read_space( ), then 
+ * call commit_read( ); each access unit completed by the new bytes is
+ * passed to access_unit( ), start codes included.
+ */
+class H264AnnexBSplitter {
+    public:
+        H264AnnexBSplitter( );
+        virtual ~H264AnnexBSplitter( );
+
+        /* 
+         * Returns where to put at least min_space more bytes, and how
+         * many fit. An access unit that won't fit even in the largest
+         * buffer is thrown away.
+         */
+        uint8_t *read_space(size_t min_space, size_t &space);
+        void commit_read(size_t n);
+
+        /* forget everything buffered (e.g. after reconnecting) */
+        void reset_parser( );
+
+    protected:
+        virtual void access_unit(const uint8_t *data, size_t size) = 0;
+
+    private:
+        void scan_nal_units( );
+        void send_access_unit(size_t end);
+
+        uint8_t *buf;
+        size_t buf_size;
+        size_t bytes_in_buf;
+        size_t au_start;
+        size_t scan_pos;
+        bool au_has_vcl;
+};
+
+#endif
@@ -18,11 +18,14 @@
  */
 
 #include "adapter.h"
+#include "lavc_raw_frame.h"
+#include "h264_annexb_splitter.h"
 
 #include <string>
 #include <thread>
 
 #include <unistd.h>
+#include <string.h>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -34,9 +37,21 @@ extern "C" {
 #include <poll.h>
 
 #define TIMEOUT_MS 30000
-#define PARSE_BUF_SIZE 1048576
+#define READ_SIZE 262144
+#define AU_PIPE_SIZE 64
 
-class H264TcpInputAdapter : public InputAdapter {
+/*
+ * Receives an H.264 Annex B elementary stream over TCP and decodes it.
+ *
+ * The receive thread reads into a sliding buffer, finds start codes,
+ * and groups NAL units into access units (one coded picture each,
+ * with whatever parameter sets and SEI come before it). Complete 
+ * access units go down a pipe to the decode thread, so a burst of 
+ * network data queues up rather than stalling decoding, and a slow 
+ * decode pushes back on TCP rather than dropping data.
+ */
+class H264TcpInputAdapter : public InputAdapter, 
+        protected H264AnnexBSplitter {
     public:
         H264TcpInputAdapter(const char *host, const char *port);
         virtual ~H264TcpInputAdapter( );
@@ -46,6 +61,7 @@ class H264TcpInputAdapter : public InputAdapter {
     
     protected:
         Pipe<RawFrame *> _out_pipe;
+        Pipe<AVPacket *> au_pipe;
         AVCodecContext *codec_ctx;
 
         int open_socket( );
@@ -57,21 +73,26 @@ class H264TcpInputAdapter : public InputAdapter {
         int sockfd, shutdown;
 
         std::thread worker;
+        std::thread decoder;
         bool worker_running;
         void worker_proc( );
+        void decoder_proc( );
 
-        void decode_and_send(uint8_t *data, size_t size);
+        /* access unit assembly */
+        void access_unit(const uint8_t *data, size_t size);
+
+        void decode_and_send(AVPacket *pkt);
 
-        AVPacket pkt;
         AVFrame *frame;
 };
 
 H264TcpInputAdapter::H264TcpInputAdapter(const char *host, const char *port) 
-: _out_pipe(32) {
+: _out_pipe(32), au_pipe(AU_PIPE_SIZE) {
     _host = host;
     _port = port;
     shutdown = 0;
     sockfd = -1;
+    worker_running = false;
 
     open_codec( );
 }
@@ -82,19 +103,24 @@ H264TcpInputAdapter::~H264TcpInputAdapter( ) {
     close(sockfd);
     sockfd = -1;
 
-    /* wait for the worker thread to stop */
+    /* wait for the worker threads to stop */
     if (worker.joinable( )) {
         worker.join( );
     }
 
+    if (decoder.joinable( )) {
+        decoder.join( );
+    }
+
     /* close the codec */
     close_codec( );
 }
 
 void H264TcpInputAdapter::start( ) {
-    /* start the worker thread */
+    /* start the worker threads */
     if (!worker_running) {
         worker_running = true;
+        decoder = std::thread([this] { decoder_proc(); });
         worker = std::thread([this] { worker_proc(); });
     }
 }
@@ -123,11 +149,20 @@ void H264TcpInputAdapter::open_codec( ) {
         throw std::runtime_error("avcodec_alloc_context3 failed");
     }
 
+    /* 
+     * decode on all cores. Frame threading adds a few frames 
+     * of latency but is what keeps up with 1080p60.
+     */
+    codec_ctx->thread_count = 0;
+    codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    /* so decoded pictures can be handed on without copying */
+    codec_ctx->refcounted_frames = 1;
+
     if (avcodec_open2(codec_ctx, codec, NULL) < 0) {
         throw std::runtime_error("avcodec_open2 failed");
     }
 
-    av_init_packet(&pkt);
     frame = av_frame_alloc( );
     if (frame == NULL) {
         throw std::runtime_error("av_frame_alloc failed");
@@ -135,6 +170,7 @@ void H264TcpInputAdapter::open_codec( ) {
 }
 
 void H264TcpInputAdapter::close_codec( ) {
+    av_frame_free(&frame);
     avcodec_free_context(&codec_ctx);
     codec_ctx = NULL;
 }
@@ -193,32 +229,11 @@ int H264TcpInputAdapter::open_socket( ) {
 
 }
 
-static bool is_nal_start(uint8_t *nal) {
-    if (nal[0] == 0x00 && nal[1] == 0x00) {
-        if (nal[2] == 0x01 || (nal[2] == 0x00 && nal[3] == 0x01)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-static int nal_type(uint8_t *nal) {
-    if (nal[2] == 0x01) {
-        return nal[3] & 0x1f;
-    } else {
-        return nal[4] & 0x1f;
-    }
-}
-
 void H264TcpInputAdapter::worker_proc( ) {
-    uint8_t *buf;
     int retval;
-    size_t last_start = 0;
-    size_t bytes_in_buf = 0;
-    size_t buf_scanned = 0;
     struct pollfd pfd;
-
-    buf = new uint8_t[PARSE_BUF_SIZE];
+    uint8_t *dst;
+    size_t space;
 
     while (shutdown == 0) { 
         /* if the socket is disconnected, try to connect it */
@@ -230,6 +245,7 @@ void H264TcpInputAdapter::worker_proc( ) {
             }
 
             fprintf(stderr, "socket open (%s:%s)\n", _host.c_str(), _port.c_str());
+            reset_parser( );
         }
 
         /* poll the socket so we have a defined timeout on the read */
@@ -249,10 +265,8 @@ void H264TcpInputAdapter::worker_proc( ) {
         }
 
         /* fill the buffer from the socket */
-        retval = read(
-            sockfd, buf + bytes_in_buf, 
-            PARSE_BUF_SIZE - bytes_in_buf
-        );
+        dst = read_space(READ_SIZE, space);
+        retval = read(sockfd, dst, space);
 
         if (retval < 0) {
             perror("read");
@@ -266,75 +280,62 @@ void H264TcpInputAdapter::worker_proc( ) {
             continue;
         }
 
-        bytes_in_buf += retval;
-
-        /* scan stream_buf for NAL start sequence */
-        while (buf_scanned + 4 < bytes_in_buf) {
-            if (is_nal_start(&buf[buf_scanned])) {
-                /* 
-                 * last_start points at the most recent NAL.
-                 * If it's the right type we will decode the entire buffer.
-                 */
-                switch (nal_type(&buf[last_start])) {
-                case 5: /* I-slice, typically preceded by SPS and PPS */
-                case 1: /* P-slice */
-                    /* decode the entire buffer up to this point */
-                    decode_and_send(buf, buf_scanned);
-
-                    /* move any leftover data back to the start */
-                    memmove(buf, buf + buf_scanned, bytes_in_buf - buf_scanned);
-                    bytes_in_buf -= buf_scanned;
-                    buf_scanned = 0;
-
-                    break;
-                default:
-                    /* let other NAL types accumulate in the buffer */
-                    break;
-                }
-                last_start = buf_scanned;
-            }
+        commit_read(retval);
+    }
 
-            buf_scanned++;
-        }
+    au_pipe.done_writing( );
+}
+
+void H264TcpInputAdapter::access_unit(const uint8_t *data, size_t size) {
+    AVPacket *pkt;
 
+    /* the decoder wants padding after the data, so copy it out */
+    pkt = new AVPacket;
+    if (av_new_packet(pkt, size) != 0) {
+        delete pkt;
+        throw std::runtime_error("av_new_packet failed");
     }
+
+    memcpy(pkt->data, data, size);
+    au_pipe.put(pkt);
 }
 
 /* 
- * decode_and_send()
+ * decoder_proc()
  * 
- * Accept coded frames split up by the worker thread, decode them, and pass 
- * along to the user.
+ * Decode access units assembled by the worker thread, and pass 
+ * along the pictures to the user.
  */
-void H264TcpInputAdapter::decode_and_send(uint8_t *data, size_t size) {
+void H264TcpInputAdapter::decoder_proc( ) {
+    AVPacket *pkt;
+
+    try {
+        for (;;) {
+            pkt = au_pipe.get( );
+            decode_and_send(pkt);
+            av_free_packet(pkt);
+            delete pkt;
+        }
+    } catch (BrokenPipe &) {
+        /* receive thread has shut down */
+    }
+}
+
+void H264TcpInputAdapter::decode_and_send(AVPacket *pkt) {
     int retval;
     int got_picture;
     RawFrame *output;
 
-    pkt.data = data;
-    pkt.size = size;
-
-    retval = avcodec_decode_video2(codec_ctx, frame, &got_picture, &pkt);
+    retval = avcodec_decode_video2(codec_ctx, frame, &got_picture, pkt);
     if (retval < 0) {
         fprintf(stderr, "avcodec_decode_video2 failed\n");
         return;
     }
 
     if (got_picture) {
-        if (frame->format == AV_PIX_FMT_YUV420P) {
-            output = new RawFrame(
-                frame->width, frame->height, RawFrame::CbYCrY8422
-            );
-            output->pack->YCbCr8P420(
-                frame->data[0],
-                frame->data[1],
-                frame->data[2],
-                frame->linesize[0],
-                frame->linesize[1],
-                frame->linesize[2]
-            );
-            _out_pipe.put(output);
-        }
+        output = LavcRawFrame::from_avframe(frame);
+        av_frame_unref(frame);
+        _out_pipe.put(output);
     }
 }
 
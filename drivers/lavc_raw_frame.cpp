@@ -0,0 +1,94 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "lavc_raw_frame.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdexcept>
+
+LavcRawFrame::LavcRawFrame(const AVFrame *frame) 
+        : BorrowedRawFrame(RawFrame::CbYCrY8422) {
+    _frame = av_frame_clone(frame);
+    if (_frame == NULL) {
+        throw std::runtime_error("av_frame_clone failed");
+    }
+
+    borrow(_frame->data[0], _frame->width, _frame->height, 
+            _frame->linesize[0]);
+}
+
+LavcRawFrame::~LavcRawFrame( ) {
+    av_frame_free(&_frame);
+}
+
+RawFrame *LavcRawFrame::from_avframe(const AVFrame *frame) {
+    RawFrame *fr;
+
+    if (frame->format == AV_PIX_FMT_UYVY422) {
+        return new LavcRawFrame(frame);
+    }
+
+    fr = new RawFrame(frame->width, frame->height, RawFrame::CbYCrY8422);
+
+    switch (frame->format) {
+        case AV_PIX_FMT_YUVJ422P:
+        case AV_PIX_FMT_YUV422P:
+            fr->pack->YCbCr8P422(
+                frame->data[0], 
+                frame->data[1],
+                frame->data[2],
+                frame->linesize[0],
+                frame->linesize[1],
+                frame->linesize[2]
+            );
+            break;
+
+        case AV_PIX_FMT_YUV422P10LE:
+            fr->pack->YCbCr10P422(
+                (uint16_t *)frame->data[0],
+                (uint16_t *)frame->data[1],
+                (uint16_t *)frame->data[2],
+                frame->linesize[0] / 2,
+                frame->linesize[1] / 2,
+                frame->linesize[2] / 2
+            );
+            break;
+
+        case AV_PIX_FMT_YUVJ420P:
+        case AV_PIX_FMT_YUV420P:
+            fr->pack->YCbCr8P420(
+                frame->data[0],
+                frame->data[1],
+                frame->data[2],
+                frame->linesize[0],
+                frame->linesize[1],
+                frame->linesize[2]
+            );
+            break;
+
+        default:
+            fprintf(stderr, "LavcRawFrame doesn't know how "
+                "to handle AVPixelFormat %d\n", frame->format);
+            memset(fr->data( ), 128, fr->size( ));
+            break;
+    }
+
+    return fr;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _LAVC_RAW_FRAME_H
+#define _LAVC_RAW_FRAME_H
+
+#include "borrowed_raw_frame.h"
+
+extern "C" {
+    #include <libavcodec/avcodec.h>
+    /* ffmpeg headers have #define PixelFormat AVPixelFormat somewhere. */
+    #undef PixelFormat
+}
+
+/*
+ * A RawFrame sharing the picture in a decoded AVFrame, for when 
+ * libavcodec has already produced CbYCrY8422 (AV_PIX_FMT_UYVY422).
+ * It holds its own reference to the AVFrame's buffers until deleted,
+ * so the decoder can move on to the next frame. For that to be free,
+ * the codec context should have refcounted_frames set.
+ */
+class LavcRawFrame : public BorrowedRawFrame {
+    public:
+        LavcRawFrame(const AVFrame *frame);
+        virtual ~LavcRawFrame( );
+
+        /* 
+         * Wrap the AVFrame if it's already CbYCrY8422, 
+         * otherwise pack it into a new CbYCrY8422 RawFrame.
+         */
+        static RawFrame *from_avframe(const AVFrame *frame);
+
+    protected:
+        AVFrame *_frame;
+};
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "output_scheduler.h"
+
+OutputScheduler::OutputScheduler(unsigned int queue_size,
+        int64_t frame_duration, int64_t time_base,
+        unsigned int n_channels, unsigned int audio_rate) 
+        : queue(queue_size), audio_queue(4 * queue_size + 16) {
+
+    this->frame_duration = frame_duration;
+    this->time_base = time_base;
+    this->n_channels = n_channels;
+    this->audio_rate = audio_rate;
+
+    current = NULL;
+    next_slot = 0;
+
+    _frames_output = 0;
+    _underruns = 0;
+    _late_frames = 0;
+    _dropped_frames = 0;
+    _dropped_audio = 0;
+}
+
+OutputScheduler::~OutputScheduler( ) {
+    Entry e;
+    IOAudioPacket *audio;
+
+    while (queue.try_get(e)) {
+        free_entry(e);
+    }
+
+    while (audio_queue.try_get(audio)) {
+        delete audio;
+    }
+
+    delete current;
+}
+
+void OutputScheduler::put(RawFrame *video, IOAudioPacket *audio) {
+    Entry e;
+    e.video = video;
+    e.audio = audio;
+    queue.put(e);
+}
+
+bool OutputScheduler::try_put(RawFrame *video, IOAudioPacket *audio) {
+    Entry e;
+    e.video = video;
+    e.audio = audio;
+    return queue.try_put(e);
+}
+
+RawFrame *OutputScheduler::next_frame(int64_t now, int64_t &display_time) {
+    Entry e;
+
+    /* 
+     * If this slot's deadline has already passed (or is closer than one
+     * frame away), the output has repeated whatever it last showed in 
+     * the meantime. Skip the missed slots with silence so audio stays
+     * aligned, and drop as many queued frames (with their audio) so 
+     * latency does not grow.
+     */
+    if (now >= 0 && next_slot * frame_duration < now + frame_duration) {
+        int64_t target = (now + 2 * frame_duration - 1) / frame_duration;
+        while (next_slot < target) {
+            emit_silence( );
+            next_slot++;
+            _late_frames++;
+
+            if (queue.fill( ) > 1 && queue.try_get(e)) {
+                free_entry(e);
+                _dropped_frames++;
+            }
+        }
+    }
+
+    if (queue.try_get(e)) {
+        delete current;
+        current = e.video;
+        emit_audio(e.audio);
+    } else {
+        /* repeat the last frame, with silence to match */
+        if (current != NULL) {
+            _underruns++;
+        }
+        emit_silence( );
+    }
+
+    display_time = next_slot * frame_duration;
+    next_slot++;
+    _frames_output++;
+
+    return current;
+}
+
+IOAudioPacket *OutputScheduler::next_audio( ) {
+    IOAudioPacket *ret;
+
+    if (audio_queue.try_get(ret)) {
+        return ret;
+    } else {
+        return NULL;
+    }
+}
+
+void OutputScheduler::emit_audio(IOAudioPacket *audio) {
+    if (audio == NULL) {
+        emit_silence( );
+        return;
+    }
+
+    if (n_channels == 0) {
+        delete audio;
+        return;
+    }
+
+    if (audio->channels( ) != n_channels) {
+        IOAudioPacket *remapped = audio->change_channels(n_channels);
+        delete audio;
+        audio = remapped;
+    }
+
+    if (!audio_queue.try_put(audio)) {
+        /* 
+         * audio side is not keeping up at all; blocking here would
+         * stall the video clock, so drop and count it instead
+         */
+        delete audio;
+        _dropped_audio++;
+    }
+}
+
+void OutputScheduler::emit_silence( ) {
+    if (n_channels == 0) {
+        return;
+    }
+
+    IOAudioPacket *silence = new IOAudioPacket(
+        slot_samples(next_slot), n_channels
+    );
+    silence->zero( );
+    emit_audio(silence);
+}
+
+/* 
+ * Number of audio samples that belong to a slot. For fractional rates
+ * (e.g. 1601.6 samples per frame at 59.94i) this gives the usual 
+ * repeating cadence.
+ */
+size_t OutputScheduler::slot_samples(int64_t slot) {
+    int64_t per_slot = int64_t(audio_rate) * frame_duration;
+    return (slot + 1) * per_slot / time_base - slot * per_slot / time_base;
+}
+
+void OutputScheduler::free_entry(Entry &e) {
+    delete e.video;
+    delete e.audio;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _OPENREPLAY_OUTPUT_SCHEDULER_H
+#define _OPENREPLAY_OUTPUT_SCHEDULER_H
+
+#include "raw_frame.h"
+#include "packed_audio_packet.h"
+#include "spsc_queue.h"
+#include <stdint.h>
+#include <atomic>
+
+/*
+ * Keeps video and its audio together on their way to a clocked output.
+ *
+ * The producer (e.g. ReplayPlayout) put( )s each video frame along with
+ * the audio that belongs to it. The output driver calls next_frame( )
+ * once per output slot with its hardware clock. Every slot gets exactly 
+ * one frame's worth of audio: either the audio queued with the frame,
+ * or silence when the frame is repeated (underrun) or the slot was 
+ * missed (late). That keeps lip-sync without any after-the-fact fixups.
+ * Matched audio is picked up by the driver's audio callback through
+ * next_audio( ).
+ *
+ * put( ) may block; next_frame( ) and next_audio( ) never do.
+ */
+class OutputScheduler {
+    public:
+        /* 
+         * frame_duration and time_base as in the driver's clock,
+         * e.g. 1001/30000. n_channels = 0 disables audio.
+         */
+        OutputScheduler(unsigned int queue_size, 
+                int64_t frame_duration, int64_t time_base,
+                unsigned int n_channels, unsigned int audio_rate = 48000);
+        ~OutputScheduler( );
+
+        /* 
+         * Queue a frame for output, waiting while the queue is full. 
+         * Takes ownership of video and audio; audio may be NULL.
+         */
+        void put(RawFrame *video, IOAudioPacket *audio);
+        /* as put( ), but return false instead of waiting */
+        bool try_put(RawFrame *video, IOAudioPacket *audio);
+
+        /*
+         * Pick the frame for the next output slot. now is the output's
+         * current playback time in time_base units, or -1 if unknown
+         * (e.g. during preroll). Returns the frame to display, which 
+         * remains owned by the scheduler and stays valid until the next 
+         * call, or NULL if nothing has ever been queued. display_time
+         * is set to the time at which to schedule it.
+         */
+        RawFrame *next_frame(int64_t now, int64_t &display_time);
+
+        /* matched audio for slots already handed out, in order */
+        IOAudioPacket *next_audio( );
+
+        uint64_t frames_output( ) const { return _frames_output; }
+        uint64_t underruns( ) const { return _underruns; }
+        uint64_t late_frames( ) const { return _late_frames; }
+        uint64_t dropped_frames( ) const { return _dropped_frames; }
+        /* audio packets discarded because the audio callback fell behind */
+        uint64_t dropped_audio( ) const { return _dropped_audio; }
+        unsigned int queue_depth( ) const { return queue.fill( ); }
+
+    protected:
+        struct Entry {
+            RawFrame *video;
+            IOAudioPacket *audio;
+        };
+
+        void emit_audio(IOAudioPacket *audio);
+        void emit_silence( );
+        size_t slot_samples(int64_t slot);
+        void free_entry(Entry &e);
+
+        SpscQueue<Entry> queue;
+        SpscQueue<IOAudioPacket *> audio_queue;
+
+        RawFrame *current;
+        int64_t next_slot;
+        int64_t frame_duration, time_base;
+        unsigned int n_channels, audio_rate;
+
+        std::atomic<uint64_t> _frames_output;
+        std::atomic<uint64_t> _underruns;
+        std::atomic<uint64_t> _late_frames;
+        std::atomic<uint64_t> _dropped_frames;
+        std::atomic<uint64_t> _dropped_audio;
+};
+
+#endif
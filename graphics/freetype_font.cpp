@@ -19,6 +19,13 @@
 
 #include "freetype_font.h"
 #include <assert.h>
+#include <string.h>
+
+/* 
+ * Bounds the layout cache; once full it is simply emptied. Static 
+ * labels stay hot and ever-changing strings (timecode) can't pile up.
+ */
+#define MAX_CACHED_LAYOUTS 256
 
 FT_Library FreetypeFont::library = NULL;
 
@@ -38,6 +45,8 @@ FreetypeFont::FreetypeFont(const char *font_file, FT_Long index) {
 
     rb = gb = bb = ab = 0;
     rf = gf = bf = af = 255;
+
+    flush_caches( );
 }
 
 void FreetypeFont::set_size(unsigned int n_pixels) {
@@ -51,6 +60,7 @@ void FreetypeFont::set_size(unsigned int n_pixels) {
     FTCHK(FT_Set_Char_Size(face, 0, n_pixels * 64, 72, 72));
     _h = face->size->metrics.height / 64;
     _baseline = _h + face->size->metrics.descender / 64;
+    flush_caches( );
 }
 
 void FreetypeFont::set_fgcolor(int r, int g, int b, int a) {
@@ -67,46 +77,95 @@ void FreetypeFont::set_bgcolor(int r, int g, int b, int a) {
     ab = a;
 }
 
-RawFrame *FreetypeFont::render_string(const char *string) {
-    int x;
-    RawFrame *ret;
+void FreetypeFont::flush_caches( ) {
+    for (unsigned int i = 0; i < 256; i++) {
+        glyphs[i].loaded = false;
+    }
+    atlas.clear( );
+    layouts.clear( );
+}
+
+const FreetypeFont::Glyph &FreetypeFont::glyph(unsigned char c) {
+    Glyph &g = glyphs[c];
     FT_GlyphSlot slot = face->glyph;
-    FT_Bool use_kerning = FT_HAS_KERNING(face);
-    FT_UInt glyph_index, previous;
 
-    uint8_t *glyph_scanline;
+    if (g.loaded) {
+        return g;
+    }
+
+    g.index = FT_Get_Char_Index(face, c);
+    FTCHK(FT_Load_Glyph(face, g.index, FT_LOAD_RENDER));
 
-    x = 0;
-    previous = 0;
+    g.left = slot->bitmap_left;
+    g.top = slot->bitmap_top;
+    g.advance = slot->advance.x / 64;
+    g.width = slot->bitmap.width;
+    g.rows = slot->bitmap.rows;
+    g.offset = atlas.size( );
 
-    /* first compute the size of the resulting image */
-    const char *scan_ptr = string;
-    while (*scan_ptr != '\0') {
-        glyph_index = FT_Get_Char_Index(face, *scan_ptr);
-        scan_ptr++;
+    /* copy the coverage bitmap into the atlas, tightly packed */
+    atlas.resize(atlas.size( ) + g.width * g.rows);
+    for (unsigned int y = 0; y < g.rows; y++) {
+        memcpy(&atlas[g.offset + g.width * y], 
+                slot->bitmap.buffer + slot->bitmap.pitch * y, g.width);
+    }
 
-        if (use_kerning && previous != 0 && glyph_index != 0) {
+    g.loaded = true;
+    return g;
+}
+
+const FreetypeFont::Layout &FreetypeFont::layout(const char *string) {
+    std::map<std::string, Layout>::iterator it = layouts.find(string);
+    FT_Bool use_kerning = FT_HAS_KERNING(face);
+    FT_UInt previous = 0;
+    PlacedGlyph pg;
+    Layout l;
+    int x = 0;
+
+    if (it != layouts.end( )) {
+        return it->second;
+    }
+
+    for (const char *scan_ptr = string; *scan_ptr != '\0'; scan_ptr++) {
+        const Glyph &g = glyph(*scan_ptr);
+
+        if (use_kerning && previous != 0 && g.index != 0) {
             FT_Vector delta;
-            FT_Get_Kerning(face, previous, glyph_index, 
+            FT_Get_Kerning(face, previous, g.index, 
                     FT_KERNING_DEFAULT, &delta);
             x += delta.x / 64;
         }
 
-        FTCHK(FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT));
+        pg.x = x;
+        pg.glyph = &g;
+        l.glyphs.push_back(pg);
 
-        x += slot->advance.x / 64;
+        x += g.advance;
+        previous = g.index;
+    }
+
+    l.w = x;
 
-        previous = glyph_index;
+    if (layouts.size( ) >= MAX_CACHED_LAYOUTS) {
+        layouts.clear( );
     }
 
+    return layouts[string] = l;
+}
+
+int FreetypeFont::string_width(const char *string) {
+    return layout(string).w;
+}
+
+RawFrame *FreetypeFont::render_string(const char *string) {
+    const Layout &l = layout(string);
+    RawFrame *ret;
+    const uint8_t *glyph_scanline;
+    uint8_t *dest_scanline;
+
     /* initialize a raw frame */
-    ret = new RawFrame(x, _h, RawFrame::BGRAn8);
-    
-    /* second pass: draw it */
-    scan_ptr = string;
-    int xd = 0;
-    previous = 0;
-    uint8_t *dest_scanline = ret->data( );
+    ret = new RawFrame(l.w, _h, RawFrame::BGRAn8);
+    dest_scanline = ret->data( );
 
     for (unsigned int i = 0; i < ret->size( ); i += 4) {
         dest_scanline[i] = bb;
@@ -115,29 +174,22 @@ RawFrame *FreetypeFont::render_string(const char *string) {
         dest_scanline[i+3] = ab;
     }
 
-    while (*scan_ptr != '\0') {
-        glyph_index = FT_Get_Char_Index(face, *scan_ptr);
-        scan_ptr++;
-
-        if (use_kerning && previous != 0 && glyph_index != 0) {
-            FT_Vector delta;
-            FT_Get_Kerning(face, previous, glyph_index,
-                    FT_KERNING_DEFAULT, &delta);
-            xd += delta.x / 64;
-        }
-
-        FTCHK(FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER));
+    for (unsigned int i = 0; i < l.glyphs.size( ); i++) {
+        const Glyph &g = *l.glyphs[i].glyph;
+        int xd = l.glyphs[i].x + g.left;
+        int yd = _baseline - g.top;
 
-        //int yd = -(slot->bitmap_top);
-        int yd = _baseline - slot->bitmap_top;
-        for (unsigned int y = 0; y < slot->bitmap.rows && yd < _h; y++, yd++) {
+        for (unsigned int y = 0; y < g.rows && yd < _h; y++, yd++) {
             if (yd >= 0) {
-                glyph_scanline = ((uint8_t *)slot->bitmap.buffer) 
-                        + slot->bitmap.pitch * y;
+                glyph_scanline = coverage(g) + g.width * y;
                 dest_scanline = ret->scanline(yd) + 4*xd;
                 int xd2 = xd;
-                for (unsigned int x = 0; x < slot->bitmap.width && xd2 < ret->w( ); 
-                        x++, xd2++) {
+                for (unsigned int x = 0; x < g.width && xd2 < ret->w( ); 
+                        x++, xd2++, dest_scanline += 4) {
+
+                    if (xd2 < 0) {
+                        continue;
+                    }
 
                     dest_scanline[0] = (bf * glyph_scanline[x] 
                             + bb * (255 - glyph_scanline[x])) / 255;
@@ -147,18 +199,64 @@ RawFrame *FreetypeFont::render_string(const char *string) {
                             + rb * (255 - glyph_scanline[x])) / 255;
                     dest_scanline[3] = (af * glyph_scanline[x]
                             + ab * (255 - glyph_scanline[x])) / 255;
-                    dest_scanline += 4;
                 }
             }
         }
-
-        xd += slot->advance.x / 64;
-        previous = glyph_index;
     }
 
     return ret;
 }
 
+void FreetypeFont::draw_string(RawFrame *dst, int x, int y, 
+        const char *string) {
+    const Layout &l = layout(string);
+    const uint8_t fg[4] = { (uint8_t) bf, (uint8_t) gf, 
+            (uint8_t) rf, (uint8_t) af };
+    const uint8_t bg[4] = { (uint8_t) bb, (uint8_t) gb, 
+            (uint8_t) rb, (uint8_t) ab };
+
+    /* text box, clipped to the frame */
+    int bx0 = (x > 0) ? x : 0;
+    int by0 = (y > 0) ? y : 0;
+    int bx1 = (x + l.w < dst->w( )) ? x + l.w : dst->w( );
+    int by1 = (y + _h < dst->h( )) ? y + _h : dst->h( );
+
+    if (bx1 <= bx0 || by1 <= by0) {
+        return;
+    }
+
+    if (ab != 0) {
+        /* background: one row of full coverage, repeated (pitch 0) */
+        if (solid.size( ) < (size_t) l.w) {
+            solid.assign(l.w, 0xff);
+        }
+        dst->draw->coverage_blend(bx0, by0, &solid[0], 
+                bx1 - bx0, by1 - by0, 0, bg);
+    }
+
+    for (unsigned int i = 0; i < l.glyphs.size( ); i++) {
+        const Glyph &g = *l.glyphs[i].glyph;
+        int gx0 = x + l.glyphs[i].x + g.left;
+        int gy0 = y + _baseline - g.top;
+        int gx1 = gx0 + g.width;
+        int gy1 = gy0 + g.rows;
+
+        /* clip the glyph to the text box */
+        int cx0 = (gx0 > bx0) ? gx0 : bx0;
+        int cy0 = (gy0 > by0) ? gy0 : by0;
+        int cx1 = (gx1 < bx1) ? gx1 : bx1;
+        int cy1 = (gy1 < by1) ? gy1 : by1;
+
+        if (cx1 <= cx0 || cy1 <= cy0) {
+            continue;
+        }
+
+        dst->draw->coverage_blend(cx0, cy0, 
+                coverage(g) + g.width * (cy0 - gy0) + (cx0 - gx0),
+                cx1 - cx0, cy1 - cy0, g.width, fg);
+    }
+}
+
 void FreetypeFont::do_library_init( ) {
     FTCHK(FT_Init_FreeType(&library));
 }
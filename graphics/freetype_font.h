@@ -25,6 +25,9 @@
 #include FT_GLYPH_H
 #include "raw_frame.h"
 #include <stdexcept>
+#include <vector>
+#include <map>
+#include <string>
 
 class FreetypeError : public virtual std::exception {
     public:
@@ -40,7 +43,43 @@ class FreetypeFont {
         void set_fgcolor(int r, int g, int b, int a);
         void set_bgcolor(int r, int g, int b, int a); 
         RawFrame *render_string(const char *string);
+
+        /* 
+         * Draw string straight into dst (BGRAn8) with its top left 
+         * corner at x, y; clipped to the frame. Same result as keying
+         * render_string's output there, with no intermediate frame.
+         */
+        void draw_string(RawFrame *dst, int x, int y, const char *string);
+
+        /* size of the box render_string or draw_string would fill */
+        int string_width(const char *string);
+        int h( ) { return _h; }
+
     private:
+        /* a rendered glyph: metrics and its coverage bitmap in atlas */
+        struct Glyph {
+            bool loaded;
+            FT_UInt index;
+            int left, top, advance;
+            unsigned int width, rows;
+            size_t offset;
+        };
+
+        struct PlacedGlyph {
+            int x;
+            const Glyph *glyph;
+        };
+
+        struct Layout {
+            int w;
+            std::vector<PlacedGlyph> glyphs;
+        };
+
+        const Glyph &glyph(unsigned char c);
+        const Layout &layout(const char *string);
+        const uint8_t *coverage(const Glyph &g) { return &atlas[g.offset]; }
+        void flush_caches( );
+
         static void do_library_init( );
         static FT_Library library;
         FT_Face face;
@@ -48,6 +87,12 @@ class FreetypeFont {
 
         int rb, gb, bb, ab;
         int rf, gf, bf, af;
+
+        /* glyphs are loaded and rendered on first use at each size */
+        Glyph glyphs[256];
+        std::vector<uint8_t> atlas;
+        std::map<std::string, Layout> layouts;
+        std::vector<uint8_t> solid;
 };
 
 #endif
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "raster_cache.h"
+#include "rsvg_frame.h"
+#include "raw_frame_view.h"
+#include "posix_util.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <stdexcept>
+#include <vector>
+
+/*
+ * A read-only window onto a cached frame's pixels. Holds a reference
+ * so the pixels outlive eviction from the cache.
+ */
+class RasterCacheView : public RawFrameView {
+    public:
+        RasterCacheView(const ref<RawFrame> &frame, uint64_t id)
+                : RawFrameView(frame) {
+            _id = id;
+        }
+
+        uint64_t id( ) const { return _id; }
+
+    protected:
+        uint64_t _id;
+};
+
+/* 64-bit FNV-1a */
+static uint64_t hash_bytes(const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *) data;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
+
+static void read_file(const char *path, std::vector<char> &buf) {
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        throw POSIXError("open image file");
+    }
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw POSIXError("stat image file");
+    }
+
+    buf.resize(st.st_size);
+    if (st.st_size > 0 && read_all(fd, &buf[0], st.st_size) != 1) {
+        close(fd);
+        throw std::runtime_error("failed to read image file");
+    }
+
+    close(fd);
+}
+
+bool RasterCache::Key::operator<(const Key &other) const {
+    if (hash != other.hash) {
+        return hash < other.hash;
+    } else if (length != other.length) {
+        return length < other.length;
+    } else if (kind != other.kind) {
+        return kind < other.kind;
+    } else if (w != other.w) {
+        return w < other.w;
+    } else if (h != other.h) {
+        return h < other.h;
+    } else {
+        return dpi < other.dpi;
+    }
+}
+
+RasterCache::RasterCache( ) {
+    budget = 64 * 1024 * 1024;
+    _used = 0;
+    next_id = 1;
+    _hits = 0;
+    _misses = 0;
+}
+
+RasterCache &RasterCache::get( ) {
+    static RasterCache cache;
+    return cache;
+}
+
+RawFrame *RasterCache::svg(const char *data, size_t size, 
+        coord_t w, coord_t h, double dpi) {
+    Key key;
+    key.hash = hash_bytes(data, size);
+    key.length = size;
+    key.kind = SVG;
+    key.w = w;
+    key.h = h;
+    /* any dpi <= 0 means librsvg's default; give them all one key */
+    key.dpi = (dpi > 0.0) ? dpi : 0.0;
+
+    return lookup(key, data, size);
+}
+
+RawFrame *RasterCache::svg_file(const char *path) {
+    std::vector<char> buf;
+    read_file(path, buf);
+    return svg(buf.empty( ) ? "" : &buf[0], buf.size( ));
+}
+
+RawFrame *RasterCache::png(const void *data, size_t size) {
+    Key key;
+    key.hash = hash_bytes(data, size);
+    key.length = size;
+    key.kind = PNG;
+    key.w = 0;
+    key.h = 0;
+    key.dpi = 0;
+
+    return lookup(key, data, size);
+}
+
+RawFrame *RasterCache::image_file(const char *path) {
+    std::vector<char> buf;
+    const char *ext;
+    Key key;
+
+    if (strlen(path) < 4) {
+        throw std::runtime_error("no file extension?");
+    }
+
+    ext = path + strlen(path) - 4;
+    if (!strcasecmp(ext, ".png")) {
+        key.kind = PNG;
+    } else if (!strcasecmp(ext, ".tga")) {
+        key.kind = TGA;
+    } else {
+        throw std::runtime_error("unrecognized image format");
+    }
+
+    read_file(path, buf);
+
+    key.hash = hash_bytes(buf.data( ), buf.size( ));
+    key.length = buf.size( );
+    key.w = 0;
+    key.h = 0;
+    key.dpi = 0;
+
+    return lookup(key, buf.data( ), buf.size( ));
+}
+
+void RasterCache::set_budget(size_t bytes) {
+    MutexLock l(m);
+    budget = bytes;
+    evict( );
+}
+
+size_t RasterCache::used( ) {
+    MutexLock l(m);
+    return _used;
+}
+
+uint64_t RasterCache::id_of(RawFrame *frame) {
+    RasterCacheView *view = dynamic_cast<RasterCacheView *>(frame);
+    return (view != NULL) ? view->id( ) : 0;
+}
+
+RawFrame *RasterCache::lookup(const Key &key, const void *data, 
+        size_t size) {
+    std::map<Key, EntryList::iterator>::iterator it;
+
+    { MutexLock l(m);
+        it = index.find(key);
+        if (it != index.end( )) {
+            _hits++;
+            lru.splice(lru.begin( ), lru, it->second);
+            return new RasterCacheView(lru.front( ).frame, lru.front( ).id);
+        }
+        _misses++;
+    }
+
+    /* render without holding the lock; it can take a while */
+    ref<RawFrame> frame(render(key, data, size));
+
+    MutexLock l(m);
+    it = index.find(key);
+    if (it != index.end( )) {
+        /* someone else got there first */
+        lru.splice(lru.begin( ), lru, it->second);
+    } else {
+        Entry entry;
+        entry.key = key;
+        entry.id = next_id++;
+        entry.frame = frame;
+
+        lru.push_front(entry);
+        index[key] = lru.begin( );
+        _used += frame->size( );
+        evict( );
+    }
+
+    return new RasterCacheView(lru.front( ).frame, lru.front( ).id);
+}
+
+RawFrame *RasterCache::render(const Key &key, const void *data, 
+        size_t size) {
+    switch (key.kind) {
+        case SVG:
+            return RsvgFrame::render_svg((const char *) data, size, 
+                    key.w, key.h, key.dpi);
+        case PNG:
+            return RawFrame::from_png_data((void *) data, size);
+        case TGA:
+            return RawFrame::from_tga_data(data, size);
+        default:
+            throw std::runtime_error("RasterCache: unknown kind");
+    }
+}
+
+/* drop least recently used entries until within budget; keep the newest */
+void RasterCache::evict( ) {
+    while (_used > budget && lru.size( ) > 1) {
+        Entry &victim = lru.back( );
+        _used -= victim.frame->size( );
+        index.erase(victim.key);
+        lru.pop_back( );
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OPENREPLAY_RASTER_CACHE_H
+#define _OPENREPLAY_RASTER_CACHE_H
+
+#include "raw_frame.h"
+#include "ref.h"
+#include "mutex.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <map>
+
+/*
+ * Process-wide cache of rasterized graphics: rendered SVGs and decoded
+ * PNG/TGA images, keyed by a hash of the source bytes along with the 
+ * render size and DPI. Sending the same graphic again costs a hash and
+ * a lookup instead of a parse and render.
+ *
+ * The frames returned are views of the cached pixels. They must be 
+ * treated as read-only, but are otherwise ordinary RawFrames the caller
+ * deletes when done; the pixels live on while any view does, even if
+ * the entry is evicted. Past the memory budget (64 MB by default),
+ * the least recently used entries are dropped.
+ */
+class RasterCache {
+    public:
+        static RasterCache &get( );
+
+        /* dpi <= 0 leaves the DPI to librsvg */
+        RawFrame *svg(const char *data, size_t size, 
+                coord_t w = 0, coord_t h = 0, double dpi = 0.0);
+        RawFrame *svg_file(const char *path);
+        RawFrame *png(const void *data, size_t size);
+        RawFrame *image_file(const char *path);
+
+        void set_budget(size_t bytes);
+        size_t used( );
+        uint64_t hits( ) { return _hits; }
+        uint64_t misses( ) { return _misses; }
+
+        /* 
+         * Identifies the cached picture a view shows; views of the same
+         * entry return the same value. Zero for other frames.
+         */
+        static uint64_t id_of(RawFrame *frame);
+
+    protected:
+        RasterCache( );
+
+        enum kind_t { SVG, PNG, TGA };
+
+        struct Key {
+            uint64_t hash;
+            size_t length;
+            kind_t kind;
+            coord_t w, h;
+            double dpi;
+
+            bool operator<(const Key &other) const;
+        };
+
+        struct Entry {
+            Key key;
+            uint64_t id;
+            ref<RawFrame> frame;
+        };
+
+        typedef std::list<Entry> EntryList;
+
+        RawFrame *lookup(const Key &key, const void *data, size_t size);
+        RawFrame *render(const Key &key, const void *data, size_t size);
+        void evict( );
+
+        Mutex m;
+        EntryList lru;      /* most recently used first */
+        std::map<Key, EntryList::iterator> index;
+        size_t budget;
+        size_t _used;
+        uint64_t next_id;
+        uint64_t _hits, _misses;
+};
+
+#endif
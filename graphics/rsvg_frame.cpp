@@ -25,20 +25,29 @@
 
 static int rsvg_is_init = 0;
 
-static RawFrame *render_from_rsvg_handle(RsvgHandle *rsvg) {
+static RawFrame *render_from_rsvg_handle(RsvgHandle *rsvg, 
+        coord_t w = 0, coord_t h = 0) {
     RsvgDimensionData dim;
     CairoFrame *crf;
     cairo_t *cr;
     
     rsvg_handle_get_dimensions(rsvg, &dim);
 
-    crf = new CairoFrame(dim.width, dim.height);
+    if (w == 0 || h == 0 || dim.width == 0 || dim.height == 0) {
+        w = dim.width;
+        h = dim.height;
+    }
+
+    crf = new CairoFrame(w, h);
 
     /* clear to full transparency initially */
     memset(crf->data( ), 0, crf->size( ));
 
     /* render SVG */
     cr = crf->cairo_create( );
+    if ((int) w != dim.width || (int) h != dim.height) {
+        cairo_scale(cr, (double) w / dim.width, (double) h / dim.height);
+    }
     if (rsvg_handle_render_cairo(rsvg, cr) == FALSE) {
         cairo_destroy(cr);
         g_object_unref(rsvg);
@@ -62,6 +71,11 @@ static void rsvg_tryinit( ) {
 }
 
 RawFrame *RsvgFrame::render_svg(const char *svg_data, size_t size) {
+    return render_svg(svg_data, size, 0, 0, 0.0);
+}
+
+RawFrame *RsvgFrame::render_svg(const char *svg_data, size_t size,
+        coord_t w, coord_t h, double dpi) {
     GError *error = NULL;
     RsvgHandle *rsvg;
     
@@ -79,7 +93,10 @@ RawFrame *RsvgFrame::render_svg(const char *svg_data, size_t size) {
         throw std::runtime_error("rsvg_handle_new_from_data failed");
     }
 
-    return render_from_rsvg_handle(rsvg);
+    if (dpi > 0.0) {
+        rsvg_handle_set_dpi(rsvg, dpi);
+    }
+    return render_from_rsvg_handle(rsvg, w, h);
 }
 
 RawFrame *RsvgFrame::render_svg_file(const char *filename) {
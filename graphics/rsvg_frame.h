@@ -30,6 +30,13 @@ class RsvgFrame : public CairoFrame {
         static RawFrame *render_svg(const char *svg_data, size_t size);
         static RawFrame *render_svg_file(const char *filename);       
 
+        /* 
+         * Render at the given DPI (librsvg's default if dpi <= 0), 
+         * scaled to w x h (or the document's own size if either is zero).
+         */
+        static RawFrame *render_svg(const char *svg_data, size_t size,
+                coord_t w, coord_t h, double dpi);
+
 };
 
 #endif
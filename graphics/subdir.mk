@@ -1,6 +1,7 @@
 graphics_OBJECTS = \
 	graphics/cairo_frame.o \
 	graphics/rsvg_frame.o \
+	graphics/raster_cache.o \
     graphics/freetype_font.o
 
 EXTERNAL_INCLUDES += $(shell pkg-config librsvg-2.0 --cflags)
@@ -21,6 +21,8 @@
  */
 
 #include "shm_double_buffer.h"
+#include "futex.h"
+#include "memfd.h"
 #include "debug_fprintf.h"
 
 #include <unistd.h>
@@ -32,10 +34,6 @@
 #include <stdexcept>
 #include <cassert>
 
-static int memfd_create(const char *name, unsigned int flags) {
-	return syscall(SYS_memfd_create, name, flags);
-}
-
 ShmDoubleBuffer::ShmDoubleBuffer() {
 	fd = -1;
 	shared_state = NULL;
@@ -54,51 +52,44 @@ ShmDoubleBuffer::ShmDoubleBuffer(size_t object_size) {
 	init(object_size);
 }
 
-int ShmDoubleBuffer::try_flip() {
+int ShmDoubleBuffer::try_flip(uint32_t &gen) {
 	/* 
 	 * in the critical section, we determine which buffer to read, and
-	 * do a page flip if possible.
+	 * do a page flip if possible. If the producer is in the middle of
+	 * a write, the consumer buffer is still the latest complete one,
+	 * so there is no point in waiting around for the write to finish.
 	 */
 	int bufn;
-	bool flipped = false;
-	int tries = 0;
-	while (!flipped && tries < 10) {
-		lock( );
-		assert(
-			shared_state->producer_buf == 0 || 
-			shared_state->producer_buf == 1
-		);
-		if (shared_state->ok_to_flip) {
-			bufn = shared_state->producer_buf;
-			shared_state->producer_buf = 1 - bufn;
-			shared_state->ok_to_flip = false;
-			flipped = true;
-		} else {
-			bufn = 1 - shared_state->producer_buf;
-			flipped = false;
-		}
-		unlock( );
-
-		usleep(500);
-		tries++;
-	}
-	
-	if (tries > 1 && flipped) {
-		debug_fprintf(stderr, "took %d tries to flip\n", tries);
-	}
 
-	if (flipped == false) {
-		debug_fprintf(stderr, "Didn't flip\n");
+	lock( );
+	assert(
+		shared_state->producer_buf == 0 || 
+		shared_state->producer_buf == 1
+	);
+	if (shared_state->ok_to_flip) {
+		bufn = shared_state->producer_buf;
+		shared_state->producer_buf = 1 - bufn;
+		shared_state->ok_to_flip = false;
+		shared_state->consumer_generation = shared_state->generation;
+	} else {
+		bufn = 1 - shared_state->producer_buf;
 	}
+	gen = shared_state->consumer_generation;
+	unlock( );
 
 	return bufn;
 }
 
 void ShmDoubleBuffer::begin_read(const void *&buf) {
+	uint32_t gen;
+	begin_read(buf, gen);
+}
+
+void ShmDoubleBuffer::begin_read(const void *&buf, uint32_t &gen) {
 	assert(shared_state != NULL);
 	assert(fd != -1);
 	
-	int bufn = try_flip();
+	int bufn = try_flip(gen);
 
 	buf = buffers[bufn];
 	assert(buf != NULL);
@@ -133,7 +124,41 @@ void ShmDoubleBuffer::end_write() {
 	lock( );
 	assert(shared_state->ok_to_flip == false);
 	shared_state->ok_to_flip = true;
+	__atomic_add_fetch(&shared_state->generation, 1, __ATOMIC_RELEASE);
 	unlock( );
+
+	futex_wake(&shared_state->generation);
+}
+
+uint32_t ShmDoubleBuffer::generation() {
+	assert(shared_state != NULL);
+	return __atomic_load_n(&shared_state->generation, __ATOMIC_ACQUIRE);
+}
+
+bool ShmDoubleBuffer::wait_for_update(uint32_t last_gen, int timeout_ms) {
+	struct timespec timeout;
+
+	assert(shared_state != NULL);
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+	/* 
+	 * FUTEX_WAIT returns immediately if the generation already moved
+	 * on; spurious wakeups and signals just go round again (and may
+	 * stretch the timeout a little, which is harmless here)
+	 */
+	while (generation() == last_gen) {
+		if (futex_wait(&shared_state->generation, last_gen, &timeout) != 0) {
+			if (errno == ETIMEDOUT) {
+				return false;
+			} else if (errno != EAGAIN && errno != EINTR) {
+				perror("futex");
+				throw std::runtime_error("futex wait failed");
+			}
+		}
+	}
+
+	return true;
 }
 
 void ShmDoubleBuffer::lock() {
@@ -174,7 +199,7 @@ void ShmDoubleBuffer::init(size_t bufsize) {
 	n_pages_per_buffer = (bufsize / page_size) + 1;
 	n_bytes = (2 * n_pages_per_buffer + 1) * page_size;
 
-	fd = memfd_create("ShmDoubleBuffer", 0);
+	fd = sys_memfd_create("ShmDoubleBuffer", 0);
 	if (fd == -1) {
 		perror("memfd_create");
 		throw std::runtime_error("memfd_create failed");
@@ -192,6 +217,8 @@ void ShmDoubleBuffer::init(size_t bufsize) {
 	shared_state->ok_to_flip = false;
 	shared_state->producer_buf = 0;
 	shared_state->bufsize = bufsize;	
+	shared_state->generation = 0;
+	shared_state->consumer_generation = 0;
 	if (sem_init(&shared_state->sem, 1, 1) != 0) {
 		throw std::runtime_error("sem_init failed");
 	}
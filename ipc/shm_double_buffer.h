@@ -2,6 +2,7 @@
 #define _SHM_DOUBLE_BUFFER_H
 
 #include <cstddef>
+#include <stdint.h>
 #include <semaphore.h>
 
 /*
@@ -38,15 +39,34 @@ class ShmDoubleBuffer {
 
 		/* 
 		 * begin_read() flips the buffers (if possible) and 
-		 * always returns a readable buffer.
+		 * always returns a readable buffer. It never waits: if the
+		 * producer is mid-write, the last complete buffer is returned.
+		 * The buffer stays valid until the next begin_read(), so
+		 * it may be used in place rather than copied.
 		 */
 		void begin_read(const void *&buf);
+		/*
+		 * As above, also returning the generation of the data in buf. 
+		 * If it matches the last one seen, nothing has changed.
+		 */
+		void begin_read(const void *&buf, uint32_t &gen);
 		/*
 		 * The consumer must call end_read() when reading is
 		 * finished, though currently the function is a no-op.
 		 */
 		void end_read();
 
+		/*
+		 * Number of buffers the producer has finished writing.
+		 * Zero means nothing has been written yet.
+		 */
+		uint32_t generation();
+		/*
+		 * Sleep (on a futex) until generation() differs from last_gen
+		 * or timeout_ms elapses. Returns true if it changed.
+		 */
+		bool wait_for_update(uint32_t last_gen, int timeout_ms);
+
 		/* producer API */
 
 		/*
@@ -57,8 +77,9 @@ class ShmDoubleBuffer {
 		 */
 		void begin_write(void *&buf, bool &was_flipped);
 		/*
-		 * Unlock the buffer obtained by begin_write and signal
-		 * the consumer that it is now OK to flip pages.
+		 * Unlock the buffer obtained by begin_write, signal
+		 * the consumer that it is now OK to flip pages, and 
+		 * wake anyone in wait_for_update().
 		 */
 		void end_write();
 
@@ -81,6 +102,13 @@ class ShmDoubleBuffer {
 
 			/* immutable once the double buffer is created */
 			size_t bufsize;
+
+			/* 
+			 * bumped by end_write (also the futex word);
+			 * consumer_generation is what the consumer buffer holds
+			 */
+			uint32_t generation;
+			uint32_t consumer_generation;
 		} *shared_state;
 
 		void lock();
@@ -88,7 +116,7 @@ class ShmDoubleBuffer {
 		void init(size_t bufsize);
 		void map_state();
 		void map_buffers();
-		int try_flip();
+		int try_flip(uint32_t &gen);
 };
 
 #endif
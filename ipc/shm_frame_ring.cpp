@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2016 Andrew H. Armenia.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to 
+ * deal in the Software without restriction, including without limitation the 
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "shm_frame_ring.h"
+#include "futex.h"
+#include "memfd.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <stdexcept>
+#include <cassert>
+
+/*
+ * All shared fields are accessed with sequentially consistent atomics.
+ * The protocol relies on that ordering: the consumer announces the slot
+ * it is about to read, then checks it is still the latest; the producer
+ * publishes a new latest, then checks which slot the consumer holds 
+ * before choosing one to write. At least one of them sees the other.
+ */
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+
+ShmFrameRing::ShmFrameRing() {
+	fd = -1;
+	shared_state = NULL;
+	write_slot = -1;
+	read_slot = -1;
+	for (int i = 0; i < MAX_SLOTS; i++) {
+		buffers[i] = NULL;
+	}
+}
+
+ShmFrameRing::ShmFrameRing(size_t object_size, unsigned int n_slots) {
+	fd = -1;
+	shared_state = NULL;
+	write_slot = -1;
+	read_slot = -1;
+	for (int i = 0; i < MAX_SLOTS; i++) {
+		buffers[i] = NULL;
+	}
+
+	init(object_size, n_slots);
+}
+
+void ShmFrameRing::begin_write(void *&buf) {
+	int32_t latest, reading;
+	unsigned int n;
+
+	assert(shared_state != NULL);
+
+	if (write_slot == -1) {
+		n = shared_state->n_slots;
+		latest = LOAD(shared_state->latest);
+		reading = LOAD(shared_state->reading);
+
+		/* with three or more slots there is always one left over */
+		for (unsigned int i = 1; i <= n; i++) {
+			int32_t slot = (latest + i + n) % n;
+			if (slot != latest && slot != reading) {
+				write_slot = slot;
+				break;
+			}
+		}
+		assert(write_slot != -1);
+	}
+
+	buf = buffers[write_slot];
+	assert(buf != NULL);
+}
+
+void ShmFrameRing::publish(const ShmFrameInfo &info) {
+	struct timespec now;
+
+	assert(shared_state != NULL);
+	assert(write_slot != -1);
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	shared_state->info[write_slot] = info;
+	shared_state->info[write_slot].sequence = ++shared_state->sequence;
+	shared_state->info[write_slot].timestamp = 
+		(uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+
+	STORE(shared_state->latest, write_slot);
+	write_slot = -1;
+
+	__atomic_add_fetch(&shared_state->published, 1, __ATOMIC_SEQ_CST);
+	futex_wake(&shared_state->published);
+}
+
+bool ShmFrameRing::acquire(uint64_t last_seq, const void *&buf,
+		ShmFrameInfo &info) {
+	int32_t slot;
+
+	assert(shared_state != NULL);
+	assert(read_slot == -1);
+
+	for (;;) {
+		slot = LOAD(shared_state->latest);
+		if (slot == -1) {
+			return false;
+		}
+
+		/* 
+		 * claim it, then make sure the producer hadn't already 
+		 * moved on (and so might be writing to it) by then 
+		 */
+		STORE(shared_state->reading, slot);
+		if (LOAD(shared_state->latest) == slot) {
+			break;
+		}
+	}
+
+	read_slot = slot;
+	info = shared_state->info[slot];
+
+	if (info.sequence <= last_seq) {
+		release( );
+		return false;
+	}
+
+	buf = buffers[slot];
+	return true;
+}
+
+void ShmFrameRing::release() {
+	assert(shared_state != NULL);
+	STORE(shared_state->reading, -1);
+	read_slot = -1;
+}
+
+uint32_t ShmFrameRing::published() {
+	assert(shared_state != NULL);
+	return LOAD(shared_state->published);
+}
+
+bool ShmFrameRing::wait_for_publish(uint32_t last, int timeout_ms) {
+	struct timespec timeout;
+
+	assert(shared_state != NULL);
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+	while (published() == last) {
+		if (futex_wait(&shared_state->published, last, &timeout) != 0) {
+			if (errno == ETIMEDOUT) {
+				return false;
+			} else if (errno != EAGAIN && errno != EINTR) {
+				perror("futex");
+				throw std::runtime_error("futex wait failed");
+			}
+		}
+	}
+
+	return true;
+}
+
+void ShmFrameRing::init(size_t bufsize, unsigned int n_slots) {
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t n_pages_per_buffer;
+	size_t n_bytes;
+
+	assert(bufsize > 0);
+
+	if (n_slots < 3 || n_slots > MAX_SLOTS) {
+		throw std::runtime_error("ShmFrameRing: need 3 to 16 slots");
+	}
+
+	if (page_size < sizeof(struct state)) {
+		throw std::runtime_error("struct state doesn't fit one page");
+	}
+
+	n_pages_per_buffer = (bufsize + page_size - 1) / page_size;
+	n_bytes = (n_slots * n_pages_per_buffer + 1) * page_size;
+
+	fd = sys_memfd_create("ShmFrameRing", 0);
+	if (fd == -1) {
+		perror("memfd_create");
+		throw std::runtime_error("memfd_create failed");
+	}
+	
+	if (ftruncate(fd, n_bytes) != 0) {
+		perror("ftruncate");
+		throw std::runtime_error("ftruncate failed");
+	}
+
+	map_state( );
+
+	/* the file starts out zeroed, so only the non-zero fields remain */
+	shared_state->n_slots = n_slots;
+	shared_state->bufsize = bufsize;
+	shared_state->latest = -1;
+	shared_state->reading = -1;
+
+	map_buffers( );
+}
+
+void ShmFrameRing::init_from_fd(int nfd) {
+	if (fd != -1) {
+		throw std::runtime_error("tried to re-init ShmFrameRing");
+	}
+
+	fd = nfd;
+	map_state( );
+	map_buffers( );
+}
+
+void ShmFrameRing::map_state( ) {
+	assert(fd != -1);
+	assert(shared_state == NULL);
+
+	size_t page_size = sysconf(_SC_PAGESIZE);
+
+	void *ret = mmap(
+		NULL, page_size, PROT_READ | PROT_WRITE, 
+		MAP_SHARED, fd, 0
+	);
+
+	if (ret == MAP_FAILED) {
+		perror("mmap");
+		throw std::runtime_error("failed to map in shared state");
+	}
+
+	shared_state = (struct state *)ret;
+}
+
+void ShmFrameRing::map_buffers( ) {
+	assert(fd != -1);
+	assert(shared_state != NULL);
+
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t npages = (shared_state->bufsize + page_size - 1) / page_size;
+	size_t length = npages * page_size;
+	off_t start;
+
+	if (shared_state->n_slots < 3 || shared_state->n_slots > MAX_SLOTS) {
+		throw std::runtime_error("ShmFrameRing: bad slot count");
+	}
+
+	for (unsigned int i = 0; i < shared_state->n_slots; i++) {
+		start = (npages * i + 1) * page_size;
+		assert(buffers[i] == NULL);
+
+		buffers[i] = mmap(
+			NULL, length, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, start
+		);
+
+		if (buffers[i] == MAP_FAILED) {
+			perror("mmap");
+			buffers[i] = NULL;
+			throw std::runtime_error("failed to map in buffer");
+		}
+	}
+}
+
+int ShmFrameRing::get_fd() {
+	assert(fd != -1);
+	return fd;
+}
+
+unsigned int ShmFrameRing::n_slots() {
+	assert(shared_state != NULL);
+	return shared_state->n_slots;
+}
+
+size_t ShmFrameRing::slot_size() {
+	assert(shared_state != NULL);
+	return shared_state->bufsize;
+}
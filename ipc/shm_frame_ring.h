@@ -0,0 +1,119 @@
+#ifndef _SHM_FRAME_RING_H
+#define _SHM_FRAME_RING_H
+
+#include <cstddef>
+#include <stdint.h>
+
+/*
+ * Per-frame metadata published along with each buffer.
+ */
+struct ShmFrameInfo {
+	/* where the consumer should put the frame */
+	int32_t x, y;
+	uint8_t global_alpha;
+	uint8_t dirty_level;
+	uint16_t reserved;
+
+	/* 
+	 * what changed since the previously published frame; 
+	 * zero width and height means nothing did
+	 */
+	uint32_t damage_x, damage_y, damage_w, damage_h;
+
+	/* filled in by publish() */
+	uint64_t sequence;
+	uint64_t timestamp;	/* CLOCK_MONOTONIC, microseconds */
+};
+
+/*
+ * An N-buffer (N >= 3) shared memory ring.
+ *
+ * Like ShmDoubleBuffer, this passes frames from one producer process to 
+ * one consumer process, but neither side ever waits for the other. The
+ * producer always has a free slot to render into (one that is neither 
+ * the latest published frame nor held by the consumer), and the consumer
+ * always gets the latest published frame. Frames the consumer never
+ * got to are overwritten; it can tell from the sequence numbers.
+ *
+ * Slots are handed out in no particular order, so a slot's old contents
+ * are not the previous frame. Producers should redraw the whole frame;
+ * the damage rect only tells the consumer what differs from the last
+ * frame published.
+ */
+class ShmFrameRing {
+	public:
+		enum { MAX_SLOTS = 16 };
+
+		ShmFrameRing();
+		ShmFrameRing(size_t object_size, unsigned int n_slots = 3);
+
+		/* attach to an existing ring, as with ShmDoubleBuffer */
+		void init_from_fd(int fd);
+		int get_fd();
+
+		unsigned int n_slots();
+		size_t slot_size();
+
+		/* producer API */
+
+		/* 
+		 * Get a slot to render the next frame into. Never blocks. 
+		 * Calling it again before publish() returns the same slot.
+		 */
+		void begin_write(void *&buf);
+		/*
+		 * Make the slot from begin_write the latest frame, stamping 
+		 * it with the next sequence number and the current time.
+		 */
+		void publish(const ShmFrameInfo &info);
+
+		/* consumer API */
+
+		/*
+		 * If a frame newer than last_seq has been published, hold its 
+		 * slot and return its data and metadata. The slot is not 
+		 * reused until release(); the consumer may hold only one 
+		 * at a time. Returns false (holding nothing) otherwise.
+		 */
+		bool acquire(uint64_t last_seq, const void *&buf, 
+				ShmFrameInfo &info);
+		void release();
+
+		/* 
+		 * Number of frames published so far. wait_for_publish sleeps
+		 * on a futex until it differs from last or timeout_ms passes.
+		 */
+		uint32_t published();
+		bool wait_for_publish(uint32_t last, int timeout_ms);
+
+	private:
+		int fd;
+		void *buffers[MAX_SLOTS];
+
+		/* producer-side: slot being written, or -1 */
+		int write_slot;
+		/* consumer-side: slot held, or -1 */
+		int read_slot;
+
+		struct state {
+			/* immutable once the ring is created */
+			uint32_t n_slots;
+			size_t bufsize;
+
+			/* latest published slot (-1 if none) and consumer's slot */
+			int32_t latest;
+			int32_t reading;
+
+			/* publish count, also the futex word */
+			uint32_t published;
+			uint64_t sequence;
+
+			ShmFrameInfo info[MAX_SLOTS];
+		} *shared_state;
+
+		void init(size_t bufsize, unsigned int n_slots);
+		void map_state();
+		void map_buffers();
+};
+
+#endif
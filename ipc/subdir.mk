@@ -1,3 +1,3 @@
 ipc_OBJECTS = \
-	ipc/shm_double_buffer.o
-
+	ipc/shm_double_buffer.o \
+	ipc/shm_frame_ring.o
@@ -19,11 +19,13 @@
 
 #include "character_generator.h"
 
-CharacterGenerator::CharacterGenerator( ) : Thread( ), _output_pipe(2) { 
+CharacterGenerator::CharacterGenerator( ) : Thread( ), _position(0), 
+        _output_pipe(2) { 
     start_thread( );
 }
 
-CharacterGenerator::CharacterGenerator(int dummy) : Thread( ), _output_pipe(2) {
+CharacterGenerator::CharacterGenerator(int dummy) : Thread( ), 
+        _position(0), _output_pipe(2) {
     /* don't start the thread */
     UNUSED(dummy);
 }
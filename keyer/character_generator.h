@@ -23,7 +23,24 @@
 #include "types.h"
 #include "pipe.h"
 #include "thread.h"
-#include "raw_frame.h"
+#include "borrowed_raw_frame.h"
+
+#include <atomic>
+
+/*
+ * Sent by a CharacterGenerator in place of an overlay identical to
+ * the last one it sent. It has no pixels, only the global alpha, so 
+ * the keyer keeps using what it prepared from the last real overlay.
+ */
+class UnchangedOverlay : public BorrowedRawFrame {
+    public:
+        UnchangedOverlay(uint8_t galpha) 
+                : BorrowedRawFrame(RawFrame::BGRAn8) {
+            set_global_alpha(galpha);
+        }
+
+        static bool is_unchanged(RawFrame *f) { return f->w( ) == 0; }
+};
 
 /* 
  * Something that generates drawable overlay images.
@@ -34,18 +51,37 @@ class CharacterGenerator : public Thread {
         virtual ~CharacterGenerator( );
         Pipe<RawFrame *> &output_pipe( ) { return _output_pipe; }
 
-        coord_t x( ) { return _x; }
-        coord_t y( ) { return _y; }
-        void set_x(coord_t x) { _x = x; }
-        void set_y(coord_t y) { _y = y; }
-        void set_position(coord_t x, coord_t y) { _x = x; _y = y; }
+        /* 
+         * The position may be changed from another thread (or by the 
+         * CG's own) while the keyer reads it. x and y share one atomic
+         * word so the keyer never sees half of a move.
+         */
+        coord_t x( ) { return _position >> 16; }
+        coord_t y( ) { return _position & 0xffff; }
+        void set_position(coord_t x, coord_t y) { 
+            _position = pack_position(x, y); 
+        }
+        void set_x(coord_t x) {
+            uint32_t p = _position;
+            while (!_position.compare_exchange_weak(p, 
+                    pack_position(x, p & 0xffff))) { }
+        }
+        void set_y(coord_t y) {
+            uint32_t p = _position;
+            while (!_position.compare_exchange_weak(p, 
+                    pack_position(p >> 16, y))) { }
+        }
         virtual unsigned int dirty_level( ) { return 0; }
 
     protected:
         CharacterGenerator(int dummy); /* construct without starting thread */
         virtual void run_thread(void); /* override from Thread */
 
-        coord_t _x, _y; 
+        static uint32_t pack_position(coord_t x, coord_t y) {
+            return ((uint32_t) x << 16) | y;
+        }
+
+        std::atomic<uint32_t> _position;
         Pipe<RawFrame *> _output_pipe; 
 };
 
@@ -19,6 +19,7 @@
 
 #include "js_character_generator.h"
 #include "js_character_generator_script.h"
+#include "borrowed_raw_frame.h"
 
 #include <string.h>
 
@@ -27,6 +28,15 @@ JsCharacterGenerator::JsCharacterGenerator(const char *cmd)
 	_cmd = strdup(cmd);
 	recv_fd = -1;
 	script = NULL;
+
+	for (unsigned int i = 0; i < 2; i++) {
+		canvas[i] = new RawFrame(1920, 1080, RawFrame::BGRAn8);
+		memset(canvas[i]->data( ), 0, canvas[i]->size( ));
+		leased[i] = false;
+	}
+	current = 0;
+	full_redraw = false;
+
 	start_thread( );
 }
 
@@ -35,6 +45,9 @@ JsCharacterGenerator::~JsCharacterGenerator( ) {
 		delete script;
 	}
 
+	delete canvas[0];
+	delete canvas[1];
+
 	delete _cmd;
 	close(recv_fd);
 	/* FIXME: should wait for child here */
@@ -74,9 +87,61 @@ void JsCharacterGenerator::do_fork( ) {
     }
 }
 
+/*
+ * A BGRAn8 frame borrowing one of the canvases. Deleting it hands the
+ * canvas back to the generator.
+ */
+class JsCanvasFrame : public BorrowedRawFrame {
+	public:
+		JsCanvasFrame(JsCharacterGenerator *cg, unsigned int i, 
+				RawFrame *canvas) : BorrowedRawFrame(RawFrame::BGRAn8) {
+			_cg = cg;
+			_i = i;
+			/* read-only; nothing downstream writes into overlays */
+			borrow(canvas->data( ), canvas->w( ), canvas->h( ), 
+					canvas->pitch( ));
+		}
+
+		virtual ~JsCanvasFrame( ) {
+			_cg->release_canvas(_i);
+		}
+
+	protected:
+		JsCharacterGenerator *_cg;
+		unsigned int _i;
+};
+
+void JsCharacterGenerator::wait_canvas(unsigned int i) {
+	MutexLock l(lease_mutex);
+	while (leased[i]) {
+		lease_released.wait(lease_mutex);
+	}
+}
+
+void JsCharacterGenerator::release_canvas(unsigned int i) {
+	MutexLock l(lease_mutex);
+	leased[i] = false;
+	lease_released.signal( );
+}
+
+/* copy in whatever the canvas missed while the other one was in use */
+void JsCharacterGenerator::sync_canvas(unsigned int i) {
+	const Rect &r = stale[i];
+	RawFrame *src = canvas[1 - i];
+
+	for (coord_t y = r.y; y < r.y1( ); y++) {
+		memcpy(canvas[i]->pixel(r.x, y), src->pixel(r.x, y), 4 * r.w);
+	}
+
+	stale[i] = Rect( );
+}
+
 void JsCharacterGenerator::run_thread( ) {
 	RawFrame *frame;
 	struct pollfd pfd;
+	unsigned int next;
+	Rect damage;
+	bool changed;
 
 	/* fork server subprocess */
 	do_fork( );
@@ -95,15 +160,53 @@ void JsCharacterGenerator::run_thread( ) {
 			handle_input( );
 		}
 		
-		if (script != NULL) {
-			frame = script->render_frame( );
+		if (script == NULL) {
+			_output_pipe.put(NULL);
+			continue;
+		}
+
+		/* draw on the canvas the keyer isn't showing */
+		next = 1 - current;
+		wait_canvas(next);
+		sync_canvas(next);
+
+		changed = script->render_frame(canvas[next], damage);
+
+		if (full_redraw) {
+			/* the keyer still has the last script's overlay */
+			damage = Rect(0, 0, canvas[next]->w( ), canvas[next]->h( ));
+			changed = true;
+			full_redraw = false;
+		}
+
+		if (changed) {
+			stale[current].unite(damage);
+			current = next;
+
+			{ MutexLock l(lease_mutex);
+				leased[current] = true;
+			}
+
+			frame = new JsCanvasFrame(this, current, canvas[current]);
+			frame->set_damage(damage);
 			_output_pipe.put(frame);
 		} else {
-			_output_pipe.put(NULL);
+			_output_pipe.put(new UnchangedOverlay(0xff));
 		}
 	}
 }
 
+/* wipe both canvases for a new script */
+void JsCharacterGenerator::reset_canvases( ) {
+	for (unsigned int i = 0; i < 2; i++) {
+		wait_canvas(i);
+		memset(canvas[i]->data( ), 0, canvas[i]->size( ));
+		stale[i] = Rect( );
+	}
+
+	full_redraw = true;
+}
+
 unsigned int JsCharacterGenerator::dirty_level( ) {
 	if (script != NULL) {
 		return script->dirty_level( );
@@ -151,6 +254,7 @@ void JsCharacterGenerator::handle_input( ) {
 		}
 		fprintf(stderr, "JsCharacterGenerator: compiling script\n");
 		script = new JsCharacterGeneratorScript(data, size);
+		reset_canvases( );
 		break;
 	case 1:
 		/* message for script control */
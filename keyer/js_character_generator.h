@@ -18,20 +18,49 @@
  */
 
 #include "character_generator.h"
+#include "mutex.h"
+#include "condition.h"
+#include "rect.h"
 
 class JsCharacterGeneratorScript;
+
+/*
+ * Scripts draw into one of two persistent canvases, which are lent to
+ * the keyer as overlays (with the script's damage) instead of copied.
+ * Before a canvas is drawn on again, it is brought up to date from the
+ * other one by copying just the regions it missed. A render that 
+ * changes nothing sends an UnchangedOverlay.
+ *
+ * Renders are paced by the keyer: the output pipe holds only a couple
+ * of frames, and a canvas can't be reused until the keyer is done 
+ * with it.
+ */
 class JsCharacterGenerator : public CharacterGenerator {
 	public:
 		JsCharacterGenerator(const char *cmd);
 		~JsCharacterGenerator( );
 		unsigned int dirty_level( );
 
+		void release_canvas(unsigned int i);
+
 	protected:
 		void do_fork( );
 		void run_thread( );
 		void handle_input( );
+		void wait_canvas(unsigned int i);
+		void sync_canvas(unsigned int i);
+		void reset_canvases( );
 
 		JsCharacterGeneratorScript *script;
 		char *_cmd;
 		int recv_fd;
+
+		RawFrame *canvas[2];
+		Rect stale[2];		/* parts of each canvas that are out of date */
+		bool leased[2];
+		unsigned int current;	/* canvas with the latest render */
+		bool full_redraw;
+
+		Mutex lease_mutex;
+		Condition lease_released;
 };
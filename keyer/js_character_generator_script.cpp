@@ -20,6 +20,7 @@
 #include "js_character_generator_script.h"
 #include <string.h>
 #include "posix_util.h"
+#include "raster_cache.h"
 
 using namespace v8;
 
@@ -54,6 +55,24 @@ static void draw_callback(const v8::FunctionCallbackInfo<Value> &args) {
     }
 }
 
+static void clear_callback(const v8::FunctionCallbackInfo<Value> &args) {
+    JsCharacterGeneratorScript *script;
+    Local<External> data = Local<External>::Cast(args.Data( ));
+    script = (JsCharacterGeneratorScript *) data->Value( );
+
+    if (args.Length() == 4) {
+        script->clear(
+            args[0]->IntegerValue(),
+            args[1]->IntegerValue(),
+            args[2]->IntegerValue(),
+            args[3]->IntegerValue()
+        );
+    } else if (args.Length() == 0) {
+        /* whole canvas */
+        script->clear(0, 0, -1, -1);
+    }
+}
+
 static void check_isolate( ) {
     Isolate *isolate = Isolate::GetCurrent( );
     if (isolate == NULL) {
@@ -91,6 +110,15 @@ JsCharacterGeneratorScript::JsCharacterGeneratorScript(
         )
     );
 
+    global_template->Set(
+        String::NewFromUtf8(isolate, "clear"),
+        FunctionTemplate::New(
+            isolate,
+            clear_callback,
+            External::New(isolate, this)
+        )
+    );
+
     Handle<Context> context = Context::New(isolate, NULL, global_template);
     v8_context.Reset(isolate, context);
     Context::Scope ctxscope(context);
@@ -113,6 +141,12 @@ JsCharacterGeneratorScript::JsCharacterGeneratorScript(
     Handle<Object> object = Handle<Object>::Cast(script_result);
     v8_object.Reset(isolate, object);
 
+    retained = object->Get(
+        String::NewFromUtf8(isolate, "retained")
+    )->BooleanValue( );
+
+    current_frame = NULL;
+    pending_clear = false;
 }
 
 JsCharacterGeneratorScript::~JsCharacterGeneratorScript( ) {
@@ -126,7 +160,8 @@ JsCharacterGeneratorScript::~JsCharacterGeneratorScript( ) {
     v8_context.Reset( );
 }
 
-RawFrame *JsCharacterGeneratorScript::render_frame( ) {
+bool JsCharacterGeneratorScript::render_frame(RawFrame *canvas, 
+        Rect &damage_out) {
     Isolate *isolate = Isolate::GetCurrent( );
     HandleScope handle_scope(isolate);
 
@@ -134,9 +169,15 @@ RawFrame *JsCharacterGeneratorScript::render_frame( ) {
     Context::Scope ctxscope(context);
     TryCatch try_catch;
 
-    RawFrame *ret;
-    current_frame = new RawFrame(1920, 1080, RawFrame::BGRAn8);
-    memset(current_frame->data( ), 0, current_frame->size( ));
+    current_frame = canvas;
+    damage = Rect( );
+
+    /* 
+     * Non-retained scripts expect a clear canvas, but if they draw 
+     * nothing and return false, what's there is still current. So
+     * clear on the first draw, or after render( ) if it didn't draw.
+     */
+    pending_clear = !retained && !drawn.empty( );
 
     Local<Object> title_obj = Local<Object>::New(isolate, v8_object);
 
@@ -144,7 +185,7 @@ RawFrame *JsCharacterGeneratorScript::render_frame( ) {
         title_obj->Get(String::NewFromUtf8(isolate, "render"))
     );
 
-    render_func->Call(title_obj, 0, NULL);
+    Handle<Value> result = render_func->Call(title_obj, 0, NULL);
 
     if (try_catch.HasCaught( )) {
         fprintf(stderr, "caught javascript exception - what now?\n");
@@ -152,19 +193,36 @@ RawFrame *JsCharacterGeneratorScript::render_frame( ) {
         String::Utf8Value exception_str(exception);
         fprintf(stderr, "exception: %s\n", *exception_str);
 
+    } else if (pending_clear && !result->IsFalse( )) {
+        flush_clear( );
     }
 
-    ret = current_frame;
+    pending_clear = false;
     current_frame = NULL;
-    return ret; 
+
+    damage_out = damage;
+    return !damage.empty( );
 }
 
+void JsCharacterGeneratorScript::flush_clear( ) {
+    pending_clear = false;
+    clear(drawn.x, drawn.y, drawn.w, drawn.h);
+}
+
+/* note a change to the canvas; returns the part that is on it */
+Rect JsCharacterGeneratorScript::add_damage(coord_t x, coord_t y, 
+        coord_t w, coord_t h) {
+    Rect r(x, y, w, h);
+    r.intersect(Rect(0, 0, current_frame->w( ), current_frame->h( )));
+    damage.unite(r);
+    return r;
+}
 
 int JsCharacterGeneratorScript::load_asset(const char *path) {
     RawFrame *asset;
 
     try {
-        asset = RawFrame::from_image_file(path);
+        asset = RasterCache::get( ).image_file(path);
     } catch (...) {
         fprintf(stderr, "JsCharacterGeneratorScript: load %s failed\n", path);
         return (unsigned int) -1;
@@ -186,6 +244,15 @@ void JsCharacterGeneratorScript::draw(
         return;
     }
 
+    if (current_frame == NULL) {
+        /* only allowed from render( ) */
+        return;
+    }
+
+    if (pending_clear) {
+        flush_clear( );
+    }
+
     if (w == (coord_t) -1) {
         w = assets[asset_id]->w( );
     }
@@ -201,6 +268,36 @@ void JsCharacterGeneratorScript::draw(
         w, h, 
         galpha
     );
+
+    drawn.unite(add_damage(dest_x, dest_y, w, h));
+}
+
+void JsCharacterGeneratorScript::clear(
+    coord_t x, coord_t y, coord_t w, coord_t h
+) {
+    if (current_frame == NULL) {
+        return;
+    }
+
+    Rect r(x, y, w, h);
+    Rect all(0, 0, current_frame->w( ), current_frame->h( ));
+    r.intersect(all);
+    if (r.empty( )) {
+        return;
+    }
+
+    for (coord_t row = r.y; row < r.y1( ); row++) {
+        memset(current_frame->pixel(r.x, row), 0, 4 * r.w);
+    }
+
+    add_damage(r.x, r.y, r.w, r.h);
+
+    /* a clear covering everything drawn leaves an empty canvas */
+    Rect rest = drawn;
+    rest.intersect(r);
+    if (rest == drawn) {
+        drawn = Rect( );
+    }
 }
 
 
@@ -18,6 +18,7 @@
  */
 
 #include "raw_frame.h"
+#include "rect.h"
 
 #include <vector>
 #include <v8.h>
@@ -28,7 +29,13 @@ class JsCharacterGeneratorScript {
 		~JsCharacterGeneratorScript( );
 
 		unsigned int dirty_level( );
-		RawFrame *render_frame( );
+
+		/*
+		 * Run the script's render method against canvas, which holds
+		 * whatever was on screen after the last render. Returns false 
+		 * if nothing changed; otherwise damage covers the changes.
+		 */
+		bool render_frame(RawFrame *canvas, Rect &damage);
 		void send_message(const char *data, size_t size);
 
 		int load_asset(const char *path);
@@ -37,11 +44,24 @@ class JsCharacterGeneratorScript {
 			coord_t dest_x, coord_t dest_y, coord_t w, coord_t h,
 			uint8_t galpha
 		);
+		void clear(coord_t x, coord_t y, coord_t w, coord_t h);
 
 	protected:
+		Rect add_damage(coord_t x, coord_t y, coord_t w, coord_t h);
+		void flush_clear( );
+
 		RawFrame *current_frame;
 		std::vector<RawFrame *> assets;
 
+		/* 
+		 * Retained scripts draw incrementally and clear( ) for 
+		 * themselves. Others start every render from a clear canvas.
+		 */
+		bool retained;
+		Rect drawn;		/* extent of everything on the canvas */
+		Rect damage;	/* changed during the current render */
+		bool pending_clear;
+
 		v8::Persistent<v8::Context> v8_context;
 		v8::Persistent<v8::Script> v8_script;
 		v8::Persistent<v8::Object> v8_object;
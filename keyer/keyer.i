@@ -3,3 +3,4 @@
 %include "svg_subprocess_character_generator.i"
 %include "js_character_generator.i"
 %include "shm_character_generator.i"
+%include "shm_ring_character_generator.i"
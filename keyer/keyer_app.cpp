@@ -18,6 +18,7 @@
  */
 
 #include "keyer_app.h"
+#include "raw_frame_view.h"
 
 KeyerApp::KeyerApp( ) {
     iadp = NULL;
@@ -50,12 +51,16 @@ void KeyerApp::output(OutputAdapter *oadp_) {
 void KeyerApp::cg(CharacterGenerator *cg) {
     cgs.push_back(cg);
     flags.push_back(false);
+    prepared.push_back(PreparedKey( ));
 }
 
 void KeyerApp::run( ) {
-    RawFrame *frame = NULL;
+    ref<RawFrame> frame;
     RawFrame *cgout = NULL;
+    RawFrame *input;
+    RawFrame *out_video;
     IOAudioPacket *audio = NULL;
+    IOAudioPacket *out_audio;
 
     if (iadp == NULL) {
         throw std::runtime_error("cannot run with no input adapter");
@@ -75,10 +80,8 @@ void KeyerApp::run( ) {
         iadp->start( );
         for (;;) {
             /* get incoming frame */
-            frame = iadp->output_pipe( ).get( );
-            if (iadp->audio_output_pipe( ) != NULL) {
-                audio = iadp->audio_output_pipe( )->get( );
-            }
+            iadp->read_frame(input, audio);
+            frame.reset(input);
 
             clear_all_flags( ); /* we haven't keyed anything yet */
 
@@ -130,7 +133,27 @@ void KeyerApp::run( ) {
                      * If no overlay is being rendered by this CG right now, the CG
                      * will output a NULL frame. We can safely ignore those.
                      */
-                    if (cgout != NULL && cgout->global_alpha( ) != 0) {
+                    if (cgout == NULL) {
+                        /* next overlay can't be diffed against this one */
+                        prepared[i].invalidate( );
+                    } else if (UnchangedOverlay::is_unchanged(cgout)) {
+                        /* key what was prepared from the last overlay */
+                        if (cgout->global_alpha( ) != 0 
+                                && prepared[i].valid( )) {
+                            frame.make_writable( );
+                            frame->draw->alpha_key(cg->x( ), cg->y( ),
+                                    prepared[i], cgout->global_alpha( ));
+                        }
+                    } else if (cgout->pixel_format( ) == RawFrame::BGRAn8) {
+                        /* reconvert only what the CG says changed */
+                        prepared[i].update(cgout);
+                        if (cgout->global_alpha( ) != 0) {
+                            frame.make_writable( );
+                            frame->draw->alpha_key(cg->x( ), cg->y( ),
+                                    prepared[i], cgout->global_alpha( ));
+                        }
+                    } else if (cgout->global_alpha( ) != 0) {
+                        frame.make_writable( );
                         frame->draw->alpha_key(cg->x( ), cg->y( ), 
                                 cgout, cgout->global_alpha( ));
 
@@ -143,18 +166,31 @@ void KeyerApp::run( ) {
                     flags[i] = true;
                 }
 
-                /* Lastly, send output to the output adapter. */
-                oadps[j]->input_pipe( ).put(frame->convert->CbYCrY8422( ));
+                /* 
+                 * Lastly, send output to the output adapter. Outputs 
+                 * share the keyed frame until a later pass keys more 
+                 * onto it; make_writable( ) copies it then. The last 
+                 * output takes the audio, the others get copies.
+                 */
+                if (frame->pixel_format( ) == RawFrame::CbYCrY8422) {
+                    out_video = new RawFrameView(frame);
+                } else {
+                    out_video = frame->convert->CbYCrY8422( );
+                }
 
-                if (oadps[j]->audio_input_pipe( ) != NULL && audio != NULL) {
-                    oadps[j]->audio_input_pipe( )->put(audio->copy<int16_t>( ));
+                if (audio == NULL) {
+                    out_audio = NULL;
+                } else if (j + 1 == oadps.size( )) {
+                    out_audio = audio;
+                    audio = NULL;
+                } else {
+                    out_audio = audio->copy<int16_t>( );
                 }
-            }
 
-            delete frame;
-            if (audio != NULL) {
-                delete audio;
+                oadps[j]->write_frame(out_video, out_audio);
             }
+
+            frame.reset( );
         }
     } catch (BrokenPipe &) {
         fprintf(stderr, "Unexpected component shutdown\n");
@@ -20,6 +20,7 @@
 #include <vector>
 #include "adapter.h"
 #include "character_generator.h"
+#include "prepared_key.h"
 
 class KeyerApp {
     protected:
@@ -27,6 +28,11 @@ class KeyerApp {
         InputAdapter *iadp;
         std::vector<OutputAdapter *> oadps;
         std::vector<bool> flags;
+        /* 
+         * each CG's overlay converted for keying, kept up to date by 
+         * damage and reused as long as the CG reports no change
+         */
+        std::vector<PreparedKey> prepared;
 
         void clear_all_flags( );
     public:
@@ -18,7 +18,7 @@
  */
 
 #include "png_subprocess_character_generator.h"
-#include "raw_frame.h"
+#include "raster_cache.h"
 
 PngSubprocessCharacterGenerator::PngSubprocessCharacterGenerator(
     const char *cmd, unsigned int dirty_level
@@ -28,7 +28,7 @@ PngSubprocessCharacterGenerator::PngSubprocessCharacterGenerator(
 
 RawFrame *PngSubprocessCharacterGenerator::do_render(void *data, size_t size) {
     try {
-        return RawFrame::from_png_data(data, size);
+        return RasterCache::get( ).png(data, size);
     } catch(...) {
         fprintf(stderr, "PngSubprocessCharacterGenerator: "
             "failed to load PNG image from data!\n");
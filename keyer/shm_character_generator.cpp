@@ -53,22 +53,43 @@ void ShmCharacterGenerator::do_fork( ) {
 }
 
 void ShmCharacterGenerator::run_thread( ) {
-    RawFrame *frame;
     const void *data;
+    uint32_t gen;
+    uint32_t last_gen = 0;
 
     /* fork subprocess */
     do_fork( );
 
     for (;;) {
-        /* just copy frames from the shm_buf as fast as we can */
-        frame = new RawFrame(1920, 1080, RawFrame::BGRAn8);
-    
-        shm_buf.begin_read(data);
-        memcpy(frame->data(), data, frame->size());
-        shm_buf.end_read();
-        
-        _output_pipe.put(frame);
+        if (shm_buf.generation( ) == last_gen) {
+            if (last_gen == 0) {
+                /* 
+                 * nothing written yet: sleep until the producer gets 
+                 * going, but keep the keyer fed while we wait
+                 */
+                if (!shm_buf.wait_for_update(last_gen, 20)) {
+                    _output_pipe.put(NULL);
+                }
+            } else {
+                _output_pipe.put(new UnchangedOverlay(0xff));
+            }
+            continue;
+        }
 
+        /* the keyer may still be reading the buffer we'd flip away */
+        wait_lease( );
+
+        shm_buf.begin_read(data, gen);
+        shm_buf.end_read( );
+
+        if (gen == last_gen) {
+            /* producer was mid-write; what we have is still current */
+            _output_pipe.put(new UnchangedOverlay(0xff));
+            continue;
+        }
+
+        last_gen = gen;
+
+        _output_pipe.put(lend(data, 1920, 1080));
     }
 }
-
@@ -22,12 +22,19 @@
 
 #include "character_generator.h"
 #include "shm_double_buffer.h"
+#include "shm_lease.h"
 
 /* 
  * Overlay a frame buffer provided by another process via a double-buffered
  * shared memory area.
+ *
+ * New overlays are handed to the keyer as frames pointing straight into
+ * the mapped consumer buffer. Such a frame holds a read lease: the 
+ * buffers are not flipped again until it is deleted. While the producer's
+ * generation count is unchanged, UnchangedOverlay is sent instead.
  */
-class ShmCharacterGenerator : public CharacterGenerator {
+class ShmCharacterGenerator : public CharacterGenerator, 
+        protected ShmLease {
     public:
         ShmCharacterGenerator(const char *cmd, unsigned int dirty_level = 0);
         virtual ~ShmCharacterGenerator( );
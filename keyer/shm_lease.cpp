@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 Andrew H. Armenia.
+ * 
+ * This file is part of exacore.
+ * 
+ * exacore is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * exacore is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with exacore.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_lease.h"
+#include "borrowed_raw_frame.h"
+
+/* A BGRAn8 frame borrowing leased memory. Deleting it ends the lease. */
+class ShmLeaseFrame : public BorrowedRawFrame {
+    public:
+        ShmLeaseFrame(ShmLease *lease, const void *data, 
+                coord_t w, coord_t h) : BorrowedRawFrame(RawFrame::BGRAn8) {
+            _lease = lease;
+            /* read-only; nothing downstream writes into overlays */
+            borrow((void *) data, w, h, pixel_size( ) * w);
+        }
+
+        virtual ~ShmLeaseFrame( ) {
+            _lease->end( );
+        }
+
+    protected:
+        ShmLease *_lease;
+};
+
+ShmLease::ShmLease( ) {
+    held = false;
+}
+
+ShmLease::~ShmLease( ) {
+
+}
+
+void ShmLease::wait_lease( ) {
+    MutexLock l(mut);
+    while (held) {
+        released.wait(mut);
+    }
+}
+
+RawFrame *ShmLease::lend(const void *data, coord_t w, coord_t h) {
+    {
+        MutexLock l(mut);
+        held = true;
+    }
+
+    return new ShmLeaseFrame(this, data, w, h);
+}
+
+void ShmLease::end( ) {
+    MutexLock l(mut);
+    lease_ended( );
+    held = false;
+    released.signal( );
+}
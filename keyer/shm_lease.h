@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016 Andrew H. Armenia.
+ * 
+ * This file is part of exacore.
+ * 
+ * exacore is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * exacore is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with exacore.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _KEYDAEMON_SHM_LEASE_H
+#define _KEYDAEMON_SHM_LEASE_H
+
+#include "raw_frame.h"
+#include "mutex.h"
+#include "condition.h"
+
+/*
+ * The read lease a shared-memory CG holds while the keyer uses its 
+ * overlay. lend( ) hands out a BGRAn8 frame pointing straight into the
+ * shared buffer; the lease lasts until that frame is deleted. Only one
+ * frame is out at a time: call wait_lease( ) before lending the next.
+ */
+class ShmLease {
+    public:
+        ShmLease( );
+        virtual ~ShmLease( );
+
+        /* block until the frame lent last has been deleted */
+        void wait_lease( );
+
+        /* take the lease; the frame is read-only */
+        RawFrame *lend(const void *data, coord_t w, coord_t h);
+
+    protected:
+        /* called when the lease ends, before wait_lease( ) returns */
+        virtual void lease_ended( ) { }
+
+    private:
+        void end( );
+
+        Mutex mut;
+        Condition released;
+        bool held;
+
+        friend class ShmLeaseFrame;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2016 Andrew H. Armenia.
+ * 
+ * This file is part of exacore.
+ * 
+ * exacore is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * exacore is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with exacore.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_ring_character_generator.h"
+#include "posix_util.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+ShmRingCharacterGenerator::ShmRingCharacterGenerator(
+    const char *cmd, unsigned int n_slots
+) : CharacterGenerator(1), ring(8294400, n_slots) {
+    _cmd = strdup(cmd);
+    _dirty_level = 0;
+    _skipped = 0;
+    start_thread( );
+}
+
+ShmRingCharacterGenerator::~ShmRingCharacterGenerator( ) {
+    free(_cmd);
+}
+
+void ShmRingCharacterGenerator::do_fork( ) {
+    pid_t child;
+    child = fork( );
+
+    if (child == -1) {
+        throw std::runtime_error("fork failed");
+    } else if (child == 0) {
+        /* pass the child process the ring as fd 9 */
+        dup2(ring.get_fd( ), 9);
+        execl("/bin/sh", "/bin/sh", "-c", _cmd, (char *) NULL);
+
+        /* if we fall through the exec an error has occurred, so die */
+        perror("execlp");
+        exit(1);
+    } 
+}
+
+/* the keyer is done with the slot */
+void ShmRingCharacterGenerator::lease_ended( ) {
+    ring.release( );
+}
+
+void ShmRingCharacterGenerator::run_thread( ) {
+    const void *data;
+    ShmFrameInfo info;
+    RawFrame *frame;
+    uint32_t published = 0;
+    uint64_t last_seq = 0;
+    uint8_t galpha = 0xff;
+
+    /* fork subprocess */
+    do_fork( );
+
+    for (;;) {
+        if (ring.published( ) == published) {
+            if (last_seq == 0) {
+                /* nothing yet: sleep a little, but keep the keyer fed */
+                if (!ring.wait_for_publish(published, 20)) {
+                    _output_pipe.put(NULL);
+                }
+            } else {
+                _output_pipe.put(new UnchangedOverlay(galpha));
+            }
+            continue;
+        }
+
+        published = ring.published( );
+
+        /* one slot at a time: wait for the keyer to finish the last */
+        wait_lease( );
+
+        if (!ring.acquire(last_seq, data, info)) {
+            if (last_seq == 0) {
+                _output_pipe.put(NULL);
+            } else {
+                _output_pipe.put(new UnchangedOverlay(galpha));
+            }
+            continue;
+        }
+
+        frame = lend(data, 1920, 1080);
+
+        /* 
+         * damage is relative to the previous frame published; 
+         * if we missed any, all of it may have changed
+         */
+        if (info.sequence == last_seq + 1) {
+            Rect damage(info.damage_x, info.damage_y, 
+                    info.damage_w, info.damage_h);
+            damage.intersect(Rect(0, 0, frame->w( ), frame->h( )));
+            frame->set_damage(damage);
+        } else if (last_seq != 0) {
+            _skipped += info.sequence - last_seq - 1;
+        }
+
+        last_seq = info.sequence;
+        galpha = info.global_alpha;
+        _dirty_level = info.dirty_level;
+        set_position(info.x, info.y);
+
+        frame->set_global_alpha(galpha);
+        _output_pipe.put(frame);
+    }
+}
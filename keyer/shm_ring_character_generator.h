@@ -0,0 +1,57 @@
+/*
+ * Copyright 2016 Andrew H. Armenia.
+ * 
+ * This file is part of exacore.
+ * 
+ * exacore is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * exacore is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with exacore.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _KEYDAEMON_SHM_RING_CHARACTER_GENERATOR_H
+#define _KEYDAEMON_SHM_RING_CHARACTER_GENERATOR_H
+
+#include "character_generator.h"
+#include "shm_frame_ring.h"
+#include "shm_lease.h"
+
+#include <atomic>
+
+/* 
+ * Overlay frames rendered by another process into a ShmFrameRing
+ * (passed to it as fd 9). The producer never waits on the keyer: it
+ * publishes at its own rate and sets position, global alpha, dirty level
+ * and damage per frame. As with ShmCharacterGenerator, frames point 
+ * straight into shared memory and hold their slot until deleted.
+ */
+class ShmRingCharacterGenerator : public CharacterGenerator, 
+        protected ShmLease {
+    public:
+        ShmRingCharacterGenerator(const char *cmd, unsigned int n_slots = 3);
+        virtual ~ShmRingCharacterGenerator( );
+        unsigned int dirty_level( ) { return _dirty_level; }
+
+        /* frames published that were never keyed */
+        uint64_t skipped( ) { return _skipped; }
+    protected:
+        virtual void run_thread( );
+        void do_fork( );
+
+        void lease_ended( );
+
+        char *_cmd;
+        std::atomic<unsigned int> _dirty_level;
+        std::atomic<uint64_t> _skipped;
+        ShmFrameRing ring;
+};
+
+#endif
@@ -5,7 +5,9 @@ keyer_OBJECTS = \
 	keyer/svg_subprocess_character_generator.o \
 	keyer/js_character_generator.o \
 	keyer/js_character_generator_script.o \
-	keyer/shm_character_generator.o
+	keyer/shm_lease.o \
+	keyer/shm_character_generator.o \
+	keyer/shm_ring_character_generator.o
 
 keyer_LIBS = -lv8
 
@@ -19,6 +19,7 @@
 
 #include "subprocess_character_generator.h"
 #include "posix_util.h"
+#include "raster_cache.h"
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
@@ -125,8 +126,13 @@ void SubprocessCharacterGenerator::run_thread( ) {
     size_t size;
     uint8_t alpha;
     char *data;
+    uint64_t id, last_id = 0;
 
-    RawFrame *cache_frame = NULL;
+    /* 
+     * the keyer holds on to the last overlay we sent, 
+     * so we only need to remember whether there was one
+     */
+    bool have_frame = false;
     
     /* fork subprocess */
     do_fork( );
@@ -145,26 +151,34 @@ void SubprocessCharacterGenerator::run_thread( ) {
 
             /* render SVG to frame */
             frame = do_render(data, size);
-            if (cache_frame != NULL) {
-                delete cache_frame;
-            }
-            if (frame != NULL) {
-                frame->set_global_alpha(alpha);
-                free(data);
-
-                /* update cache */
-                cache_frame = frame->copy( );
+            free(data);
 
-                /* put frame down the pipe */
-                _output_pipe.put(frame);
-            } else {
-                cache_frame = NULL;
+            if (frame == NULL) {
+                have_frame = false;
                 _output_pipe.put(NULL);
+                continue;
+            }
+
+            /* 
+             * a cached render of the same graphic we sent last time:
+             * let the keyer reuse the key it already prepared
+             */
+            id = RasterCache::id_of(frame);
+            if (have_frame && id != 0 && id == last_id) {
+                delete frame;
+                _output_pipe.put(new UnchangedOverlay(alpha));
+                continue;
             }
-        } else if (cache_frame != NULL) {
-            frame = cache_frame->copy( );
+
             frame->set_global_alpha(alpha);
+            have_frame = true;
+            last_id = id;
+
+            /* put frame down the pipe */
             _output_pipe.put(frame);
+        } else if (have_frame) {
+            /* same picture as last time */
+            _output_pipe.put(new UnchangedOverlay(alpha));
         } else {
             _output_pipe.put(NULL);
         }
@@ -18,7 +18,7 @@
  */
 
 #include "svg_subprocess_character_generator.h"
-#include "rsvg_frame.h"
+#include "raster_cache.h"
 
 SvgSubprocessCharacterGenerator::SvgSubprocessCharacterGenerator(
     const char *cmd, unsigned int dirty_level
@@ -27,6 +27,6 @@ SvgSubprocessCharacterGenerator::SvgSubprocessCharacterGenerator(
 }
 
 RawFrame *SvgSubprocessCharacterGenerator::do_render(void *data, size_t size) {
-    return RsvgFrame::render_svg((const char *)data, size);
+    return RasterCache::get( ).svg((const char *)data, size);
 }
 
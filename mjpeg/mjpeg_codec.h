@@ -77,4 +77,17 @@ class Mjpeg422Decoder {
 
         std::string comment;
 };
+
+/*
+ * Cheap check of an incoming JPEG, without starting up libjpeg: walks
+ * the markers up to the frame header and verifies that this is an 
+ * 8-bit, 3-component 4:2:2 image that Mjpeg422Decoder can handle. 
+ * Fills in the image size and returns true if so.
+ */
+struct Mjpeg422Header {
+    coord_t w, h;
+};
+
+bool mjpeg_parse_422_header(const void *data, size_t size, 
+        Mjpeg422Header &hdr);
 #endif
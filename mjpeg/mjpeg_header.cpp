@@ -0,0 +1,98 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mjpeg_codec.h"
+#include <stdint.h>
+
+static inline unsigned int be16(const uint8_t *p) {
+    return (p[0] << 8) | p[1];
+}
+
+bool mjpeg_parse_422_header(const void *data, size_t size, 
+        Mjpeg422Header &hdr) {
+    const uint8_t *p = (const uint8_t *) data;
+    const uint8_t *end = p + size;
+    const uint8_t *seg;
+    unsigned int marker, len;
+
+    if (size < 4 || p[0] != 0xff || p[1] != 0xd8) {
+        return false;
+    }
+    p += 2;
+
+    for (;;) {
+        /* markers may be preceded by any number of 0xff fill bytes */
+        if (p >= end || *p != 0xff) {
+            return false;
+        }
+        while (p < end && *p == 0xff) {
+            p++;
+        }
+        if (p >= end) {
+            return false;
+        }
+        marker = *p++;
+
+        /* standalone markers (TEM, RSTn) carry no length */
+        if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) {
+            continue;
+        }
+
+        /* image data or end of image before any frame header */
+        if (marker == 0xd9 || marker == 0xda) {
+            return false;
+        }
+
+        if (end - p < 2) {
+            return false;
+        }
+        len = be16(p);
+        if (len < 2 || (size_t)(end - p) < len) {
+            return false;
+        }
+        seg = p + 2;
+        p += len;
+
+        /* SOF0-2: baseline, extended and progressive Huffman */
+        if (marker >= 0xc0 && marker <= 0xc2) {
+            break;
+        } else if (marker >= 0xc3 && marker <= 0xcf 
+                && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            /* lossless, hierarchical or arithmetic: not for us */
+            return false;
+        }
+    }
+
+    /* precision, height, width, component count, then 3 bytes each */
+    if (len < 2 + 6 + 3 * 3 || seg[0] != 8 || seg[5] != 3) {
+        return false;
+    }
+
+    /* Y is 2x1, Cb and Cr are 1x1 */
+    if (seg[6 + 1] != 0x21 || seg[9 + 1] != 0x11 || seg[12 + 1] != 0x11) {
+        return false;
+    }
+
+    hdr.h = be16(seg + 1);
+    hdr.w = be16(seg + 3);
+
+    /* a zero height would be defined later by a DNL marker; not here */
+    return hdr.w > 0 && hdr.h > 0;
+}
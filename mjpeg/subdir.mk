@@ -2,5 +2,6 @@ mjpeg_OBJECTS = \
 	mjpeg/libjpeg_glue.o \
 	mjpeg/mjpeg_encode.o \
     mjpeg/mjpeg_decode.o \
+    mjpeg/mjpeg_header.o \
 
 mjpeg_LIBS = -ljpeg
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "borrowed_raw_frame.h"
+
+BorrowedRawFrame::BorrowedRawFrame(PixelFormat pf) : RawFrame(pf) {
+    n_frames++; /* balances free_data( ) */
+    _w = 0;
+    _h = 0;
+    _pitch = 0;
+    _data = NULL;
+}
+
+BorrowedRawFrame::~BorrowedRawFrame( ) {
+    /* keep ~RawFrame from free( )ing what isn't ours */
+    _data = NULL;
+}
+
+void BorrowedRawFrame::borrow(void *data, coord_t w, coord_t h, 
+        size_t pitch) {
+    _data = (uint8_t *) data;
+    _w = w;
+    _h = h;
+    _pitch = pitch;
+}
+
+void BorrowedRawFrame::alloc( ) {
+    throw std::runtime_error("Cannot allocate a borrowed RawFrame");
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OPENREPLAY_BORROWED_RAW_FRAME_H
+#define _OPENREPLAY_BORROWED_RAW_FRAME_H
+
+#include "raw_frame.h"
+
+/*
+ * A RawFrame whose pixels belong to something else: a decoder, a 
+ * shared memory segment, a buffer pool or another frame. The pixels 
+ * are never allocated or freed by the frame itself.
+ *
+ * The release hook is the subclass destructor. It runs before this 
+ * one, while data( ) is still valid, and gives the pixels back to 
+ * their owner (drops a reference, ends a lease, returns a buffer).
+ */
+class BorrowedRawFrame : public RawFrame {
+    public:
+        virtual ~BorrowedRawFrame( );
+
+    protected:
+        BorrowedRawFrame(PixelFormat pf);
+
+        /* show data as this frame's pixels; NULL borrows nothing */
+        void borrow(void *data, coord_t w, coord_t h, size_t pitch);
+
+        virtual void alloc( );
+};
+
+#endif
@@ -0,0 +1,71 @@
+; Copyright 2013 Exavideo LLC.
+; 
+; This file is part of openreplay.
+; 
+; openreplay is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+; 
+; openreplay is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+; 
+; You should have received a copy of the GNU General Public License
+; along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+
+
+; vim:syntax=nasm64
+
+bits 64
+
+section text align=16
+global YCbCr10P422_CbYCrY8422_line_sse2
+
+YCbCr10P422_CbYCrY8422_line_sse2:
+    ; rdi = number of pixels (multiple of 16)
+    ; rsi = source Y (10 bits in 16-bit words)
+    ; rdx = source Cb
+    ; rcx = source Cr
+    ; r8  = CbYCrY8422 destination
+    ; none of the pointers need to be aligned
+
+    test        rdi, rdi
+    jz          .done
+
+.loop:
+    ; reduce to 8 bits. 1023 >> 2 fits in a byte so packuswb is exact.
+    movdqu      xmm0, [rsi]         ; xmm0 = [y y y y y y y y ]
+    movdqu      xmm4, [rsi+16]      ; xmm4 = [y y y y y y y y ]
+    psrlw       xmm0, 2
+    psrlw       xmm4, 2
+    packuswb    xmm0, xmm4          ; xmm0 = [yyyyyyyyyyyyyyyy]
+
+    movdqu      xmm1, [rdx]         ; xmm1 = [u u u u u u u u ]
+    psrlw       xmm1, 2
+    packuswb    xmm1, xmm1          ; xmm1 = [uuuuuuuu........]
+
+    movdqu      xmm2, [rcx]         ; xmm2 = [v v v v v v v v ]
+    psrlw       xmm2, 2
+    packuswb    xmm2, xmm2          ; xmm2 = [vvvvvvvv........]
+
+    punpcklbw   xmm1, xmm2          ; xmm1 = [uvuvuvuvuvuvuvuv]
+    movdqa      xmm3, xmm1
+    punpcklbw   xmm1, xmm0          ; xmm1 = [uyvyuyvyuyvyuyvy] (pixels 0-7)
+    punpckhbw   xmm3, xmm0          ; xmm3 = [uyvyuyvyuyvyuyvy] (pixels 8-15)
+
+    movdqu      [r8], xmm1
+    movdqu      [r8+16], xmm3
+
+    add         rsi, 32
+    add         rdx, 16
+    add         rcx, 16
+    add         r8, 32
+    sub         rdi, 16
+    jg          .loop
+
+.done:
+    ret
+
+; vim:syntax=nasm64
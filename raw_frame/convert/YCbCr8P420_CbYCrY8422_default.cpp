@@ -28,7 +28,7 @@ void YCbCr8P420_CbYCrY8422_A_default(
     uint8_t *sY, *sCb, *sCr;
     unsigned int i;
 
-    while (h-- > 0) {
+    for (size_t line = 0; line < h; line++) {
         sY = Y;
         sCb = Cb;
         sCr = Cr;
@@ -42,7 +42,7 @@ void YCbCr8P420_CbYCrY8422_A_default(
 
         Y += Ypitch;
         /* move Cb and Cr to next line only every other output line */
-        if (h & 0x01) {
+        if (line & 0x01) {
             Cb += Cbpitch;
             Cr += Crpitch;
         }
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Planar YCbCr to CbYCrY8422 packers. The assembly kernels do 16 pixels
+ * at a time along a scanline; any leftover pixels at the end of a line
+ * are done here.
+ */
+
+extern "C" void YCbCr8P422_CbYCrY8422_line_sse2(size_t n, 
+        uint8_t *Y, uint8_t *Cb, uint8_t *Cr, uint8_t *dst);
+
+extern "C" void YCbCr10P422_CbYCrY8422_line_sse2(size_t n,
+        uint16_t *Y, uint16_t *Cb, uint16_t *Cr, uint8_t *dst);
+
+template <typename T, int shift>
+static void pack_tail(size_t start, size_t w, 
+        T *Y, T *Cb, T *Cr, uint8_t *dst) {
+    for (size_t i = start; i < w; i += 2) {
+        dst[2*i] = Cb[i/2] >> shift;
+        dst[2*i + 1] = Y[i] >> shift;
+        dst[2*i + 2] = Cr[i/2] >> shift;
+        dst[2*i + 3] = Y[i + 1] >> shift;
+    }
+}
+
+void YCbCr8P422_CbYCrY8422_A_sse2(
+    size_t w, size_t h, 
+    size_t Ypitch, size_t Cbpitch, size_t Crpitch,
+    uint8_t *Y, uint8_t *Cb, uint8_t *Cr,
+    uint8_t *dst
+) {
+    size_t vw = w & ~15;
+
+    for (size_t line = 0; line < h; line++) {
+        YCbCr8P422_CbYCrY8422_line_sse2(vw, Y, Cb, Cr, dst);
+        pack_tail<uint8_t, 0>(vw, w, Y, Cb, Cr, dst);
+
+        Y += Ypitch;
+        Cb += Cbpitch;
+        Cr += Crpitch;
+        dst += 2*w;
+    }
+}
+
+void YCbCr10P422_CbYCrY8422_A_sse2(
+    size_t w, size_t h, 
+    size_t Ypitch, size_t Cbpitch, size_t Crpitch,
+    uint16_t *Y, uint16_t *Cb, uint16_t *Cr,
+    uint8_t *dst
+) {
+    size_t vw = w & ~15;
+
+    for (size_t line = 0; line < h; line++) {
+        YCbCr10P422_CbYCrY8422_line_sse2(vw, Y, Cb, Cr, dst);
+        pack_tail<uint16_t, 2>(vw, w, Y, Cb, Cr, dst);
+
+        Y += Ypitch;
+        Cb += Cbpitch;
+        Cr += Crpitch;
+        dst += 2*w;
+    }
+}
+
+void YCbCr8P420_CbYCrY8422_A_sse2(
+    size_t w, size_t h,
+    size_t Ypitch, size_t Cbpitch, size_t Crpitch,
+    uint8_t *Y, uint8_t *Cb, uint8_t *Cr, uint8_t *dst
+) {
+    size_t vw = w & ~15;
+
+    for (size_t line = 0; line < h; line++) {
+        /* each chroma line serves two output lines */
+        YCbCr8P422_CbYCrY8422_line_sse2(vw, Y, Cb, Cr, dst);
+        pack_tail<uint8_t, 0>(vw, w, Y, Cb, Cr, dst);
+
+        Y += Ypitch;
+        if (line & 0x01) {
+            Cb += Cbpitch;
+            Cr += Crpitch;
+        }
+        dst += 2*w;
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "raw_frame.h"
+
+/*
+ * Blend a solid color into a BGRAn8 frame through an 8-bit coverage
+ * mask (e.g. an antialiased glyph). The color's alpha scales the 
+ * coverage; the destination alpha is composited "over".
+ */
+
+typedef void (*blend_row_fn)(uint8_t *dp, const uint8_t *cp, 
+        coord_t n, const uint8_t *bgra);
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+extern "C" void BGRAn8_coverage_blend_chunk_sse2(uint8_t *dst, 
+        const uint8_t *coverage, uint64_t n_pixels, uint64_t color, 
+        uint64_t alpha);
+#endif
+
+/* x / 255, rounded, for x <= 255 * 255 */
+static inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static void blend_row_default(uint8_t *dp, const uint8_t *cp, 
+        coord_t n, const uint8_t *bgra) {
+    uint32_t a, ia;
+
+    for (coord_t i = 0; i < n; i++, dp += 4) {
+        if (cp[i] == 0) {
+            continue;
+        }
+
+        a = div255(cp[i] * bgra[3]);
+        ia = 255 - a;
+
+        dp[0] = div255(dp[0] * ia + bgra[0] * a);
+        dp[1] = div255(dp[1] * ia + bgra[1] * a);
+        dp[2] = div255(dp[2] * ia + bgra[2] * a);
+        dp[3] = div255(dp[3] * ia + 255 * a);
+    }
+}
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+static void blend_row_sse2(uint8_t *dp, const uint8_t *cp, 
+        coord_t n, const uint8_t *bgra) {
+    coord_t n_vec = n & ~3;
+    uint32_t color;
+
+    if (n_vec > 0) {
+        /* alpha goes in separately; the color's alpha channel is opaque */
+        color = bgra[0] | (bgra[1] << 8) | (bgra[2] << 16) | (0xffU << 24);
+        BGRAn8_coverage_blend_chunk_sse2(dp, cp, n_vec, color, bgra[3]);
+    }
+
+    blend_row_default(dp + 4 * n_vec, cp + n_vec, n - n_vec, bgra);
+}
+#endif
+
+static void coverage_blend(RawFrame *dst, coord_t x, coord_t y, 
+        const uint8_t *coverage, coord_t w, coord_t h, size_t pitch,
+        const uint8_t *bgra, blend_row_fn blend_row) {
+
+    if (dst->pixel_format( ) != RawFrame::BGRAn8) {
+        throw std::runtime_error("unsupported pixel formats");
+    }
+
+    if (x >= dst->w( ) || y >= dst->h( ) || bgra[3] == 0) {
+        return;
+    }
+
+    if (x + w > dst->w( )) {
+        w = dst->w( ) - x;
+    }
+
+    if (y + h > dst->h( )) {
+        h = dst->h( ) - y;
+    }
+
+    for (coord_t row = 0; row < h; row++) {
+        blend_row(dst->scanline(y + row) + 4 * x, coverage + pitch * row,
+                w, bgra);
+    }
+}
+
+void BGRAn8_coverage_blend_default(RawFrame *dst, coord_t x, coord_t y,
+        const uint8_t *coverage, coord_t w, coord_t h, size_t pitch,
+        const uint8_t *bgra) {
+    coverage_blend(dst, x, y, coverage, w, h, pitch, bgra, 
+            blend_row_default);
+}
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+void BGRAn8_coverage_blend_sse2(RawFrame *dst, coord_t x, coord_t y,
+        const uint8_t *coverage, coord_t w, coord_t h, size_t pitch,
+        const uint8_t *bgra) {
+    coverage_blend(dst, x, y, coverage, w, h, pitch, bgra, blend_row_sse2);
+}
+#endif
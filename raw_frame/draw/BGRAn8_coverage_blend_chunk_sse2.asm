@@ -0,0 +1,106 @@
+; Copyright 2013 Exavideo LLC.
+; 
+; This file is part of openreplay.
+; 
+; openreplay is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+; 
+; openreplay is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+; 
+; You should have received a copy of the GNU General Public License
+; along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+
+bits 64
+bits 64
+
+%macro div255 2
+    ; %1 = %1 / 255 (rounded) for each word, %2 is scratch
+    paddw       %1, xmm10
+    movdqa      %2, %1
+    psrlw       %2, 8
+    paddw       %1, %2
+    psrlw       %1, 8
+%endmacro
+
+section text align=16
+global BGRAn8_coverage_blend_chunk_sse2
+
+BGRAn8_coverage_blend_chunk_sse2:
+    ; rdi = BGRAn8 destination
+    ; rsi = coverage, one byte per pixel
+    ; rdx = number of pixels (multiple of 4)
+    ; rcx = color, packed BGRA (alpha channel 0xff)
+    ; r8 = color alpha, scales the coverage
+
+    pxor        xmm7, xmm7
+    movd        xmm6, ecx
+    pshufd      xmm6, xmm6, 0x00
+    punpcklbw   xmm6, xmm7              ; xmm6 = [ a r g b a r g b ] words
+    movd        xmm8, r8d
+    pshuflw     xmm8, xmm8, 0x00
+    punpcklqdq  xmm8, xmm8              ; xmm8 = color alpha in each word
+    movdqa      xmm9, [w255 wrt rip]
+    movdqa      xmm10, [w128 wrt rip]
+
+.loop:
+    ; skip four pixels with no coverage at all
+    mov         eax, [rsi]
+    test        eax, eax
+    jz          .next
+
+    ; coverage * alpha for four pixels, as words
+    movd        xmm0, eax
+    punpcklbw   xmm0, xmm7
+    pmullw      xmm0, xmm8
+    div255      xmm0, xmm5
+
+    ; spread each pixel's alpha over its four channels
+    punpcklwd   xmm0, xmm0              ; [ a3 a3 a2 a2 a1 a1 a0 a0 ]
+    movdqa      xmm1, xmm0
+    punpckldq   xmm0, xmm0              ; pixels 0 and 1
+    punpckhdq   xmm1, xmm1              ; pixels 2 and 3
+
+    ; load four destination pixels as words
+    movdqu      xmm2, [rdi]
+    movdqa      xmm3, xmm2
+    punpcklbw   xmm2, xmm7
+    punpckhbw   xmm3, xmm7
+
+    ; dst * (255 - alpha) + color * alpha
+    movdqa      xmm4, xmm9
+    psubw       xmm4, xmm0
+    pmullw      xmm2, xmm4
+    movdqa      xmm4, xmm6
+    pmullw      xmm4, xmm0
+    paddw       xmm2, xmm4
+
+    movdqa      xmm4, xmm9
+    psubw       xmm4, xmm1
+    pmullw      xmm3, xmm4
+    movdqa      xmm4, xmm6
+    pmullw      xmm4, xmm1
+    paddw       xmm3, xmm4
+
+    div255      xmm2, xmm5
+    div255      xmm3, xmm5
+    packuswb    xmm2, xmm3
+    movdqu      [rdi], xmm2
+
+.next:
+    add         rdi, 16
+    add         rsi, 4
+    sub         rdx, 4
+    jg          .loop
+
+    ret
+
+align 16
+w255                    times 8 dw 255
+w128                    times 8 dw 128
+
+; vim:syntax=nasm64
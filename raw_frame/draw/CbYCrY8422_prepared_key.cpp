@@ -0,0 +1,131 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "raw_frame.h"
+#include "prepared_key.h"
+#include <assert.h>
+#include <string.h>
+
+/*
+ * Keying of a PreparedKey onto a CbYCrY8422 background. The fill is 
+ * already premultiplied Y'CbCr, so each byte is just
+ * bkgd * (255 - alpha) / 255 + fill, with global alpha folded into
+ * alpha and fill first.
+ */
+
+typedef void (*blend_span_fn)(uint8_t *bp, const uint8_t *fp, 
+        const uint8_t *ap, coord_t n_bytes, uint8_t galpha);
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+extern "C" void CbYCrY8422_prepared_key_chunk_sse2(void *bkgd, 
+        const void *fill, const void *alpha, uint64_t size, 
+        uint64_t galpha);
+#endif
+
+/* x / 255, rounded, for x <= 255 * 255 */
+static inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static void blend_span_default(uint8_t *bp, const uint8_t *fp,
+        const uint8_t *ap, coord_t n_bytes, uint8_t galpha) {
+    uint32_t a, f, v;
+
+    for (coord_t i = 0; i < n_bytes; i++) {
+        if (ap[i] == 0) {
+            continue;
+        }
+
+        a = div255(ap[i] * galpha);
+        f = div255(fp[i] * galpha);
+        v = div255(bp[i] * (255 - a)) + f;
+        bp[i] = (v > 255) ? 255 : v;
+    }
+}
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+static void blend_span_sse2(uint8_t *bp, const uint8_t *fp,
+        const uint8_t *ap, coord_t n_bytes, uint8_t galpha) {
+    CbYCrY8422_prepared_key_chunk_sse2(bp, fp, ap, n_bytes, galpha);
+}
+#endif
+
+static void prepared_key(RawFrame *bkgd, const PreparedKey &key,
+        coord_t x, coord_t y, uint8_t galpha, blend_span_fn blend_span) {
+
+    const Rect &bounds = key.bounds( );
+    unsigned int row, end, limit;
+    uint8_t *bp;
+
+    assert(bkgd->pixel_format( ) == RawFrame::CbYCrY8422);
+    assert(x % 2 == 0);
+
+    if (galpha == 0 || !key.valid( ) || x >= bkgd->w( )) {
+        return;
+    }
+
+    /* rightmost key pixel that lands on the background */
+    limit = bkgd->w( ) - x;
+
+    for (row = bounds.y; row < bounds.y1( ) && y + row < bkgd->h( ); row++) {
+        const PreparedKey::SpanList &spans = key.row(row);
+        const uint8_t *fp = key.fill_line(row);
+        const uint8_t *ap = key.alpha_line(row);
+
+        bp = bkgd->scanline(y + row) + 2 * x;
+
+        for (unsigned int i = 0; i < spans.size( ); i++) {
+            const PreparedKey::Span &span = spans[i];
+
+            if (span.type == KeyCoverage::CLEAR || span.start >= limit) {
+                continue;
+            }
+
+            end = (span.end < limit) ? span.end : limit;
+            end = (end + 1) & ~1U; /* whole 4:2:2 pixel pairs */
+
+            if (span.type == KeyCoverage::SOLID && galpha == 0xff) {
+                memcpy(bp + 2 * span.start, fp + 2 * span.start,
+                        2 * (end - span.start));
+            } else if (end == span.end) {
+                blend_span(bp + 2 * span.start, fp + 2 * span.start,
+                        ap + 2 * span.start, 2 * (end - span.start), galpha);
+            } else {
+                /* clipped at the right edge: not whole SIMD blocks */
+                blend_span_default(bp + 2 * span.start, fp + 2 * span.start,
+                        ap + 2 * span.start, 2 * (end - span.start), galpha);
+            }
+        }
+    }
+}
+
+void CbYCrY8422_prepared_key_default(RawFrame *bkgd, const PreparedKey &key,
+        coord_t x, coord_t y, uint8_t galpha) {
+    prepared_key(bkgd, key, x, y, galpha, blend_span_default);
+}
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+void CbYCrY8422_prepared_key_sse2(RawFrame *bkgd, const PreparedKey &key,
+        coord_t x, coord_t y, uint8_t galpha) {
+    prepared_key(bkgd, key, x, y, galpha, blend_span_sse2);
+}
+#endif
@@ -0,0 +1,107 @@
+; Copyright 2013 Exavideo LLC.
+; 
+; This file is part of openreplay.
+; 
+; openreplay is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+; 
+; openreplay is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+; 
+; You should have received a copy of the GNU General Public License
+; along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+
+bits 64
+
+%macro div255 2
+    ; %1 = %1 / 255 (rounded) for each word, %2 is scratch
+    paddw       %1, xmm10
+    movdqa      %2, %1
+    psrlw       %2, 8
+    paddw       %1, %2
+    psrlw       %1, 8
+%endmacro
+
+section text align=16
+global CbYCrY8422_prepared_key_chunk_sse2
+
+CbYCrY8422_prepared_key_chunk_sse2:
+    ; rdi = CbYCrY8422 background data
+    ; rsi = premultiplied CbYCrY8422 fill (16-byte aligned)
+    ; rdx = per-sample alpha for the fill (16-byte aligned)
+    ; rcx = number of bytes to key (multiple of 16)
+    ; r8 = global alpha
+
+    pxor        xmm7, xmm7
+    movd        xmm8, r8d
+    pshuflw     xmm8, xmm8, 0x00
+    punpcklqdq  xmm8, xmm8              ; xmm8 = global alpha in each word
+    movdqa      xmm9, [w255 wrt rip]
+    movdqa      xmm10, [w128 wrt rip]
+
+.loop:
+    ; skip blocks that are fully transparent
+    movdqa      xmm2, [rdx]
+    movdqa      xmm3, xmm2
+    pcmpeqb     xmm3, xmm7
+    pmovmskb    eax, xmm3
+    cmp         eax, 0xffff
+    je          .next
+
+    ; alpha * global alpha, as words
+    movdqa      xmm3, xmm2
+    punpcklbw   xmm2, xmm7
+    punpckhbw   xmm3, xmm7
+    pmullw      xmm2, xmm8
+    pmullw      xmm3, xmm8
+    div255      xmm2, xmm6
+    div255      xmm3, xmm6
+
+    ; fill * global alpha, repacked to bytes in xmm4
+    movdqa      xmm4, [rsi]
+    movdqa      xmm5, xmm4
+    punpcklbw   xmm4, xmm7
+    punpckhbw   xmm5, xmm7
+    pmullw      xmm4, xmm8
+    pmullw      xmm5, xmm8
+    div255      xmm4, xmm6
+    div255      xmm5, xmm6
+    packuswb    xmm4, xmm5
+
+    ; background * (255 - alpha)
+    movdqu      xmm0, [rdi]
+    movdqa      xmm1, xmm0
+    punpcklbw   xmm0, xmm7
+    punpckhbw   xmm1, xmm7
+    movdqa      xmm5, xmm9
+    psubw       xmm5, xmm2
+    pmullw      xmm0, xmm5
+    movdqa      xmm5, xmm9
+    psubw       xmm5, xmm3
+    pmullw      xmm1, xmm5
+    div255      xmm0, xmm6
+    div255      xmm1, xmm6
+    packuswb    xmm0, xmm1
+
+    ; add the fill and store
+    paddusb     xmm0, xmm4
+    movdqu      [rdi], xmm0
+
+.next:
+    add         rdi, 16
+    add         rsi, 16
+    add         rdx, 16
+    sub         rcx, 16
+    jg          .loop
+
+    ret
+
+align 16
+w255                    times 8 dw 255
+w128                    times 8 dw 128
+
+; vim:syntax=nasm64
@@ -0,0 +1,153 @@
+; Copyright 2013 Exavideo LLC.
+; 
+; This file is part of openreplay.
+; 
+; openreplay is free software: you can redistribute it and/or modify
+; it under the terms of the GNU General Public License as published by
+; the Free Software Foundation, either version 3 of the License, or
+; (at your option) any later version.
+; 
+; openreplay is distributed in the hope that it will be useful,
+; but WITHOUT ANY WARRANTY; without even the implied warranty of
+; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+; GNU General Public License for more details.
+; 
+; You should have received a copy of the GNU General Public License
+; along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+
+
+bits 64
+
+%macro div255 2
+    ; %1 = %1 / 255 (rounded) for each word, %2 is scratch
+    paddw       %1, xmm10
+    movdqa      %2, %1
+    psrlw       %2, 8
+    paddw       %1, %2
+    psrlw       %1, 8
+%endmacro
+
+%macro over_white 4
+    ; %1 = %1 + (255 - %1) * %2 / 255 for each word, %3 and %4 are scratch
+    movdqa      %3, xmm9
+    psubw       %3, %1
+    pmullw      %3, %2
+    div255      %3, %4
+    paddw       %1, %3
+%endmacro
+
+section text align=16
+global scope_render_chunk_sse2
+
+scope_render_chunk_sse2:
+    ; rdi = BGRAn8 output
+    ; rsi = BGRAn8 graticule
+    ; rdx = persistence buffer, one word per cell
+    ; rcx = hits, one word per cell (cleared as we go)
+    ; r8 = number of cells (multiple of 8)
+    ; r9 = gain shift
+    ; [rsp+8] = persistence shift
+    ; [rsp+16] = nonzero to draw every cell, even dark ones
+
+    pxor        xmm15, xmm15
+    movq        xmm14, r9               ; gain
+    mov         rax, [rsp+8]
+    movq        xmm13, rax              ; persistence
+    mov         r10, [rsp+16]           ; redraw
+    pcmpeqw     xmm11, xmm11            ; all ones
+    movdqa      xmm12, xmm11
+    psrlw       xmm12, xmm14            ; largest hit count that won't overflow
+    movdqa      xmm9, [w255 wrt rip]
+    movdqa      xmm10, [w128 wrt rip]
+    movdqa      xmm8, [w1 wrt rip]
+
+.loop:
+    movdqu      xmm0, [rcx]
+    movdqu      xmm2, [rdx]
+
+    ; no hits now and none before: output is already the graticule
+    movdqa      xmm1, xmm0
+    por         xmm1, xmm2
+    pcmpeqw     xmm1, xmm15
+    pmovmskb    eax, xmm1
+    cmp         eax, 0xffff
+    jne         .draw
+    test        r10, r10
+    jz          .next
+
+.draw:
+    movdqu      [rcx], xmm15
+
+    ; hits << gain, saturated
+    movdqa      xmm1, xmm0
+    psubusw     xmm1, xmm12
+    pcmpeqw     xmm1, xmm15             ; set where the shift won't overflow
+    psllw       xmm0, xmm14
+    pand        xmm0, xmm1
+    pxor        xmm1, xmm11
+    por         xmm0, xmm1
+
+    ; persist -= max(persist >> persistence, 1) (saturated at 0)
+    ; persist += hits
+    movdqa      xmm3, xmm2
+    psrlw       xmm3, xmm13
+    movdqa      xmm4, xmm3
+    pcmpeqw     xmm4, xmm15
+    pand        xmm4, xmm8
+    por         xmm3, xmm4
+    psubusw     xmm2, xmm3
+    paddusw     xmm2, xmm0
+    movdqu      [rdx], xmm2
+
+    ; brightness = min(persist >> 4, 255)
+    psrlw       xmm2, 4
+    packuswb    xmm2, xmm2
+    punpcklbw   xmm2, xmm15
+
+    ; spread each brightness over its pixel's four channels
+    movdqa      xmm3, xmm2
+    punpcklwd   xmm2, xmm2              ; cells 0-3
+    punpckhwd   xmm3, xmm3              ; cells 4-7
+    movdqa      xmm4, xmm2
+    punpckldq   xmm2, xmm2              ; pixels 0 and 1
+    punpckhdq   xmm4, xmm4              ; pixels 2 and 3
+    movdqa      xmm5, xmm3
+    punpckldq   xmm3, xmm3              ; pixels 4 and 5
+    punpckhdq   xmm5, xmm5              ; pixels 6 and 7
+
+    ; pixels 0-3
+    movdqu      xmm6, [rsi]
+    movdqa      xmm7, xmm6
+    punpcklbw   xmm6, xmm15
+    punpckhbw   xmm7, xmm15
+    over_white  xmm6, xmm2, xmm0, xmm1
+    over_white  xmm7, xmm4, xmm0, xmm1
+    packuswb    xmm6, xmm7
+    movdqu      [rdi], xmm6
+
+    ; pixels 4-7
+    movdqu      xmm6, [rsi+16]
+    movdqa      xmm7, xmm6
+    punpcklbw   xmm6, xmm15
+    punpckhbw   xmm7, xmm15
+    over_white  xmm6, xmm3, xmm0, xmm1
+    over_white  xmm7, xmm5, xmm0, xmm1
+    packuswb    xmm6, xmm7
+    movdqu      [rdi+16], xmm6
+
+.next:
+    add         rdi, 32
+    add         rsi, 32
+    add         rdx, 16
+    add         rcx, 16
+    sub         r8, 8
+    jg          .loop
+
+    ret
+
+align 16
+w255                    times 8 dw 255
+w128                    times 8 dw 128
+w1                      times 8 dw 1
+
+; vim:syntax=nasm64
@@ -27,12 +27,18 @@ void BGRAn8_alpha_composite_default(RawFrame *bkgd, RawFrame *key,
         coord_t x, coord_t y, uint8_t galpha,
         coord_t src_x, coord_t src_y,
         coord_t w, coord_t h);
+void BGRAn8_coverage_blend_default(RawFrame *dst, coord_t x, coord_t y,
+        const uint8_t *coverage, coord_t w, coord_t h, size_t pitch,
+        const uint8_t *bgra);
 
 #ifndef SKIP_ASSEMBLY_ROUTINES
 void BGRAn8_alpha_composite_sse2(RawFrame *bkgd, RawFrame *key,
         coord_t x, coord_t y, uint8_t galpha,
         coord_t src_x, coord_t src_y,
         coord_t w, coord_t h);
+void BGRAn8_coverage_blend_sse2(RawFrame *dst, coord_t x, coord_t y,
+        const uint8_t *coverage, coord_t w, coord_t h, size_t pitch,
+        const uint8_t *bgra);
 #endif
 
 class BGRAn8DrawOps : public RawFrameDrawOps {
@@ -43,11 +49,14 @@ class BGRAn8DrawOps : public RawFrameDrawOps {
 #ifndef SKIP_ASSEMBLY_ROUTINES
             if (cpu_sse2_available( )) {
                 do_alpha_composite = BGRAn8_alpha_composite_sse2;
+                do_coverage_blend = BGRAn8_coverage_blend_sse2;
             } else {
                 do_alpha_composite = BGRAn8_alpha_composite_default;
+                do_coverage_blend = BGRAn8_coverage_blend_default;
             }
 #else
             do_alpha_composite = BGRAn8_alpha_composite_default;
+            do_coverage_blend = BGRAn8_coverage_blend_default;
 #endif
         }
 };
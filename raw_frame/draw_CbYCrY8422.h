@@ -26,10 +26,16 @@
 void CbYCrY8422_alpha_key_default(RawFrame *bkgd, RawFrame *key,
         coord_t x, coord_t y, uint8_t galpha);
 
+void CbYCrY8422_prepared_key_default(RawFrame *bkgd, const PreparedKey &key,
+        coord_t x, coord_t y, uint8_t galpha);
+
 
 #ifndef SKIP_ASSEMBLY_ROUTINES 
 void CbYCrY8422_alpha_key_sse2(RawFrame *bkgd, RawFrame *key, 
         coord_t x, coord_t y, uint8_t galpha);
+
+void CbYCrY8422_prepared_key_sse2(RawFrame *bkgd, const PreparedKey &key,
+        coord_t x, coord_t y, uint8_t galpha);
 #endif
 
 class CbYCrY8422DrawOps : public RawFrameDrawOps {
@@ -38,11 +44,14 @@ class CbYCrY8422DrawOps : public RawFrameDrawOps {
 
 #ifdef SKIP_ASSEMBLY_ROUTINES
             do_alpha_blend = CbYCrY8422_alpha_key_default;
+            do_prepared_key = CbYCrY8422_prepared_key_default;
 #else
             if (cpu_sse3_available( )) {
                 do_alpha_blend = CbYCrY8422_alpha_key_sse2;
+                do_prepared_key = CbYCrY8422_prepared_key_sse2;
             } else {
                 do_alpha_blend = CbYCrY8422_alpha_key_default;
+                do_prepared_key = CbYCrY8422_prepared_key_default;
             }
 #endif
         }
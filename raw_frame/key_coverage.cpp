@@ -0,0 +1,173 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "key_coverage.h"
+#include "raw_frame.h"
+
+#include <string.h>
+#include <stdexcept>
+
+/* alpha bytes of two BGRAn8 pixels packed in a uint64_t */
+#define ALPHA_MASK 0xff000000ff000000ULL
+
+KeyCoverage::KeyCoverage( ) {
+    _w = 0;
+    _h = 0;
+    n_covered = 0;
+}
+
+Rect KeyCoverage::update(RawFrame *key) {
+    Rect damage;
+
+    if (key->pixel_format( ) != RawFrame::BGRAn8) {
+        throw std::runtime_error("KeyCoverage: key must be BGRAn8");
+    }
+
+    if (key->w( ) != _w || key->h( ) != _h) {
+        /* new geometry: everything has to be scanned */
+        _w = key->w( );
+        _h = key->h( );
+        rows.assign(_h, SpanList( ));
+        row_covered.assign(_h, 0);
+        damage = Rect(0, 0, _w, _h);
+    } else {
+        damage = key->damage( );
+        damage.intersect(Rect(0, 0, _w, _h));
+    }
+
+    if (damage.empty( )) {
+        return damage;
+    }
+
+    for (unsigned int y = damage.y; y < damage.y1( ); y++) {
+        scan_row(key, y);
+    }
+
+    find_bounds( );
+    return damage;
+}
+
+static KeyCoverage::SpanType classify(const uint8_t *px, coord_t n) {
+    uint64_t a, b;
+
+    if (n == 4) {
+        memcpy(&a, px, 8);
+        memcpy(&b, px + 8, 8);
+        a &= ALPHA_MASK;
+        b &= ALPHA_MASK;
+
+        if ((a | b) == 0) {
+            return KeyCoverage::CLEAR;
+        } else if ((a & b) == ALPHA_MASK) {
+            return KeyCoverage::SOLID;
+        } else {
+            return KeyCoverage::MIXED;
+        }
+    } else {
+        /* partial block at the end of a scanline */
+        bool any = false, all = true;
+        for (coord_t i = 0; i < n; i++) {
+            any = any || (px[4*i + 3] != 0);
+            all = all && (px[4*i + 3] == 0xff);
+        }
+
+        if (!any) {
+            return KeyCoverage::CLEAR;
+        } else if (all) {
+            return KeyCoverage::SOLID;
+        } else {
+            return KeyCoverage::MIXED;
+        }
+    }
+}
+
+void KeyCoverage::scan_row(RawFrame *key, coord_t y) {
+    const uint8_t *line = key->scanline(y);
+    SpanList &spans = rows[y];
+    Span span;
+    SpanType type;
+    coord_t n;
+
+    spans.clear( );
+    row_covered[y] = 0;
+
+    for (unsigned int x = 0; x < _w; x += 4) {
+        n = (_w - x < 4) ? _w - x : 4;
+        type = classify(line + 4*x, n);
+
+        if (type != CLEAR) {
+            row_covered[y] += n;
+        }
+
+        if (!spans.empty( ) && spans.back( ).type == type) {
+            spans.back( ).end = x + n;
+        } else {
+            span.start = x;
+            span.end = x + n;
+            span.type = type;
+            spans.push_back(span);
+        }
+    }
+}
+
+void KeyCoverage::find_bounds( ) {
+    unsigned int x0 = _w, x1 = 0, y0 = _h, y1 = 0;
+
+    n_covered = 0;
+
+    for (unsigned int y = 0; y < _h; y++) {
+        const SpanList &spans = rows[y];
+
+        if (row_covered[y] == 0) {
+            continue;
+        }
+
+        n_covered += row_covered[y];
+
+        if (y < y0) {
+            y0 = y;
+        }
+        y1 = y + 1;
+
+        for (unsigned int i = 0; i < spans.size( ); i++) {
+            if (spans[i].type != CLEAR) {
+                if (spans[i].start < x0) {
+                    x0 = spans[i].start;
+                }
+                break;
+            }
+        }
+
+        for (unsigned int i = spans.size( ); i > 0; i--) {
+            if (spans[i - 1].type != CLEAR) {
+                if (spans[i - 1].end > x1) {
+                    x1 = spans[i - 1].end;
+                }
+                break;
+            }
+        }
+    }
+
+    if (n_covered == 0) {
+        _bounds = Rect( );
+    } else {
+        _bounds = Rect(x0, y0, x1 - x0, y1 - y0);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OPENREPLAY_KEY_COVERAGE_H
+#define _OPENREPLAY_KEY_COVERAGE_H
+
+#include "types.h"
+#include "rect.h"
+#include <vector>
+
+class RawFrame;
+
+/*
+ * Alpha coverage of a BGRAn8 key, so keying can skip the parts of an
+ * overlay that are fully transparent and copy the parts that are fully
+ * opaque. Each scanline is split into spans of 4-pixel blocks 
+ * (the SIMD keyer's unit of work) classified by their alpha values.
+ *
+ * After the first full analysis, update( ) only rescans the rows 
+ * inside the key's damage rectangle.
+ */
+class KeyCoverage {
+    public:
+        enum SpanType { CLEAR, SOLID, MIXED };
+
+        struct Span {
+            coord_t start, end;     /* pixels, end exclusive */
+            SpanType type;
+        };
+
+        typedef std::vector<Span> SpanList;
+
+        KeyCoverage( );
+
+        /* 
+         * bring coverage up to date with key (which must be BGRAn8);
+         * returns the region that was rescanned
+         */
+        Rect update(RawFrame *key);
+        void invalidate( ) { _w = 0; _h = 0; }
+
+        const SpanList &row(coord_t y) const { return rows[y]; }
+
+        /* bounding box of everything not fully transparent */
+        const Rect &bounds( ) const { return _bounds; }
+
+        /* number of pixels that are not fully transparent */
+        unsigned long covered( ) const { return n_covered; }
+
+    protected:
+        void scan_row(RawFrame *key, coord_t y);
+        void find_bounds( );
+
+        std::vector<SpanList> rows;
+        std::vector<unsigned int> row_covered;
+        coord_t _w, _h;
+        Rect _bounds;
+        unsigned long n_covered;
+};
+
+#endif
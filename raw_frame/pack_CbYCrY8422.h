@@ -42,6 +42,17 @@ void YCbCr8P420_CbYCrY8422_A_default(size_t, size_t, size_t, size_t, size_t,
         //size_t, uint8_t *, uint8_t *, uint8_t *, uint8_t *);
 #endif
 
+#ifndef SKIP_ASSEMBLY_ROUTINES
+void YCbCr8P422_CbYCrY8422_A_sse2(size_t, size_t, size_t, size_t, size_t, 
+        uint8_t *, uint8_t *, uint8_t *, uint8_t *);
+
+void YCbCr10P422_CbYCrY8422_A_sse2(size_t, size_t, size_t, size_t, size_t,
+        uint16_t *, uint16_t *, uint16_t *, uint8_t *);
+
+void YCbCr8P420_CbYCrY8422_A_sse2(size_t, size_t, size_t, size_t, size_t,
+    uint8_t *, uint8_t *, uint8_t *, uint8_t *);
+#endif
+
 class CbYCrY8422Packer : public RawFramePacker {
     public:
         CbYCrY8422Packer(RawFrame *f) : RawFramePacker(f) {
@@ -51,9 +62,22 @@ class CbYCrY8422Packer : public RawFramePacker {
             } else {
                 do_YCbCr8P422 = YCbCr8P422_CbYCrY8422_default;
             }
+
+#ifdef SKIP_ASSEMBLY_ROUTINES
             do_YCbCr8P422A = YCbCr8P422_CbYCrY8422_A_default;
             do_YCbCr10P422A = YCbCr10P422_CbYCrY8422_A_default;
             do_YCbCr8P420A = YCbCr8P420_CbYCrY8422_A_default;
+#else
+            if (cpu_sse2_available( )) {
+                do_YCbCr8P422A = YCbCr8P422_CbYCrY8422_A_sse2;
+                do_YCbCr10P422A = YCbCr10P422_CbYCrY8422_A_sse2;
+                do_YCbCr8P420A = YCbCr8P420_CbYCrY8422_A_sse2;
+            } else {
+                do_YCbCr8P422A = YCbCr8P422_CbYCrY8422_A_default;
+                do_YCbCr10P422A = YCbCr10P422_CbYCrY8422_A_default;
+                do_YCbCr8P420A = YCbCr8P420_CbYCrY8422_A_default;
+            }
+#endif
         }
 };
 
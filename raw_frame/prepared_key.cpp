@@ -0,0 +1,253 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "prepared_key.h"
+#include "raw_frame.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+
+/* pixels per span unit: one 16-byte SIMD block of 4:2:2 samples */
+#define PREPARED_BLOCK 8
+
+PreparedKey::PreparedKey( ) {
+    _w = 0;
+    _h = 0;
+    pitch = 0;
+    fill = NULL;
+    alpha = NULL;
+}
+
+PreparedKey::PreparedKey(const PreparedKey &other) {
+    _w = 0;
+    _h = 0;
+    pitch = 0;
+    fill = NULL;
+    alpha = NULL;
+    *this = other;
+}
+
+PreparedKey &PreparedKey::operator=(const PreparedKey &other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    free_planes( );
+    coverage = other.coverage;
+    rows = other.rows;
+
+    if (other.valid( )) {
+        alloc(other._w, other._h);
+        memcpy(fill, other.fill, pitch * _h);
+        memcpy(alpha, other.alpha, pitch * _h);
+    }
+
+    return *this;
+}
+
+PreparedKey::~PreparedKey( ) {
+    free_planes( );
+}
+
+void PreparedKey::alloc(coord_t w, coord_t h) {
+    _w = w;
+    _h = h;
+
+    /* whole SIMD blocks per line, so the keyer never needs a tail case */
+    pitch = 2 * ((w + PREPARED_BLOCK - 1) / PREPARED_BLOCK) * PREPARED_BLOCK;
+
+    if (posix_memalign((void **) &fill, 16, pitch * h) != 0
+            || posix_memalign((void **) &alpha, 16, pitch * h) != 0) {
+        throw std::runtime_error("PreparedKey: allocation failed");
+    }
+
+    memset(fill, 0, pitch * h);
+    memset(alpha, 0, pitch * h);
+    rows.assign(h, SpanList( ));
+}
+
+void PreparedKey::free_planes( ) {
+    free(fill);
+    free(alpha);
+    fill = NULL;
+    alpha = NULL;
+    _w = 0;
+    _h = 0;
+    pitch = 0;
+}
+
+void PreparedKey::invalidate( ) {
+    coverage.invalidate( );
+    free_planes( );
+}
+
+void PreparedKey::update(RawFrame *key) {
+    Rect changed;
+
+    if (key->w( ) != _w || key->h( ) != _h) {
+        free_planes( );
+        coverage.invalidate( );
+        alloc(key->w( ), key->h( ));
+    }
+
+    changed = coverage.update(key);
+
+    for (unsigned int y = changed.y; y < changed.y1( ); y++) {
+        convert_row(key, y);
+        find_spans(y);
+    }
+}
+
+static inline uint8_t premultiply(int32_t v, int32_t a) {
+    return (v * a + 127) / 255;
+}
+
+/* 
+ * Same color math and chroma filtering as the BGRAn8 keyers, 
+ * minus the background.
+ */
+void PreparedKey::convert_row(RawFrame *key, coord_t y) {
+    const KeyCoverage::SpanList &spans = coverage.row(y);
+    uint8_t *kp, *fp, *ap;
+    int32_t fr0, fg0, fb0, fr1, fg1, fb1;
+    int32_t fra, fga, fba;
+    int32_t ka0, ka1, kaa;
+    int32_t frp, fgp, fbp, kap;
+    coord_t j, start, end;
+
+    memset(fill + pitch * y, 0, pitch);
+    memset(alpha + pitch * y, 0, pitch);
+
+    for (unsigned int i = 0; i < spans.size( ); i++) {
+        if (spans[i].type == KeyCoverage::CLEAR) {
+            continue;
+        }
+
+        /* 
+         * extend by a pair on each side: the chroma filter bleeds
+         * alpha into the clear pixels next to the span
+         */
+        start = spans[i].start;
+        end = spans[i].end;
+        if (start > 0) {
+            start -= 2;
+        }
+        if (end < _w) {
+            end += 2;
+        }
+
+        kp = key->scanline(y) + 4 * start;
+        fp = fill + pitch * y + 2 * start;
+        ap = alpha + pitch * y + 2 * start;
+
+        fbp = kp[0];
+        fgp = kp[1];
+        frp = kp[2];
+        kap = kp[3];
+        if (start > 0) {
+            fbp = kp[-4];
+            fgp = kp[-3];
+            frp = kp[-2];
+            kap = kp[-1];
+        }
+
+        for (j = start; j < end; j += 2, kp += 8, fp += 4, ap += 4) {
+            fb0 = kp[0];
+            fg0 = kp[1];
+            fr0 = kp[2];
+            ka0 = kp[3];
+
+            if (j + 1 < _w) {
+                fb1 = kp[4];
+                fg1 = kp[5];
+                fr1 = kp[6];
+                ka1 = kp[7];
+            } else {
+                fb1 = fb0;
+                fg1 = fg0;
+                fr1 = fr0;
+                ka1 = ka0;
+            }
+
+            fra = (frp + 2*fr0 + fr1) / 4;
+            fga = (fgp + 2*fg0 + fg1) / 4;
+            fba = (fbp + 2*fb0 + fb1) / 4;
+            kaa = (kap + 2*ka0 + ka1) / 4;
+
+            frp = fr1;
+            fgp = fg1;
+            fbp = fb1;
+            kap = ka1;
+
+            fp[0] = premultiply((32768 -  38*fra -  74*fga + 112*fba) / 256, 
+                    kaa);
+            fp[1] = premultiply((4096  +  66*fr0 + 129*fg0 +  25*fb0) / 256, 
+                    ka0);
+            fp[2] = premultiply((32768 + 112*fra -  94*fga -  18*fba) / 256, 
+                    kaa);
+            fp[3] = premultiply((4096  +  66*fr1 + 129*fg1 +  25*fb1) / 256, 
+                    ka1);
+
+            ap[0] = kaa;
+            ap[1] = ka0;
+            ap[2] = kaa;
+            ap[3] = ka1;
+        }
+    }
+}
+
+/* classify each 16-byte block of the prepared alpha line */
+void PreparedKey::find_spans(coord_t y) {
+    const uint8_t *ap = alpha + pitch * y;
+    SpanList &spans = rows[y];
+    KeyCoverage::SpanType type;
+    Span span;
+    bool any, all;
+
+    spans.clear( );
+
+    for (unsigned int x = 0; x < _w; x += PREPARED_BLOCK) {
+        any = false;
+        all = true;
+
+        for (unsigned int i = 0; i < 2 * PREPARED_BLOCK; i++) {
+            any = any || (ap[2 * x + i] != 0);
+            all = all && (ap[2 * x + i] == 0xff);
+        }
+
+        if (!any) {
+            type = KeyCoverage::CLEAR;
+        } else if (all) {
+            type = KeyCoverage::SOLID;
+        } else {
+            type = KeyCoverage::MIXED;
+        }
+
+        if (!spans.empty( ) && spans.back( ).type == type) {
+            spans.back( ).end = x + PREPARED_BLOCK;
+        } else {
+            span.start = x;
+            span.end = x + PREPARED_BLOCK;
+            span.type = type;
+            spans.push_back(span);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OPENREPLAY_PREPARED_KEY_H
+#define _OPENREPLAY_PREPARED_KEY_H
+
+#include "types.h"
+#include "rect.h"
+#include "key_coverage.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class RawFrame;
+
+/*
+ * A BGRAn8 overlay converted once into the form the CbYCrY8422 keyer
+ * wants: premultiplied 4:2:2 Y'CbCr fill plus a matching per-sample 
+ * alpha plane (Cb and Cr carry the filtered chroma alpha). Keying it is
+ * a plain per-byte blend with no color conversion, so an overlay that
+ * isn't changing costs little more than the blend itself.
+ *
+ * Rows are split into 8-pixel (16 byte) spans that are fully clear, 
+ * fully opaque (a copy) or need blending. update( ) reconverts only 
+ * the rows inside the key's damage rectangle.
+ */
+class PreparedKey {
+    public:
+        typedef KeyCoverage::SpanType SpanType;
+        typedef KeyCoverage::Span Span;
+        typedef KeyCoverage::SpanList SpanList;
+
+        PreparedKey( );
+        PreparedKey(const PreparedKey &other);
+        PreparedKey &operator=(const PreparedKey &other);
+        ~PreparedKey( );
+
+        void update(RawFrame *key);
+        void invalidate( );
+        bool valid( ) const { return _w != 0; }
+
+        coord_t w( ) const { return _w; }
+        coord_t h( ) const { return _h; }
+
+        const uint8_t *fill_line(coord_t y) const { return fill + pitch * y; }
+        const uint8_t *alpha_line(coord_t y) const { 
+            return alpha + pitch * y; 
+        }
+        const SpanList &row(coord_t y) const { return rows[y]; }
+        const Rect &bounds( ) const { return coverage.bounds( ); }
+
+    protected:
+        void alloc(coord_t w, coord_t h);
+        void free_planes( );
+        void convert_row(RawFrame *key, coord_t y);
+        void find_spans(coord_t y);
+
+        KeyCoverage coverage;
+        std::vector<SpanList> rows;
+
+        coord_t _w, _h;
+        size_t pitch;
+        uint8_t *fill;
+        uint8_t *alpha;
+};
+
+#endif
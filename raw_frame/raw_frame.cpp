@@ -43,6 +43,8 @@ RawFrame::RawFrame( ) {
     _pitch = 0;
     _data = NULL;
     _field_dominance = UNKNOWN;
+    _capture_time = 0;
+    _damage_known = false;
     _global_alpha = 0xff;
     pack = NULL;
     unpack = NULL;
@@ -56,6 +58,8 @@ RawFrame::RawFrame(PixelFormat pf) {
 
 void RawFrame::initialize_pf(PixelFormat pf) {
     _field_dominance = UNKNOWN;
+    _capture_time = 0;
+    _damage_known = false;
     _pixel_format = pf;
     _global_alpha = 0xff;
     make_ops( );
@@ -66,6 +70,8 @@ RawFrame::RawFrame(coord_t w, coord_t h, PixelFormat pf) {
     _h = h;
     _global_alpha = 0xff;
     _field_dominance = UNKNOWN;
+    _capture_time = 0;
+    _damage_known = false;
     _pixel_format = pf;
     _pitch = minpitch( );
     alloc( );
@@ -77,6 +83,8 @@ RawFrame::RawFrame(coord_t w, coord_t h, PixelFormat pf, size_t pitch) {
     _h = h;
     _global_alpha = 0xff;
     _field_dominance = UNKNOWN;
+    _capture_time = 0;
+    _damage_known = false;
     _pixel_format = pf;
     _pitch = pitch;
     if (_pitch < minpitch( )) {
@@ -94,6 +102,14 @@ RawFrame *RawFrame::copy( ) {
     return ret;
 }
 
+RawFrame *RawFrame::clone( ) {
+    RawFrame *ret = copy( );
+    ret->_field_dominance = _field_dominance;
+    ret->_capture_time = _capture_time;
+    ret->_global_alpha = _global_alpha;
+    return ret;
+}
+
 void RawFrame::make_ops(void) {
     make_packer( );
     make_unpacker( );
@@ -20,6 +20,8 @@
 #define _OPENREPLAY_RAW_FRAME_H
     
 #include "types.h"
+#include "rect.h"
+#include "ref.h"
 #include <stdexcept>
 #include <stdio.h>
 
@@ -27,8 +29,9 @@ class RawFramePacker;
 class RawFrameUnpacker;
 class RawFrameDrawOps;
 class RawFrameConverter;
+class PreparedKey;
 
-class RawFrame {
+class RawFrame : public RefCounted {
     public:
         enum PixelFormat { 
             UNDEF,
@@ -48,6 +51,8 @@ class RawFrame {
         virtual ~RawFrame( );
 
         RawFrame *copy( );
+        /* copy( ), plus field dominance and capture time (for ref<>) */
+        RawFrame *clone( );
 
         uint8_t *scanline(coord_t y) { return _data + _pitch * y; }
         uint8_t *pixel(coord_t x, coord_t y) { 
@@ -72,6 +77,23 @@ class RawFrame {
         FieldDominance field_dominance( ) const { return _field_dominance; }
         void set_field_dominance(FieldDominance fd) { _field_dominance = fd; }
 
+        /* 
+         * Monotonic time (msec) at which the frame was captured, 
+         * or zero if unknown. Used to measure ingest backlog.
+         */
+        uint64_t capture_time( ) const { return _capture_time; }
+        void set_capture_time(uint64_t t) { _capture_time = t; }
+
+        /*
+         * The part of the picture that changed since the previous frame
+         * from the same producer (e.g. a CG). Unless the producer says 
+         * otherwise, the whole frame is assumed to have changed.
+         */
+        Rect damage( ) const { 
+            return _damage_known ? _damage : Rect(0, 0, _w, _h); 
+        }
+        void set_damage(const Rect &r) { _damage = r; _damage_known = true; }
+
 	static RawFrame *from_image_file(const char *path);
         static RawFrame *from_png_data(void *data, size_t size);
 	static RawFrame *from_tga_data(const void *data, size_t size);
@@ -129,6 +151,9 @@ class RawFrame {
         void make_converter( );
         
         FieldDominance _field_dominance;
+        uint64_t _capture_time;
+        Rect _damage;
+        bool _damage_known;
 
         static int n_frames;
 };
@@ -231,6 +256,18 @@ class RawFrameUnpacker {
             do_BGRAn8(f->size( ), f->data( ), data);
         }
 
+        /* 
+         * unpack into part of a larger BGRAn8 surface, one whole source
+         * scanline (pitch bytes) at a time; vector routines need data, 
+         * dst_pitch and f's pitch to be 16-byte aligned
+         */
+        void BGRAn8(uint8_t *data, size_t dst_pitch) {
+            CHECK(do_BGRAn8);
+            for (coord_t y = 0; y < f->h( ); y++) {
+                do_BGRAn8(f->pitch( ), f->scanline(y), data + dst_pitch * y);
+            }
+        }
+
         void BGRAn8_scale_1_2(uint8_t *data) {
             CHECK(do_BGRAn8_scale_1_2);
             do_BGRAn8_scale_1_2(f->size( ), f->data( ), data, f->pitch( ));
@@ -391,6 +428,8 @@ class RawFrameDrawOps {
     public:
         RawFrameDrawOps(RawFrame *f_) : f(f_) { 
             do_alpha_blend = NULL;
+            do_prepared_key = NULL;
+            do_coverage_blend = NULL;
             do_alpha_composite = NULL;
             do_blit = NULL;
         }
@@ -401,6 +440,23 @@ class RawFrameDrawOps {
             do_alpha_blend(f, key, x, y, galpha);
         }
 
+        /* key an overlay that was already converted by PreparedKey */
+        void alpha_key(coord_t x, coord_t y, const PreparedKey &key,
+                uint8_t galpha) {
+            CHECK(do_prepared_key);
+            do_prepared_key(f, key, x, y, galpha);
+        }
+
+        /* 
+         * blend a color (B, G, R, A) into the frame through a w x h
+         * 8-bit coverage mask, such as an antialiased glyph
+         */
+        void coverage_blend(coord_t x, coord_t y, const uint8_t *coverage,
+                coord_t w, coord_t h, size_t pitch, const uint8_t *bgra) {
+            CHECK(do_coverage_blend);
+            do_coverage_blend(f, x, y, coverage, w, h, pitch, bgra);
+        }
+
         void alpha_composite(coord_t x, coord_t y, RawFrame *key,
                 coord_t src_x, coord_t src_y, coord_t w, coord_t h,
                 uint8_t galpha) {
@@ -423,6 +479,13 @@ class RawFrameDrawOps {
         void (*do_alpha_blend)(RawFrame *bkgd, RawFrame *key, 
                 coord_t x, coord_t y, uint8_t galpha);
 
+        void (*do_prepared_key)(RawFrame *bkgd, const PreparedKey &key,
+                coord_t x, coord_t y, uint8_t galpha);
+
+        void (*do_coverage_blend)(RawFrame *dst, coord_t x, coord_t y,
+                const uint8_t *coverage, coord_t w, coord_t h, size_t pitch,
+                const uint8_t *bgra);
+
         void (*do_alpha_composite)(RawFrame *bkgd, RawFrame *key, 
                 coord_t x, coord_t y, uint8_t galpha, 
                 coord_t src_x, coord_t src_y,
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "raw_frame_view.h"
+
+RawFrameView::RawFrameView(const ref<RawFrame> &frame) 
+        : BorrowedRawFrame(frame->pixel_format( )), _target(frame) {
+    borrow(frame->data( ), frame->w( ), frame->h( ), frame->pitch( ));
+    _global_alpha = frame->global_alpha( );
+    _field_dominance = frame->field_dominance( );
+    _capture_time = frame->capture_time( );
+}
+
+RawFrameView::~RawFrameView( ) {
+    /* _target lets go of the pixels */
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _OPENREPLAY_RAW_FRAME_VIEW_H
+#define _OPENREPLAY_RAW_FRAME_VIEW_H
+
+#include "borrowed_raw_frame.h"
+
+/*
+ * A RawFrame showing the pixels of a frame held by a ref<RawFrame>.
+ * It holds a reference of its own, so it can be handed to anything that
+ * takes ownership of a plain RawFrame * (output adapters, ports) and 
+ * deleted there; the pixels go away with the last reference.
+ *
+ * The pixels are shared and must not be written through a view.
+ */
+class RawFrameView : public BorrowedRawFrame {
+    public:
+        RawFrameView(const ref<RawFrame> &frame);
+        virtual ~RawFrameView( );
+
+        const ref<RawFrame> &target( ) const { return _target; }
+
+    protected:
+        ref<RawFrame> _target;
+};
+
+#endif
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "scope.h"
+#include "raw_frame.h"
+#include "cpu_dispatch.h"
+
+#include <string.h>
+#include <stdexcept>
+
+typedef void (*render_row_fn)(uint8_t *dp, const uint8_t *gp, 
+        uint16_t *pp, uint16_t *hp, coord_t n, 
+        unsigned int gain, unsigned int persistence, bool redraw);
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+extern "C" void scope_render_chunk_sse2(uint8_t *dst, 
+        const uint8_t *graticule, uint16_t *persist, uint16_t *hits, 
+        uint64_t n_cells, uint64_t gain, uint64_t persistence,
+        uint64_t redraw);
+#endif
+
+/* x / 255, rounded, for x <= 255 * 255 */
+static inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+/*
+ * Decay the persistence buffer, add the new hits (scaled up by the
+ * gain), clear them, and draw the trace: each cell is a pixel where 
+ * white is composited over the graticule with the cell's brightness.
+ * Unless redraw is set, cells that were and are still dark are skipped.
+ */
+static void render_row_default(uint8_t *dp, const uint8_t *gp, 
+        uint16_t *pp, uint16_t *hp, coord_t n, 
+        unsigned int gain, unsigned int persistence, bool redraw) {
+    uint32_t h, p, d, l;
+
+    for (coord_t i = 0; i < n; i++, dp += 4, gp += 4) {
+        /* 
+         * nothing now and nothing last time: the pixel already 
+         * shows the bare graticule (unless the output is new to us)
+         */
+        if (hp[i] == 0 && pp[i] == 0 && !redraw) {
+            continue;
+        }
+
+        h = (uint32_t) hp[i] << gain;
+        if (h > 0xffff) {
+            h = 0xffff;
+        }
+
+        /* 
+         * decay by at least 1, or the small values that p >> persistence
+         * rounds to zero would never fade out
+         */
+        p = pp[i];
+        d = p >> persistence;
+        if (d == 0) {
+            d = 1;
+        }
+        p = (p > d) ? p - d : 0;
+        p += h;
+        if (p > 0xffff) {
+            p = 0xffff;
+        }
+
+        pp[i] = p;
+        hp[i] = 0;
+
+        l = p >> 4;
+        if (l > 255) {
+            l = 255;
+        }
+
+        dp[0] = gp[0] + div255((255 - gp[0]) * l);
+        dp[1] = gp[1] + div255((255 - gp[1]) * l);
+        dp[2] = gp[2] + div255((255 - gp[2]) * l);
+        dp[3] = gp[3] + div255((255 - gp[3]) * l);
+    }
+}
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+static void render_row_sse2(uint8_t *dp, const uint8_t *gp, 
+        uint16_t *pp, uint16_t *hp, coord_t n, 
+        unsigned int gain, unsigned int persistence, bool redraw) {
+    coord_t n_vec = n & ~7;
+
+    if (n_vec > 0) {
+        scope_render_chunk_sse2(dp, gp, pp, hp, n_vec, gain, persistence,
+                redraw);
+    }
+
+    render_row_default(dp + 4 * n_vec, gp + 4 * n_vec, pp + n_vec, 
+            hp + n_vec, n - n_vec, gain, persistence, redraw);
+}
+#endif
+
+Scope::Scope(RawFrame *graticule_, coord_t x, coord_t y, 
+        coord_t w, coord_t h) {
+
+    if (x + w > graticule_->w( ) || y + h > graticule_->h( )) {
+        throw std::runtime_error("Scope: histogram exceeds graticule");
+    }
+
+    graticule = graticule_->convert->BGRAn8( );
+    outputs.push_back(ref<RawFrame>(graticule->copy( )));
+    current = 0;
+
+    hx = x;
+    hy = y;
+    hw = w;
+    hh = h;
+    hpitch = (w + 7) & ~7;
+
+    hits = new uint16_t[hpitch * hh];
+    persist = new uint16_t[hpitch * hh];
+    persistence = 1;
+    clear( );
+}
+
+Scope::~Scope( ) {
+    delete graticule;
+    delete [] hits;
+    delete [] persist;
+}
+
+void Scope::set_persistence(unsigned int shift) {
+    if (shift > 15) {
+        shift = 15;
+    }
+    persistence = shift;
+}
+
+void Scope::clear( ) {
+    memset(hits, 0, hpitch * hh * sizeof(uint16_t));
+    memset(persist, 0, hpitch * hh * sizeof(uint16_t));
+    samples = 0;
+
+    /* the output may be shared, so draw the bare graticule next time */
+    redraw = true;
+}
+
+/*
+ * A lone hit in a scope averaging one sample per cell or fewer shows at 
+ * quarter brightness. Each doubling of the sample density halves the 
+ * gain, as does each step of persistence (which builds up the trace 
+ * over 2^persistence frames).
+ */
+unsigned int Scope::auto_gain( ) {
+    uint64_t cells = (uint64_t) hw * hh;
+    uint64_t s = samples;
+    unsigned int gain = 10;
+
+    while (gain > 0 && s > cells) {
+        s >>= 1;
+        gain--;
+    }
+
+    return (gain > persistence) ? gain - persistence : 0;
+}
+
+ref<RawFrame> Scope::render( ) {
+    render_row_fn render_row = render_row_default;
+    unsigned int gain = auto_gain( );
+    RawFrame *output;
+
+#ifndef SKIP_ASSEMBLY_ROUTINES
+    if (cpu_sse2_available( )) {
+        render_row = render_row_sse2;
+    }
+#endif
+
+    /* 
+     * Somebody still has the last output. Any spare shows some older
+     * trace, so all of its cells have to be drawn.
+     */
+    if (!outputs[current].unique( )) {
+        for (current = 0; current < outputs.size( ); current++) {
+            if (outputs[current].unique( )) {
+                break;
+            }
+        }
+
+        if (current == outputs.size( )) {
+            outputs.push_back(ref<RawFrame>(graticule->copy( )));
+        }
+
+        redraw = true;
+    }
+
+    output = outputs[current].get( );
+    for (coord_t row = 0; row < hh; row++) {
+        render_row(output->pixel(hx, hy + row), 
+                graticule->pixel(hx, hy + row),
+                persist + hpitch * row, hits + hpitch * row, 
+                hw, gain, persistence, redraw);
+    }
+
+    samples = 0;
+    redraw = false;
+    return outputs[current];
+}
+
+WaveformScope::WaveformScope(RawFrame *graticule) 
+        : Scope(graticule, 20, 0, 240, 128) {
+    for (unsigned int y = 0; y < 256; y++) {
+        row_offset[y] = (hh - 1 - y * hh / 256) * hpitch;
+    }
+}
+
+void WaveformScope::accumulate(RawFrame *src) {
+    if (src->pixel_format( ) != RawFrame::CbYCrY8422) {
+        throw std::runtime_error("WaveformScope: unsupported pixel format");
+    }
+
+    coord_t w = src->w( ) & ~1;
+    coord_t h = src->h( );
+
+    /* map each source column to a histogram column */
+    if (column.size( ) != w) {
+        column.resize(w);
+        for (coord_t x = 0; x < w; x++) {
+            column[x] = (uint32_t) x * hw / w;
+        }
+    }
+
+    for (coord_t line = 0; line < h; line++) {
+        const uint8_t *s = src->scanline(line);
+
+        for (coord_t x = 0; x < w; x += 2, s += 4) {
+            hit(row_offset[s[1]] + column[x]);
+            hit(row_offset[s[3]] + column[x + 1]);
+        }
+    }
+
+    samples += (uint64_t) w * h;
+}
+
+VectorScope::VectorScope(RawFrame *graticule) 
+        : Scope(graticule, 0, 0, 256, 256) {
+}
+
+void VectorScope::accumulate(RawFrame *src) {
+    if (src->pixel_format( ) != RawFrame::CbYCrY8422) {
+        throw std::runtime_error("VectorScope: unsupported pixel format");
+    }
+
+    coord_t w = src->w( ) & ~1;
+    coord_t h = src->h( );
+
+    /* one Cb/Cr pair per two pixels */
+    for (coord_t line = 0; line < h; line++) {
+        const uint8_t *s = src->scanline(line);
+
+        for (coord_t x = 0; x < w; x += 2, s += 4) {
+            hit((size_t) (255 - s[0]) * hpitch + s[2]);
+        }
+    }
+
+    samples += (uint64_t) (w / 2) * h;
+}
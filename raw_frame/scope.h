@@ -0,0 +1,120 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef _OPENREPLAY_SCOPE_H
+#define _OPENREPLAY_SCOPE_H
+
+#include "types.h"
+#include "ref.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class RawFrame;
+
+/*
+ * Base for the waveform and vectorscope engines. accumulate( ) counts
+ * samples of a CbYCrY8422 frame into a 2D hit histogram laid over a
+ * region of the graticule. render( ) folds the hits into a decaying 
+ * persistence buffer, maps that to the brightness of a white trace
+ * drawn over a cached copy of the graticule, and clears the hits for
+ * the next frame.
+ *
+ * render( ) draws into the frame it returned last time unless somebody
+ * else still holds a reference to that; then it switches to a spare
+ * (allocating one the first time), so a consumer can keep a rendered
+ * scope without copying it.
+ *
+ * The trace gain follows the number of samples per histogram cell, so 
+ * the same scope works on a thumbnail or a full-resolution frame.
+ */
+class Scope {
+    public:
+        virtual ~Scope( );
+
+        virtual void accumulate(RawFrame *src) = 0;
+
+        /* Don't write to the returned frame; it may be drawn into again */
+        ref<RawFrame> render( );
+
+        /* 
+         * Each render keeps 1 - 2^-shift of the previous trace. 
+         * Zero disables persistence. Defaults to 1.
+         */
+        void set_persistence(unsigned int shift);
+
+        /* Forget all accumulated hits and persistence. */
+        void clear( );
+
+    protected:
+        /* The graticule is copied; the histogram covers (x, y, w, h) */
+        Scope(RawFrame *graticule, coord_t x, coord_t y, 
+                coord_t w, coord_t h);
+
+        unsigned int auto_gain( );
+
+        /* saturating increment, a full-frame flat field can overflow */
+        inline void hit(size_t offset) {
+            uint16_t v = hits[offset] + 1;
+            hits[offset] = (v != 0) ? v : 0xffff;
+        }
+
+        RawFrame *graticule;
+        std::vector<ref<RawFrame> > outputs;
+        size_t current;             /* index of the output drawn last */
+        bool redraw;                /* current output may show a stale trace */
+        coord_t hx, hy, hw, hh;
+        size_t hpitch;              /* histogram pitch, in cells */
+        uint16_t *hits;
+        uint16_t *persist;
+        uint64_t samples;           /* accumulated since last render */
+        unsigned int persistence;
+
+    private:
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+};
+
+/*
+ * Luma waveform over assets/waveform.svg: 240 columns spanning the 
+ * picture width, 128 rows of luma (top is 255) starting 20 pixels in.
+ */
+class WaveformScope : public Scope {
+    public:
+        WaveformScope(RawFrame *graticule);
+        virtual void accumulate(RawFrame *src);
+
+    protected:
+        size_t row_offset[256];     /* luma -> histogram row offset */
+        std::vector<uint16_t> column;   /* source x -> histogram column */
+};
+
+/*
+ * Cb/Cr vectorscope over assets/vectorscope.svg: one 256x256 cell per
+ * chroma value, Cr across and Cb up.
+ */
+class VectorScope : public Scope {
+    public:
+        VectorScope(RawFrame *graticule);
+        virtual void accumulate(RawFrame *src);
+};
+
+#endif
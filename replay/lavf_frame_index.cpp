@@ -0,0 +1,266 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "lavf_frame_index.h"
+#include "posix_util.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+extern "C" {
+    #include <libavformat/avformat.h>
+    #undef PixelFormat
+}
+
+struct IndexFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t file_size;
+    int64_t mtime;
+    uint64_t n_packets;
+};
+
+static const uint32_t INDEX_VERSION = 1;
+
+LavfFrameIndex::LavfFrameIndex(const char *filename, int video_stream) {
+    struct stat st;
+    std::string path(filename);
+    path += ".idx";
+
+    if (stat(filename, &st) != 0) {
+        throw POSIXError("stat media file");
+    }
+
+    if (!load(path, st.st_size, st.st_mtime)) {
+        scan(filename, video_stream);
+        save(path, st.st_size, st.st_mtime);
+    }
+
+    build( );
+
+    if (presentation.empty( )) {
+        throw std::runtime_error("LavfFrameIndex: no video frames found");
+    }
+}
+
+int64_t LavfFrameIndex::pts(size_t frame) const {
+    return effective_pts(presentation.at(frame));
+}
+
+size_t LavfFrameIndex::keyframe_before(size_t frame) const {
+    size_t target = presentation.at(frame);
+    int64_t target_pts = effective_pts(target);
+
+    /* 
+     * the last keyframe, in decode order, that is presented no later 
+     * than the target. Leading B-frames of a GOP are presented before 
+     * its keyframe, so they start from the GOP before.
+     */
+    for (size_t i = target + 1; i > 0; i--) {
+        if (packets[i - 1].key && effective_pts(i - 1) <= target_pts) {
+            return frame_of_packet[i - 1];
+        }
+    }
+
+    /* no keyframe before it; start from the beginning */
+    return frame_of_packet[0];
+}
+
+int64_t LavfFrameIndex::seek_timestamp(size_t keyframe) const {
+    const Packet &p = packets[presentation.at(keyframe)];
+    return (p.dts != AV_NOPTS_VALUE) ? p.dts : p.pts;
+}
+
+int64_t LavfFrameIndex::seek_position(size_t keyframe) const {
+    return packets[presentation.at(keyframe)].pos;
+}
+
+size_t LavfFrameIndex::frame_at(int64_t ts) const {
+    size_t lo = 0, hi = presentation.size( );
+
+    /* find the first frame presented after ts */
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (effective_pts(presentation[mid]) <= ts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return (lo > 0) ? lo - 1 : 0;
+}
+
+int64_t LavfFrameIndex::effective_pts(size_t packet) const {
+    const Packet &p = packets[packet];
+    if (p.pts != AV_NOPTS_VALUE) {
+        return p.pts;
+    } else if (p.dts != AV_NOPTS_VALUE) {
+        return p.dts;
+    } else {
+        return packet;
+    }
+}
+
+void LavfFrameIndex::build( ) {
+    presentation.resize(packets.size( ));
+    for (size_t i = 0; i < packets.size( ); i++) {
+        presentation[i] = i;
+    }
+
+    std::stable_sort(presentation.begin( ), presentation.end( ),
+        [this](size_t a, size_t b) {
+            return effective_pts(a) < effective_pts(b);
+        }
+    );
+
+    frame_of_packet.resize(packets.size( ));
+    for (size_t i = 0; i < presentation.size( ); i++) {
+        frame_of_packet[presentation[i]] = i;
+    }
+}
+
+void LavfFrameIndex::scan(const char *filename, int video_stream) {
+    AVFormatContext *format_ctx = NULL;
+    AVPacket packet;
+    Packet p;
+
+    if (avformat_open_input(&format_ctx, filename, NULL, NULL) != 0) {
+        throw std::runtime_error("avformat_open_input failed");
+    }
+
+    if (avformat_find_stream_info(format_ctx, NULL) < 0) {
+        avformat_close_input(&format_ctx);
+        throw std::runtime_error("avformat_find_stream_info failed");
+    }
+
+    packets.clear( );
+    while (av_read_frame(format_ctx, &packet) >= 0) {
+        if (packet.stream_index == video_stream) {
+            p.pts = packet.pts;
+            p.dts = packet.dts;
+            p.pos = packet.pos;
+            p.key = (packet.flags & AV_PKT_FLAG_KEY) ? 1 : 0;
+            p.pad = 0;
+            packets.push_back(p);
+        }
+
+        av_free_packet(&packet);
+    }
+
+    avformat_close_input(&format_ctx);
+}
+
+bool LavfFrameIndex::load(
+    const std::string &path, 
+    uint64_t size, 
+    int64_t mtime
+) {
+    IndexFileHeader hdr;
+    struct stat st;
+    int fd;
+
+    fd = open(path.c_str( ), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    if (read_all(fd, &hdr, sizeof(hdr)) != 1
+            || memcmp(hdr.magic, "ORFI", 4) != 0
+            || hdr.version != INDEX_VERSION
+            || hdr.file_size != size
+            || hdr.mtime != mtime
+            || hdr.n_packets == 0) {
+        close(fd);
+        return false;
+    }
+
+    /* 
+     * a truncated or corrupt index must not make us allocate whatever
+     * n_packets says: it has to match what's actually in the file
+     */
+    if (fstat(fd, &st) != 0 
+            || (uint64_t) st.st_size < sizeof(hdr)
+            || hdr.n_packets != (st.st_size - sizeof(hdr)) / sizeof(Packet)
+            || (st.st_size - sizeof(hdr)) % sizeof(Packet) != 0) {
+        fprintf(stderr, "LavfFrameIndex: %s is stale or corrupt\n", 
+                path.c_str( ));
+        close(fd);
+        return false;
+    }
+
+    packets.resize(hdr.n_packets);
+    if (read_all(fd, &packets[0], packets.size( ) * sizeof(Packet)) != 1) {
+        packets.clear( );
+        close(fd);
+        return false;
+    }
+
+    close(fd);
+    return true;
+}
+
+void LavfFrameIndex::save(
+    const std::string &path, 
+    uint64_t size, 
+    int64_t mtime
+) {
+    IndexFileHeader hdr;
+    std::string tmp_path = path + ".tmp";
+    int fd;
+
+    if (packets.empty( )) {
+        return;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "ORFI", 4);
+    hdr.version = INDEX_VERSION;
+    hdr.file_size = size;
+    hdr.mtime = mtime;
+    hdr.n_packets = packets.size( );
+
+    /* the index is only a cache, so failing to write it is not fatal */
+    fd = open(tmp_path.c_str( ), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror("LavfFrameIndex: open index file");
+        return;
+    }
+
+    if (write_all(fd, &hdr, sizeof(hdr)) != 1 || write_all(fd, 
+            &packets[0], packets.size( ) * sizeof(Packet)) != 1) {
+        perror("LavfFrameIndex: write index file");
+        close(fd);
+        unlink(tmp_path.c_str( ));
+        return;
+    }
+
+    close(fd);
+
+    if (rename(tmp_path.c_str( ), path.c_str( )) != 0) {
+        perror("LavfFrameIndex: rename index file");
+        unlink(tmp_path.c_str( ));
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _LAVF_FRAME_INDEX_H
+#define _LAVF_FRAME_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <string>
+
+/*
+ * Maps frame numbers in a media file to the packets needed to decode 
+ * them. The video stream's packets are scanned once. The result is
+ * saved alongside the file (as <file>.idx) and reloaded as long as
+ * the file's size and modification time still match.
+ *
+ * Frame numbers count frames in presentation order, from zero.
+ * Timestamps are in the video stream's time base.
+ */
+class LavfFrameIndex {
+    public:
+        LavfFrameIndex(const char *filename, int video_stream);
+
+        size_t frames( ) const { return presentation.size( ); }
+
+        /* presentation timestamp of frame n */
+        int64_t pts(size_t frame) const;
+
+        /* the last keyframe that decoding can start from to reach frame n */
+        size_t keyframe_before(size_t frame) const;
+
+        /* timestamp and byte position to seek to for that keyframe */
+        int64_t seek_timestamp(size_t keyframe) const;
+        int64_t seek_position(size_t keyframe) const;
+
+        /* frame presented at or just before the given timestamp */
+        size_t frame_at(int64_t pts) const;
+
+    protected:
+        struct Packet {
+            int64_t pts;
+            int64_t dts;
+            int64_t pos;
+            uint32_t key;
+            uint32_t pad;
+        };
+
+        bool load(const std::string &path, uint64_t size, int64_t mtime);
+        void save(const std::string &path, uint64_t size, int64_t mtime);
+        void scan(const char *filename, int video_stream);
+        void build( );
+        int64_t effective_pts(size_t packet) const;
+
+        /* video packets, in decode order */
+        std::vector<Packet> packets;
+
+        /* packet index for each frame, in presentation order */
+        std::vector<size_t> presentation;
+
+        /* and the frame number of each packet */
+        std::vector<size_t> frame_of_packet;
+};
+
+#endif
@@ -18,10 +18,13 @@
 %include "replay_playout.i"
 %include "replay_ingest.i"
 %include "replay_mjpeg_ingest.i"
+%include "replay_net_ingest.i"
+%include "replay_ingest_scheduler.i"
 %include "replay_audio_ingest.i"
 %include "replay_gamedata.i"
 %include "replay_playout_filter.i"
 %include "replay_playout_image_filter.i"
+%include "replay_scope_filter.i"
 %include "replay_playout_lavf_source.i"
 %include "rollout_preview.i"
 
@@ -25,6 +25,13 @@ module Replay
             fail "need map" unless chmap
 
             @ingest = ReplayAudioIngest.new(input)
+            if opts[:fft_size] || opts[:fft_hop]
+                # e.g. :fft_hop => 256 halves CPU and disk use
+                @ingest.set_vocoder_parameters(
+                    opts[:fft_size] || 1024, opts[:fft_hop] || 128
+                )
+            end
+
             @buffers = { }
             chmap.each_pair do |channel, file|
                 buf = ReplayBuffer.new(file)
@@ -43,6 +50,7 @@ module Replay
         def initialize(opts={})
             input = opts[:input]
             mjpeg_cmd = opts[:mjpeg_cmd]
+            net_listen = opts[:net_listen]
             file = opts[:file] || fail("Cannot have a source with no file")
             name = opts[:name] || file
             game_data = opts[:game_data] || \
@@ -53,12 +61,39 @@ module Replay
             @buffer = ReplayBuffer.new(file, name)
 
             if input
-                @ingest = ReplayIngest.new(input, @buffer, game_data)
+                # capture queue tuning: must happen before ingest starts
+                input.set_zero_copy(true) if opts[:zero_copy]
+                input.set_queue_depth(opts[:queue_depth]) if opts[:queue_depth]
+                if opts[:drop_policy] == :oldest
+                    input.set_drop_policy(InputAdapter::DROP_OLDEST)
+                elsif opts[:drop_policy] == :newest
+                    input.set_drop_policy(InputAdapter::DROP_NEWEST)
+                end
+
+                if opts[:scheduler]
+                    @ingest = opts[:scheduler].add_source(input, @buffer, 
+                            game_data)
+                else
+                    @ingest = ReplayIngest.new(input, @buffer, game_data)
+                end
             elsif mjpeg_cmd
                 @ingest = ReplayMjpegIngest.new(mjpeg_cmd, @buffer)
+            elsif net_listen
+                @ingest = ReplayNetIngest.new(net_listen, @buffer)
             else
                 fail "need some input source"
             end
+
+            if opts[:thumbnail_interval]
+                @ingest.set_thumbnail_interval(opts[:thumbnail_interval])
+            end
+
+            # keep the senders referenced so Ruby doesn't collect them
+            @senders = [opts[:net_send]].flatten.compact.map do |addr|
+                sender = ReplayNetSender.new(addr)
+                @ingest.add_sender(sender)
+                sender
+            end
         end
 
         def channel_map
@@ -77,6 +112,16 @@ module Replay
             @ingest.resume_encode
         end
 
+        def ingest_stats
+            {
+                :dropped_frames => @ingest.dropped_frames,
+                :backlog_frames => @ingest.backlog_frames,
+                :backlog_age => @ingest.backlog_age,
+                :max_backlog_age => @ingest.max_backlog_age,
+                :thumbnails_skipped => @ingest.thumbnails_skipped
+            }
+        end
+
         def make_shot_now
             @ingest.trigger     # trigger buffer dump from remote camera
             @buffer.make_shot(0, ReplayBuffer::END)
@@ -125,6 +170,7 @@ module Replay
             params.source = opts[:port] || fail("Need some kind of input")
             params.x = opts[:x] || 0
             params.y = opts[:y] || 0
+            params.scopes = opts[:scopes]
 
             real_add_source(params)
         end
@@ -190,7 +236,7 @@ module Replay
             @sources = []
             @audio_sources = []
 
-            @dpys = FramebufferDisplaySurface.new
+            @dpys = BufferedFramebufferDisplaySurface.new
             @multiviewer = ReplayMultiviewer.new(@dpys)
 
             config = ReplayConfig.new # something something something
@@ -199,11 +245,15 @@ module Replay
             @program = ReplayPlayout.new(config.make_output_adapter)
             @preview = ReplayPreview.new
 
+            # scopes on the full resolution program video
+            @program_scopes = ReplayScopeFilter.new
+            @program.register_filter(@program_scopes)
+
             # wire program and preview into multiviewer
             @multiviewer.add_source(:port => @preview.monitor,
                     :x => 0, :y => 0)
             @multiviewer.add_source(:port => @program.monitor,
-                    :x => 960, :y => 0)
+                    :x => 960, :y => 0, :scopes => @program_scopes)
 
 
             # FIXME hard coded defaults
@@ -213,6 +263,14 @@ module Replay
             @mvx = 0
             @mvy = 540
             @filters = []
+            @outputs = []
+        end
+
+        # another program feed (e.g. clean next to dirty) from the same
+        # decoded frames; returns an id for add_png_file_dsk
+        def add_output(adapter)
+            @outputs << @program.add_output(adapter)
+            return @outputs.length
         end
 
         def toggle_filter(fid)
@@ -230,15 +288,26 @@ module Replay
             @multiviewer.change_mode
         end
 
-        def add_png_file_dsk(png, x, y)
+        def add_png_file_dsk(png, x, y, output=0)
             filter = ReplayPlayoutImageFilter.from_png(png, x, y)
-            @program.register_filter(filter)
+            if output == 0
+                @program.register_filter(filter)
+            else
+                @outputs[output - 1].register_filter(filter)
+            end
             @filters << filter
             return @filters.length - 1
         end
 
         def add_source(opts={})
             opts.merge!({ :game_data => @game_data })
+
+            # cameras share one encoder pool unless told otherwise
+            unless opts[:dedicated_encoder]
+                @ingest_scheduler ||= ReplayIngestScheduler.new
+                opts.merge!({ :scheduler => @ingest_scheduler })
+            end
+
             source = ReplaySource.new(opts)
             @sources << source
 
@@ -18,33 +18,50 @@
  */
 
 #include "replay_audio_buffer_playout.h"
+#include <algorithm>
 #include <iostream>
 
 ReplayAudioBufferPlayout::ReplayAudioBufferPlayout( ) {
     max_channel_no = 0;
+}
 
-    /*
-     * FIXME
-     * these need to agree between playout and ingest, but they're
-     * defined separately in both places.
-     */
-    fft_size = 1024;
-    fft_hop = 128;
-    scale_factor = float(fft_hop) / (float(fft_size) * float(fft_size));
-
-    initialize_fft( );
+/*
+ * (Re)initialize synthesis for a channel. The vocoder parameters come
+ * from the buffer itself, so they always agree with what ingest used.
+ */
+void ReplayAudioBufferPlayout::configure_channel(
+    channel_data &ch,
+    const ReplayVocoderConfig &cfg
+) {
+    size_t fft_size = cfg.fft_size( );
+
+    free_channel(ch);
+
+    ch.config = cfg;
+    ch.ifft = new FFT<float>(fft_size, FFT<float>::INVERSE);
+    ch.window = new float[fft_size];
+    cfg.make_window(ch.window);
+    ch.scale_factor = cfg.synthesis_scale( );
+    ch.ifft_result = new std::complex<float>[fft_size];
+    ch.phase_accumulator = new std::complex<float>[fft_size];
+    ch.overlap_add_buffer = new float[fft_size];
+    std::fill(ch.overlap_add_buffer, ch.overlap_add_buffer + fft_size, 0.0f);
 }
 
-void ReplayAudioBufferPlayout::initialize_fft( ) {
-    ifft = new FFT<float>(fft_size, FFT<float>::INVERSE);
-    ifft_result = new std::complex<float>[fft_size];
-    ifft_realpart = new float[fft_size];
+void ReplayAudioBufferPlayout::free_channel(channel_data &ch) {
+    if (ch.ifft != NULL) {
+        delete ch.ifft;
+        delete [] ch.window;
+        delete [] ch.ifft_result;
+        delete [] ch.phase_accumulator;
+        delete [] ch.overlap_add_buffer;
+        ch.ifft = NULL;
+    }
 }
 
 void ReplayAudioBufferPlayout::clear_channel_map( ) {
     for (channel_data &ch : channel_map) {
-        delete [] ch.phase_accumulator;
-        delete [] ch.overlap_add_buffer;
+        free_channel(ch);
         delete ch.fifo;
     }
 
@@ -53,10 +70,6 @@ void ReplayAudioBufferPlayout::clear_channel_map( ) {
 
 ReplayAudioBufferPlayout::~ReplayAudioBufferPlayout( ) {
     clear_channel_map( );
-
-    delete [] ifft_result;
-    delete [] ifft_realpart;
-    delete ifft;
 }
 
 void ReplayAudioBufferPlayout::set_position(uint64_t timestamp) {
@@ -86,8 +99,7 @@ void ReplayAudioBufferPlayout::map_channel(
     /* no mapping exists for this channel, so add it */
     chnew.channel_no = channel_no;
     chnew.buf = buf;
-    chnew.phase_accumulator = new std::complex<float>[fft_size];
-    chnew.overlap_add_buffer = new float[fft_size];
+    chnew.ifft = NULL;
     chnew.fifo = new AudioFIFO<float>;
 
     channel_map.push_back(chnew);
@@ -138,16 +150,35 @@ static void numarray_dump(T *array, size_t n) {
 void ReplayAudioBufferPlayout::synthesize_samples(channel_data &ch) {
     BlockSet bset;
     std::complex<float> *frame_data;
+    ReplayVocoderConfig *cfg;
     size_t count;
     timecode_t frame = ch.origin_timecode + ch.pos_offset.integer_part( );
      
-    /* load FFT frame from buffer file */
+    /* load FFT frame and its parameters from buffer file */
     ch.buf->read_blockset(frame, bset);
+    if (bset.have_block(REPLAY_PVOC_CONFIG_BLOCK)) {
+        cfg = bset.load_alloc_object<ReplayVocoderConfig>(
+            REPLAY_PVOC_CONFIG_BLOCK
+        );
+    } else {
+        /* recorded before the parameters were stored */
+        cfg = new ReplayVocoderConfig(ReplayVocoderConfig::legacy( ));
+    }
+
+    if (ch.ifft == NULL || ch.config != *cfg) {
+        configure_channel(ch, *cfg);
+    }
+    delete cfg;
+
+    size_t fft_size = ch.config.fft_size( );
+    size_t fft_hop = ch.config.fft_hop( );
+
     frame_data = bset.load_alloc_block<std::complex<float> >(
         REPLAY_PVOC_BLOCK, count
     );
     
     if (count != fft_size) {
+        delete [] frame_data;
         throw std::runtime_error("FFT size mismatch");
     }
 
@@ -162,11 +193,12 @@ void ReplayAudioBufferPlayout::synthesize_samples(channel_data &ch) {
     delete [] frame_data;
 
     /* compute the inverse FFT */
-    ifft->compute(ifft_result, ch.phase_accumulator);
+    ch.ifft->compute(ch.ifft_result, ch.phase_accumulator);
 
-    /* now get real part, scale, and overlap-add */
+    /* now get real part, apply synthesis window, scale, and overlap-add */
     for (size_t i = 0; i < fft_size; i++) {
-        ch.overlap_add_buffer[i] += std::real(ifft_result[i]) * scale_factor;
+        ch.overlap_add_buffer[i] += std::real(ch.ifft_result[i]) 
+            * ch.window[i] * ch.scale_factor;
     }
 
     /* shift off first fft_hop samples from overlap_add_buffer into fifo */
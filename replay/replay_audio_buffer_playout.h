@@ -24,6 +24,7 @@
 #include "packed_audio_packet.h"
 #include "audio_fifo.h"
 #include "replay_buffer.h"
+#include "replay_vocoder_config.h"
 #include "rational.h"
 #include <complex>
 #include <vector>
@@ -45,20 +46,26 @@ class ReplayAudioBufferPlayout {
             ReplayBuffer *buf;
             Rational pos_offset;
 
+            /* 
+             * synthesis state, set up by configure_channel( ) using 
+             * the parameters read from the buffer
+             */
+            ReplayVocoderConfig config;
+            FFT<float> *ifft;
+            float *window;
+            float scale_factor;
+            std::complex<float> *ifft_result;
             std::complex<float> *phase_accumulator;
             float *overlap_add_buffer;
             AudioFIFO<float> *fifo;
         };
         
-        FFT<float> *ifft;
-        std::complex<float> *ifft_result;
-        float *ifft_realpart;
         std::vector<channel_data> channel_map;
         unsigned int max_channel_no;
-        size_t fft_size, fft_hop;
-        float scale_factor;
 
-        void initialize_fft( );
+        void configure_channel(channel_data &ch, 
+                const ReplayVocoderConfig &cfg);
+        void free_channel(channel_data &ch);
         void synthesize_samples(channel_data &ch);
 };
 
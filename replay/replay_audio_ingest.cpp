@@ -27,7 +27,8 @@ ReplayAudioIngest::ReplayAudioIngest(InputAdapter *iadp) {
     pipe = iadp->audio_output_pipe( );
     running = false;
     stop = false;
-    set_fft_parameters( );
+    fft = NULL;
+    set_fft_parameters(ReplayVocoderConfig( ));
 
     iadp->start( );
 }
@@ -40,7 +41,8 @@ ReplayAudioIngest::ReplayAudioIngest(Pipe<IOAudioPacket *> *ipipe) {
     pipe = ipipe;
     running = false;
     stop = false;
-    set_fft_parameters( );
+    fft = NULL;
+    set_fft_parameters(ReplayVocoderConfig( ));
 }
 
 ReplayAudioIngest::~ReplayAudioIngest( ) {
@@ -53,6 +55,8 @@ ReplayAudioIngest::~ReplayAudioIngest( ) {
         delete [] e.last_frame;
         delete e.fifo;
     }
+
+    free_fft_parameters( );
 } 
 
 void ReplayAudioIngest::start( ) {
@@ -60,13 +64,42 @@ void ReplayAudioIngest::start( ) {
     start_thread( );
 }
 
-void ReplayAudioIngest::set_fft_parameters( ) {
-    fft_size = 1024;
-    fft_hop = 128;
+void ReplayAudioIngest::set_vocoder_parameters(
+    unsigned int size,
+    unsigned int hop
+) {
+    if (running || !channel_map.empty( )) {
+        throw std::runtime_error(
+            "set vocoder parameters before mapping channels"
+        );
+    }
+
+    set_fft_parameters(ReplayVocoderConfig(size, hop));
+}
+
+void ReplayAudioIngest::set_fft_parameters(const ReplayVocoderConfig &cfg) {
+    cfg.validate( );
+    free_fft_parameters( );
+
+    config = cfg;
+    fft_size = config.fft_size( );
+    fft_hop = config.fft_hop( );
+
     window = new float[fft_size];
+    config.make_window(window);
+    windowed_input = new float[fft_size];
     fft = new FFT<float>(fft_size);
     output_frame = new std::complex<float>[fft_size];
-    /* FIXME: need to actually create a window function and use it... */
+}
+
+void ReplayAudioIngest::free_fft_parameters( ) {
+    if (fft != NULL) {
+        delete fft;
+        delete [] window;
+        delete [] windowed_input;
+        delete [] output_frame;
+        fft = NULL;
+    }
 }
 
 
@@ -134,8 +167,12 @@ void ReplayAudioIngest::emit_frame(channel_entry &ch) {
         throw std::runtime_error("cannot emit frame, not enough samples");
     }
 
-    /* take FFT of ch.fifo->data( ) into ch.current_frame */
-    fft->compute(ch.current_frame, ch.fifo->data( ));
+    /* apply analysis window, then FFT into ch.current_frame */
+    const float *samples = ch.fifo->data( );
+    for (i = 0; i < fft_size; i++) {
+        windowed_input[i] = samples[i] * window[i];
+    }
+    fft->compute(ch.current_frame, windowed_input);
 
     /* subtract phase of last_frame from phase of current_frame to get output_frame */
     for (i = 0; i < fft_size; i++) {
@@ -153,6 +190,7 @@ void ReplayAudioIngest::emit_frame(channel_entry &ch) {
 
     /* write output_frame to buffer */
     bset.add_block(REPLAY_PVOC_BLOCK, output_frame, fft_size);
+    bset.add_object(REPLAY_PVOC_CONFIG_BLOCK, config);
     bset.add_block("Debug001", ch.fifo->data( ), fft_size);
     ch.buffer->write_blockset(bset);
     ch.fifo->pop_samples(fft_hop);
@@ -25,6 +25,7 @@
 #include "thread.h"
 #include "pipe.h"
 #include "replay_buffer.h"
+#include "replay_vocoder_config.h"
 #include "ajfft.h"
 #include "adapter.h"
 #include <vector>
@@ -42,6 +43,15 @@ class ReplayAudioIngest : public Thread {
          */
         void map_channel(unsigned int channel_no, ReplayBuffer *buffer);
 
+        /*
+         * change the FFT size and hop used for analysis. Must be called
+         * before any channels are mapped. The parameters are recorded in
+         * the buffer with each frame, so playout picks them up from there.
+         * Larger hops cost less CPU and disk at some loss of quality.
+         */
+        void set_vocoder_parameters(unsigned int fft_size, 
+                unsigned int fft_hop);
+
         /*
          * start worker thread
          */
@@ -65,15 +75,18 @@ class ReplayAudioIngest : public Thread {
         };
 
         void run_thread( );
-        void set_fft_parameters( );
+        void set_fft_parameters(const ReplayVocoderConfig &cfg);
+        void free_fft_parameters( );
         void process_packet(IOAudioPacket *pkt);
         void emit_frame(channel_entry &ch);
 
 
         Pipe<IOAudioPacket *> *pipe;
         std::vector<channel_entry> channel_map;
+        ReplayVocoderConfig config;
         FFT<float> *fft;
         float *window;
+        float *windowed_input;
         size_t fft_size, fft_hop;
 
         std::complex<float> *output_frame;
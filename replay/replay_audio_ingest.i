@@ -28,6 +28,7 @@ class ReplayAudioIngest : public Thread {
         ~ReplayAudioIngest( );
 
         void map_channel(unsigned int, ReplayBuffer *INPUT);
+        void set_vocoder_parameters(unsigned int, unsigned int);
         void start( );
 };
 
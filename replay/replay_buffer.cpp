@@ -31,6 +31,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdexcept>
+#include <string>
 
 ReplayBuffer::ReplayBuffer(const char *path, const char *name) {
     struct stat stat;
@@ -63,6 +64,18 @@ ReplayBuffer::ReplayBuffer(const char *path, const char *name) {
     }
 
     index = new ReplayBufferIndex;
+
+    /* 
+     * side file for thumbnails written after the fact; the index starts
+     * out empty, so whatever an earlier run left there is meaningless
+     */
+    std::string thumb_path(path);
+    thumb_path += ".thumbs";
+    thumb_fd = open(thumb_path.c_str( ), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (thumb_fd < 0) {
+        throw POSIXError("open thumbnails");
+    }
+    thumb_bytes_written = 0;
 }
 
 ReplayBuffer::~ReplayBuffer( ) {
@@ -70,6 +83,8 @@ ReplayBuffer::~ReplayBuffer( ) {
         throw POSIXError("close");
     }
 
+    close(thumb_fd);
+
     /* 
      * we deliberately do not delete writer here, that is the responsibility
      * of the user of the writer. The pointer is only kept around in 
@@ -156,10 +171,16 @@ ReplayFrameData *ReplayBuffer::read_frame(timecode_t frame, int flags) {
     }
 
     if (flags & LOAD_THUMBNAIL) {
-        ret->thumbnail_data = blkset.load_alloc_block<uint8_t>(
-            REPLAY_THUMBNAIL_BLOCK, 
-            ret->thumbnail_size
-        );
+        if (blkset.have_block(REPLAY_THUMBNAIL_BLOCK)) {
+            ret->thumbnail_data = blkset.load_alloc_block<uint8_t>(
+                REPLAY_THUMBNAIL_BLOCK, 
+                ret->thumbnail_size
+            );
+        } else if (!read_thumbnail(frame, ret->thumbnail_data, 
+                ret->thumbnail_size)) {
+            delete ret;
+            throw std::runtime_error("No thumbnail available for frame");
+        }
     }
 
     if (flags & LOAD_AUDIO) {
@@ -187,6 +208,77 @@ ReplayFrameData *ReplayBuffer::read_frame(timecode_t frame, int flags) {
     return ret;
 }
 
+/* 
+ * One entry per frame, so the map and the side file are bounded by the
+ * number of frames in the buffer. A frame given a new thumbnail reuses
+ * its old space in the side file when the new one fits there.
+ */
+void ReplayBuffer::write_thumbnail(timecode_t frame, 
+        const void *data, size_t size) {
+    std::map<timecode_t, ThumbnailEntry>::iterator i;
+    ThumbnailEntry entry;
+    bool append;
+    ssize_t ret;
+
+    if (frame < 0 || frame >= index->get_length( )) {
+        throw ReplayFrameNotFoundException( );
+    }
+
+    MutexLock l(thumb_lock);
+
+    i = thumbnails.find(frame);
+    append = (i == thumbnails.end( ) || size > i->second.capacity);
+    if (!append) {
+        entry = i->second;
+    } else {
+        entry.offset = thumb_bytes_written;
+        entry.capacity = size;
+    }
+    entry.size = size;
+
+    ret = pwrite(thumb_fd, data, size, entry.offset);
+    if (ret < 0) {
+        throw POSIXError("pwrite thumbnail");
+    } else if ((size_t) ret != size) {
+        throw std::runtime_error("short write on thumbnail");
+    }
+
+    if (append) {
+        thumb_bytes_written += size;
+    }
+    thumbnails[frame] = entry;
+}
+
+/* find the last thumbnail at or before frame; data is allocated by new[] */
+bool ReplayBuffer::read_thumbnail(timecode_t frame, 
+        uint8_t *&data, size_t &size) {
+    std::map<timecode_t, ThumbnailEntry>::iterator i;
+    ThumbnailEntry entry;
+    ssize_t ret;
+
+    { MutexLock l(thumb_lock);
+        i = thumbnails.upper_bound(frame);
+        if (i == thumbnails.begin( )) {
+            return false;
+        }
+        --i;
+        entry = i->second;
+    }
+
+    data = new uint8_t[entry.size];
+    size = entry.size;
+
+    ret = pread(thumb_fd, data, size, entry.offset);
+    if (ret < 0 || (size_t) ret != size) {
+        delete [] data;
+        data = NULL;
+        size = 0;
+        return false;
+    }
+
+    return true;
+}
+
 timecode_t ReplayBuffer::write_frame(const ReplayFrameData &data) {
     BlockSet blkset;
 
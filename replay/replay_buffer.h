@@ -28,6 +28,7 @@
 #include "block_set.h"
 
 #include <stdexcept>
+#include <map>
 
 #define REPLAY_VIDEO_BLOCK "ReplJpeg"
 #define REPLAY_THUMBNAIL_BLOCK "ReplThum"
@@ -55,6 +56,13 @@ class ReplayBuffer {
         void read_blockset(timecode_t frame, BlockSet &blkset);
         timecode_t write_blockset(const BlockSet &blkset);
 
+        /* 
+         * Thumbnails may be written some time after their frame, and not 
+         * every frame has one. They live in a side file next to the 
+         * buffer; read_frame falls back to the nearest earlier one.
+         */
+        void write_thumbnail(timecode_t frame, const void *data, size_t size);
+
         RawFrame::FieldDominance field_dominance( ) { return _field_dominance; }
         void set_field_dominance(RawFrame::FieldDominance dom) { _field_dominance = dom; }
 
@@ -74,6 +82,19 @@ class ReplayBuffer {
         char *name;
         char *path;
         int fd;
+
+        struct ThumbnailEntry {
+            off_t offset;
+            size_t size;
+            size_t capacity;    /* space reserved in the side file */
+        };
+
+        bool read_thumbnail(timecode_t frame, uint8_t *&data, size_t &size);
+
+        Mutex thumb_lock;
+        std::map<timecode_t, ThumbnailEntry> thumbnails;
+        int thumb_fd;
+        off_t thumb_bytes_written;
 };
 
 #endif
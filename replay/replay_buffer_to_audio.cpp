@@ -26,6 +26,9 @@
 #include "posix_util.h"
 #include "ajfft.h"
 #include "block_set.h"
+#include "replay_vocoder_config.h"
+#include <algorithm>
+#include <stdexcept>
 
 #define REPLAY_PVOC_BLOCK "ReplPvoc"
 
@@ -66,13 +69,16 @@ int main(int argc, const char **argv) {
 void process(int input_fd, int output_fd) {
     off_t current_offset = 0;
     std::complex<float> *frame_data = NULL;
-    std::complex<float> *last_frame_data = NULL;
+    std::complex<float> *phase_accumulator = NULL;
 
     size_t count = 0;
-    size_t frame_count = 0, hop_factor = 8;
+    size_t fft_size = 0, fft_hop = 0;
 
+    ReplayVocoderConfig config;
     FFT<float> *ifft = NULL;
     std::complex<float> *ifft_result = NULL;
+    float *window = NULL;
+    float *overlap_add_buffer = NULL;
     int16_t *samples = NULL;
     float scale_factor = 1.0;
 
@@ -80,17 +86,38 @@ void process(int input_fd, int output_fd) {
         BlockSet blkset;
         try {
             blkset.begin_read(input_fd, current_offset);
-            delete [] last_frame_data;
-            last_frame_data = frame_data;
+            delete [] frame_data;
             frame_data = blkset.load_alloc_block<std::complex<float> >(REPLAY_PVOC_BLOCK, count);
 
             if (ifft == NULL) {
-                ifft = new FFT<float>(count, FFT<float>::INVERSE);
-                ifft_result = new std::complex<float>[count];
-                samples = new int16_t[count];
-                scale_factor = float(count) * float(hop_factor);
+                if (blkset.have_block(REPLAY_PVOC_CONFIG_BLOCK)) {
+                    ReplayVocoderConfig *cfg = 
+                        blkset.load_alloc_object<ReplayVocoderConfig>(
+                            REPLAY_PVOC_CONFIG_BLOCK
+                        );
+                    config = *cfg;
+                    delete cfg;
+                } else {
+                    config = ReplayVocoderConfig::legacy( );
+                }
+
+                fft_size = config.fft_size( );
+                fft_hop = config.fft_hop( );
+                ifft = new FFT<float>(fft_size, FFT<float>::INVERSE);
+                ifft_result = new std::complex<float>[fft_size];
+                phase_accumulator = new std::complex<float>[fft_size];
+                window = new float[fft_size];
+                config.make_window(window);
+                overlap_add_buffer = new float[fft_size];
+                std::fill(overlap_add_buffer, 
+                        overlap_add_buffer + fft_size, 0.0f);
+                samples = new int16_t[fft_hop];
+                scale_factor = config.synthesis_scale( );
             }
 
+            if (count != fft_size) {
+                throw std::runtime_error("FFT size mismatch");
+            }
         } catch (...) {
             /* 
              * if it bombs out we are probably past end of file but who knows
@@ -104,36 +131,37 @@ void process(int input_fd, int output_fd) {
         }
 
         /* 
-         * phase information is stored as a delta from last_frame_data.
-         * If last_frame_data is not NULL, we add the phase values into
-         * those in frame_data.
+         * phase information is stored as a delta from the previous frame,
+         * so accumulate it to recover absolute phase.
          */
-        if (last_frame_data != NULL) {
-            for (size_t i = 0; i < count; i++) {
-                frame_data[i] = std::polar(
-                    std::abs(frame_data[i]),
-                    std::arg(frame_data[i]) + std::arg(last_frame_data[i])
-                );
-            }
+        for (size_t i = 0; i < count; i++) {
+            phase_accumulator[i] = std::polar(
+                std::abs(frame_data[i]),
+                std::arg(phase_accumulator[i]) + std::arg(frame_data[i])
+            );
         }
 
         /* 
-         * now if frame_count % hop_factor == 0, take the IFFT.
-         * This should yield a block of (approximately) original
-         * audio data.
+         * take the IFFT, window and overlap-add. Every frame then 
+         * yields fft_hop finished samples.
          */
-        if (frame_count % hop_factor == 0) {
-            ifft->compute(ifft_result, frame_data); 
+        ifft->compute(ifft_result, phase_accumulator); 
 
-            /* take real part and scale as needed */
-            for (size_t i = 0; i < count; i++) {
-                samples[i] = std::real(ifft_result[i]) / scale_factor;
-            }
+        for (size_t i = 0; i < count; i++) {
+            overlap_add_buffer[i] += std::real(ifft_result[i]) 
+                * window[i] * scale_factor;
+        }
 
-            write_all(output_fd, samples, count * sizeof(*samples));
+        for (size_t i = 0; i < fft_hop; i++) {
+            samples[i] = overlap_add_buffer[i];
         }
+        write_all(output_fd, samples, fft_hop * sizeof(*samples));
+
+        std::copy(overlap_add_buffer + fft_hop, 
+                overlap_add_buffer + fft_size, overlap_add_buffer);
+        std::fill(overlap_add_buffer + fft_size - fft_hop, 
+                overlap_add_buffer + fft_size, 0.0f);
 
-        frame_count++;
         current_offset = blkset.end_offset( );
     }
 }
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "replay_frame_ring.h"
+#include "borrowed_raw_frame.h"
+#include "xmalloc.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* A RawFrame whose buffer belongs to a ring. */
+class ReplayFrameRing::Frame : public BorrowedRawFrame {
+    public:
+        /* data( ) is NULL if the pool had nothing to give */
+        Frame(const ref<Pool> &pool_, coord_t w, coord_t h, PixelFormat pf)
+                : BorrowedRawFrame(pf), pool(pool_) {
+            size_t pitch = pixel_size( ) * w;
+            borrow(pool->take(h * pitch), w, h, pitch);
+        }
+
+        ~Frame( ) {
+            if (_data) {
+                pool->give(_data);
+            }
+        }
+
+    protected:
+
+        ref<Pool> pool;
+};
+
+ReplayFrameRing::Pool::Pool(unsigned int size) {
+    buf_size = 0;
+    capacity = size;
+    allocated = 0;
+    misses = 0;
+    /* room to hand every buffer back without allocating */
+    free_bufs.reserve(size);
+}
+
+ReplayFrameRing::Pool::~Pool( ) {
+    for (unsigned i = 0; i < free_bufs.size( ); i++) {
+        free(free_bufs[i]);
+    }
+}
+
+/* returns NULL if the caller should allocate for itself */
+uint8_t *ReplayFrameRing::Pool::take(size_t size) {
+    uint8_t *ret;
+    MutexLock l(mut);
+
+    if (buf_size == 0) {
+        buf_size = size;
+    }
+
+    if (size != buf_size) {
+        misses++;
+        return NULL;
+    } else if (!free_bufs.empty( )) {
+        ret = free_bufs.back( );
+        free_bufs.pop_back( );
+        return ret;
+    } else if (allocated < capacity) {
+        ret = (uint8_t *) xmalloc(buf_size, "ReplayFrameRing", "buf");
+        allocated++;
+        return ret;
+    } else {
+        misses++;
+        return NULL;
+    }
+}
+
+void ReplayFrameRing::Pool::give(uint8_t *buf) {
+    MutexLock l(mut);
+    free_bufs.push_back(buf);
+}
+
+ReplayFrameRing::ReplayFrameRing(unsigned int size) 
+        : pool(new Pool(size)) {
+
+}
+
+ReplayFrameRing::~ReplayFrameRing( ) {
+    /* outstanding frames keep the pool alive */
+}
+
+RawFrame *ReplayFrameRing::get(coord_t w, coord_t h, 
+        RawFrame::PixelFormat pf) {
+    Frame *ret = new Frame(pool, w, h, pf);
+    if (ret->data( ) == NULL) {
+        delete ret;
+        return new RawFrame(w, h, pf);
+    }
+    return ret;
+}
+
+RawFrame *ReplayFrameRing::clone(RawFrame *f) {
+    RawFrame *ret = get(f->w( ), f->h( ), f->pixel_format( ));
+
+    if (f->pitch( ) == ret->pitch( )) {
+        memcpy(ret->data( ), f->data( ), f->size( ));
+    } else {
+        for (coord_t y = 0; y < f->h( ); y++) {
+            memcpy(ret->scanline(y), f->scanline(y), ret->pitch( ));
+        }
+    }
+
+    ret->set_field_dominance(f->field_dominance( ));
+    ret->set_capture_time(f->capture_time( ));
+    ret->set_global_alpha(f->global_alpha( ));
+    return ret;
+}
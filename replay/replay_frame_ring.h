@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef _REPLAY_FRAME_RING_H
+#define _REPLAY_FRAME_RING_H
+
+#include "raw_frame.h"
+#include "mutex.h"
+#include "ref.h"
+
+#include <vector>
+#include <atomic>
+
+/* frames an output adapter typically has in flight, plus some slack */
+#define REPLAY_FRAME_RING_SIZE 8
+
+/*
+ * A fixed set of frame buffers handed out over and over again, so the
+ * playout thread isn't calling malloc for 4 MB every frame (and taking
+ * fresh pages, which must be faulted in, at realtime priority).
+ *
+ * get( ) returns an ordinary RawFrame * that may be handed to anything
+ * that deletes it; deleting it puts the buffer back in the ring. The 
+ * buffers stay around until the ring and every frame taken from it are
+ * gone, so frames may outlive the ring. When all buffers are in use or 
+ * the size doesn't match the first request, get( ) falls back to a 
+ * plain allocation.
+ */
+class ReplayFrameRing {
+    public:
+        ReplayFrameRing(unsigned int size);
+        ~ReplayFrameRing( );
+
+        RawFrame *get(coord_t w, coord_t h, RawFrame::PixelFormat pf);
+
+        /* a pooled (if possible) frame with the contents of f */
+        RawFrame *clone(RawFrame *f);
+
+        /* number of get( )s that had to allocate */
+        uint64_t misses( ) const { return pool->misses; }
+
+    protected:
+        struct Pool : public RefCounted {
+            Pool(unsigned int size);
+            ~Pool( );
+
+            uint8_t *take(size_t size);
+            void give(uint8_t *buf);
+
+            Mutex mut;
+            std::vector<uint8_t *> free_bufs;
+            size_t buf_size;
+            unsigned int capacity;
+            unsigned int allocated;
+            std::atomic<uint64_t> misses;
+        };
+
+        class Frame;
+
+        ref<Pool> pool;
+};
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "replay_ingest.h"
 #include "mjpeg_codec.h"
+#include "clocks.h"
 #include <assert.h>
 #include <string.h>
 
@@ -28,6 +29,9 @@ ReplayIngest::ReplayIngest(InputAdapter *iadp_, ReplayBuffer *buf_,
     buf = buf_;
     gd = gds;
     encode_suspended = false;
+    last_backlog_age = 0;
+    worst_backlog_age = 0;
+    thumbnails = new ReplayThumbnailStage(buf, &monitor);
     start_thread( );
 }
 
@@ -37,17 +41,62 @@ ReplayIngest::~ReplayIngest( ) {
 
 void ReplayIngest::debug( ) {
     fprintf(stderr, "ingest for %s\n", buf->get_name( ));
-    iadp->output_pipe( ).debug( );
+    if (iadp != NULL) {
+        iadp->output_pipe( ).debug( );
+    }
+    fprintf(stderr, "dropped %llu, backlog age %llu ms (max %llu ms)\n",
+        (unsigned long long) dropped_frames( ), 
+        (unsigned long long) backlog_age( ), 
+        (unsigned long long) max_backlog_age( ));
+}
+
+uint64_t ReplayIngest::dropped_frames( ) {
+    if (iadp == NULL) {
+        return 0;
+    }
+    return iadp->dropped_frames( );
+}
+
+unsigned int ReplayIngest::backlog_frames( ) {
+    if (iadp == NULL) {
+        return 0;
+    }
+    return iadp->output_pipe( ).fill( );
+}
+
+uint64_t ReplayIngest::backlog_age( ) {
+    MutexLock l(m);
+    return last_backlog_age;
+}
+
+uint64_t ReplayIngest::max_backlog_age( ) {
+    MutexLock l(m);
+    return worst_backlog_age;
+}
+
+void ReplayIngest::update_backlog_age(RawFrame *input) {
+    uint64_t now, age;
+
+    if (input->capture_time( ) == 0) {
+        return;
+    }
+
+    now = clock_monotonic_msec( );
+    age = (now > input->capture_time( )) ? now - input->capture_time( ) : 0;
+
+    MutexLock l(m);
+    last_backlog_age = age;
+    if (age > worst_backlog_age) {
+        worst_backlog_age = age;
+    }
 }
 
 void ReplayIngest::run_thread( ) {
-    RawFrame *input, *thumb;
+    RawFrame *input;
     IOAudioPacket *input_audio;
-    ReplayRawFrame *monitor_frame;
 
     ReplayFrameData data_to_write;
     Mjpeg422Encoder enc(1920, 1080, 80); /* FIXME: hard coded frame size */
-    Mjpeg422Encoder thumb_enc(480, 272, 30);
     timecode_t pos;
 
     priority(SCHED_RR, 20);
@@ -56,12 +105,9 @@ void ReplayIngest::run_thread( ) {
 
     for (;;) {
         /* obtain frame (and maybe audio) from input adapter */
-        input = iadp->output_pipe( ).get( );
-        if (iadp->audio_output_pipe( )) {
-            input_audio = iadp->audio_output_pipe( )->get( );
-        } else {
-            input_audio = NULL;
-        }
+        iadp->read_frame(input, input_audio);
+
+        update_backlog_age(input);
 
         bool suspended;
 
@@ -79,34 +125,26 @@ void ReplayIngest::run_thread( ) {
             enc.encode(input);
             data_to_write.video_data = (uint8_t *)enc.get_data( );
             data_to_write.video_size = enc.get_data_size( );
+            data_to_write.audio = input_audio;
 
-            /* scale input and make JPEG thumbnail */
-            thumb = input->convert->CbYCrY8422_scaled(480, 270);
-            thumb_enc.encode(thumb);
-            data_to_write.thumbnail_data = (uint8_t *)thumb_enc.get_data( );
-            data_to_write.thumbnail_size = thumb_enc.get_data_size( );
-
-            if (input_audio) {
-                data_to_write.audio = input_audio;
-            }
+            /* commit the full frame first; the thumbnail comes later */
             pos = buf->write_frame(data_to_write);
-
-            /* scale down frame to send to monitor */
-            monitor_frame = new ReplayRawFrame(thumb);
-            
-            /* fill in monitor status info */
-            monitor_frame->source_name = buf->get_name( );
-            monitor_frame->tc = pos;
-
-            monitor.put(monitor_frame);
-
+            tee(data_to_write, buf->field_dominance( ), 
+                    wall_capture_time(input));
+
+            /* 
+             * the thumbnail stage now owns the input; in zero-copy mode
+             * the capture buffer goes back to the card once it is scaled
+             */
+            thumbnails->offer(input, pos);
+            input = NULL;
         }
 
         if (input_audio) {
             delete input_audio;
         }
         
-        delete input;
+        delete input; /* only still set if encode was suspended */
     }
 }
 
@@ -120,6 +158,48 @@ void ReplayIngest::resume_encode( ) {
     encode_suspended = false;
 }
 
+void ReplayIngest::set_thumbnail_interval(unsigned int n) {
+    thumbnails->set_interval(n);
+}
+
+uint64_t ReplayIngest::thumbnails_skipped( ) {
+    return thumbnails->skipped( );
+}
+
+void ReplayIngest::add_sender(ReplayNetSender *sender) {
+    MutexLock l(m);
+    senders.push_back(sender);
+}
+
+/* 
+ * hand a committed frame to each network sender (they copy it); 
+ * the copying is done without holding m
+ */
+void ReplayIngest::tee(const ReplayFrameData &data, 
+        RawFrame::FieldDominance dominance, uint64_t timestamp) {
+    std::vector<ReplayNetSender *> targets;
+
+    { MutexLock l(m);
+        targets = senders;
+    }
+
+    for (size_t i = 0; i < targets.size( ); i++) {
+        targets[i]->send(data, dominance, timestamp);
+    }
+}
+
+/* translate a monotonic capture time into one a remote host can use */
+uint64_t ReplayIngest::wall_capture_time(RawFrame *input) {
+    uint64_t now = clock_monotonic_msec( );
+    uint64_t age = 0;
+
+    if (input->capture_time( ) != 0 && now > input->capture_time( )) {
+        age = now - input->capture_time( );
+    }
+
+    return clock_realtime_msec( ) - age;
+}
+
 void ReplayIngest::trigger( ) {
     /* stub for "normal" (continuous) ingest */
 }
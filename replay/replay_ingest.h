@@ -27,6 +27,9 @@
 #include "replay_buffer.h"
 #include "replay_gamedata.h"
 #include "mutex.h"
+#include "replay_thumbnail_stage.h"
+#include "replay_net_sender.h"
+#include <vector>
 
 class ReplayIngest : public Thread {
     public:
@@ -44,6 +47,29 @@ class ReplayIngest : public Thread {
 
         void debug( );
 
+        /* 
+         * Ingest health: frames the input adapter had to throw away, 
+         * frames waiting to be encoded, and how long (msec) the most 
+         * recently dequeued frame sat in the queue (and the worst so far).
+         */
+        virtual uint64_t dropped_frames( );
+        unsigned int backlog_frames( );
+        uint64_t backlog_age( );
+        uint64_t max_backlog_age( );
+
+        /* 
+         * Thumbnails (and monitor frames) are made for every Nth frame 
+         * by a background stage, which skips frames to keep up.
+         */
+        void set_thumbnail_interval(unsigned int n);
+        uint64_t thumbnails_skipped( );
+
+        /*
+         * Also stream every committed frame to another machine's 
+         * ReplayNetIngest. The sender is not owned by the ingest.
+         */
+        void add_sender(ReplayNetSender *sender);
+
     protected:
         void run_thread( );
         
@@ -52,11 +78,24 @@ class ReplayIngest : public Thread {
 
         ReplayGameData *gd;
 
-        ReplayIngest() { };
+        ReplayThumbnailStage *thumbnails;
+
+        ReplayIngest() : iadp(NULL), buf(NULL), gd(NULL), thumbnails(NULL),
+                encode_suspended(false), last_backlog_age(0), 
+                worst_backlog_age(0) { };
+
+        void update_backlog_age(RawFrame *input);
+
+        void tee(const ReplayFrameData &data, 
+                RawFrame::FieldDominance dominance, uint64_t timestamp);
+        static uint64_t wall_capture_time(RawFrame *input);
+        std::vector<ReplayNetSender *> senders;
 
         Mutex m;
 
         bool encode_suspended;
+        uint64_t last_backlog_age;
+        uint64_t worst_backlog_age;
 };
 
 #endif
@@ -21,6 +21,8 @@
     #include "replay_ingest.h"
 %}
 
+class ReplayNetSender;
+
 %rename("monitor") ReplayIngest::get_monitor( );
 
 class ReplayIngest : public Thread {
@@ -34,5 +36,15 @@ class ReplayIngest : public Thread {
         void suspend_encode( );
         void resume_encode( );
         void debug( );
+
+        uint64_t dropped_frames( );
+        unsigned int backlog_frames( );
+        uint64_t backlog_age( );
+        uint64_t max_backlog_age( );
+
+        void set_thumbnail_interval(unsigned int n);
+        uint64_t thumbnails_skipped( );
+
+        void add_sender(ReplayNetSender *INPUT);
 };
 
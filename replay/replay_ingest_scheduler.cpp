@@ -0,0 +1,246 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_ingest_scheduler.h"
+#include "xmalloc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* frames a single camera may have queued in the pool at once */
+#define INGEST_MAX_IN_FLIGHT 4
+
+struct ReplayIngestFrame {
+    ReplayScheduledIngest *ingest;
+    uint64_t seq;
+
+    RawFrame *input;
+    IOAudioPacket *audio;
+
+    uint8_t *video_data;
+    size_t video_size;
+};
+
+static uint8_t *copy_encoded(Mjpeg422Encoder *enc, size_t &size) {
+    uint8_t *ret;
+
+    size = enc->get_data_size( );
+    ret = (uint8_t *) xmalloc(size, "ReplayIngestScheduler", "encoded frame");
+    memcpy(ret, enc->get_data( ), size);
+    return ret;
+}
+
+class ReplayEncodeJob : public WorkItem {
+    public:
+        ReplayEncodeJob(ReplayIngestScheduler *sched_, 
+                ReplayIngestFrame *frame_) {
+            sched = sched_;
+            frame = frame_;
+        }
+
+        void run(unsigned int worker) {
+            Mjpeg422Encoder *enc = sched->encoders[worker];
+            try {
+                enc->encode(frame->input);
+                frame->video_data = copy_encoded(enc, frame->video_size);
+            } catch (std::exception &e) {
+                fprintf(stderr, "ingest: encode failed: %s\n", e.what( ));
+            }
+            frame->ingest->frame_encoded(frame);
+        }
+
+    protected:
+        ReplayIngestScheduler *sched;
+        ReplayIngestFrame *frame;
+};
+
+ReplayIngestScheduler::ReplayIngestScheduler(unsigned int n_workers) 
+        : pool(n_workers) {
+    for (unsigned int i = 0; i < pool.n_workers( ); i++) {
+        /* FIXME: hard coded frame size, as in ReplayIngest */
+        encoders.push_back(new Mjpeg422Encoder(1920, 1080, 80));
+    }
+}
+
+ReplayIngestScheduler::~ReplayIngestScheduler( ) {
+    /* the pool workers never exit, so the encoders must stay around */
+}
+
+ReplayIngest *ReplayIngestScheduler::add_source(InputAdapter *iadp, 
+        ReplayBuffer *buf, ReplayGameData *gds) {
+    ReplayIngest *ingest = new ReplayScheduledIngest(iadp, buf, this, gds);
+    ingests.push_back(ingest);
+    return ingest;
+}
+
+void ReplayIngestScheduler::submit(ReplayIngestFrame *frame) {
+    pool.submit(new ReplayEncodeJob(this, frame));
+}
+
+ReplayScheduledIngest::ReplayScheduledIngest(InputAdapter *iadp_, 
+        ReplayBuffer *buf_, ReplayIngestScheduler *sched_,
+        ReplayGameData *gds) {
+    iadp = iadp_;
+    buf = buf_;
+    gd = gds;
+    sched = sched_;
+
+    next_seq = 0;
+    next_commit = 0;
+    in_flight = 0;
+    committing = false;
+
+    thumbnails = new ReplayThumbnailStage(buf, &monitor);
+    start_thread( );
+}
+
+ReplayScheduledIngest::~ReplayScheduledIngest( ) {
+
+}
+
+void ReplayScheduledIngest::run_thread( ) {
+    RawFrame *input;
+    IOAudioPacket *input_audio;
+    ReplayIngestFrame *frame;
+    bool suspended;
+
+    /* this thread only hands frames off, so it never holds up capture */
+    priority(SCHED_RR, 20);
+
+    iadp->start( );
+
+    for (;;) {
+        iadp->read_frame(input, input_audio);
+
+        update_backlog_age(input);
+
+        { MutexLock l(m);
+            suspended = encode_suspended;
+        }
+
+        if (suspended) {
+            delete input_audio;
+            delete input;
+            continue;
+        }
+
+        if (buf->field_dominance( ) == RawFrame::UNKNOWN) {
+            buf->set_field_dominance(input->field_dominance( ));
+        }
+
+        /* 
+         * wait for the pool to drain some of our frames; meanwhile
+         * the input adapter's drop policy deals with the overflow 
+         */
+        { MutexLock l(commit_m);
+            while (in_flight >= INGEST_MAX_IN_FLIGHT) {
+                commit_done.wait(commit_m);
+            }
+            in_flight++;
+        }
+
+        frame = new ReplayIngestFrame;
+        frame->ingest = this;
+        frame->seq = next_seq++;
+        frame->input = input;
+        frame->audio = input_audio;
+        frame->video_data = NULL;
+        frame->video_size = 0;
+
+        sched->submit(frame);
+    }
+}
+
+void ReplayScheduledIngest::frame_encoded(ReplayIngestFrame *frame) {
+    std::vector<ReplayIngestFrame *> ready;
+
+    { MutexLock l(commit_m);
+        finished[frame->seq] = frame;
+
+        /* whoever is already committing will pick this frame up */
+        if (committing) {
+            return;
+        }
+        committing = true;
+    }
+
+    /*
+     * Write out everything that is now in order. Only the bookkeeping
+     * is done under commit_m; the disk writes happen outside it, so 
+     * other workers finishing frames for this buffer just queue them
+     * and move on. committing makes sure only one worker at a time
+     * writes, in order.
+     */
+    for (;;) {
+        { MutexLock l(commit_m);
+            while (!finished.empty( ) 
+                    && finished.begin( )->first == next_commit) {
+                ready.push_back(finished.begin( )->second);
+                finished.erase(finished.begin( ));
+                next_commit++;
+            }
+
+            if (ready.empty( )) {
+                committing = false;
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < ready.size( ); i++) {
+            commit(ready[i]);
+        }
+
+        { MutexLock l(commit_m);
+            in_flight -= ready.size( );
+            commit_done.signal( );
+        }
+
+        ready.clear( );
+    }
+}
+
+void ReplayScheduledIngest::commit(ReplayIngestFrame *frame) {
+    ReplayFrameData data_to_write;
+    timecode_t pos;
+
+    data_to_write.video_data = frame->video_data;
+    data_to_write.video_size = frame->video_size;
+    data_to_write.audio = frame->audio;
+
+    /* a failed frame must not stall the frames queued up behind it */
+    try {
+        pos = buf->write_frame(data_to_write);
+        tee(data_to_write, buf->field_dominance( ), 
+                wall_capture_time(frame->input));
+
+        /* thumbnail and monitor frame are made later, from the input */
+        thumbnails->offer(frame->input, pos);
+        frame->input = NULL;
+    } catch (std::exception &e) {
+        fprintf(stderr, "ingest for %s: dropped frame: %s\n", 
+                buf->get_name( ), e.what( ));
+    }
+
+    free(frame->video_data);
+    delete frame->input;
+    delete frame->audio;
+    delete frame;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_INGEST_SCHEDULER_H
+#define _REPLAY_INGEST_SCHEDULER_H
+
+#include "replay_ingest.h"
+#include "work_pool.h"
+#include "mjpeg_codec.h"
+#include "condition.h"
+
+#include <map>
+#include <vector>
+
+class ReplayIngestScheduler;
+struct ReplayIngestFrame;
+
+/*
+ * An ingest whose frames are encoded by a shared ReplayIngestScheduler.
+ * Its own thread only moves frames from the input adapter to the pool;
+ * finished frames are written to the buffer strictly in capture order.
+ */
+class ReplayScheduledIngest : public ReplayIngest {
+    public:
+        ReplayScheduledIngest(InputAdapter *iadp_, ReplayBuffer *buf_,
+                ReplayIngestScheduler *sched_, ReplayGameData *gds = NULL);
+        ~ReplayScheduledIngest( );
+
+        /* called by the pool once a frame has been encoded */
+        void frame_encoded(ReplayIngestFrame *frame);
+
+    protected:
+        void run_thread( );
+        void commit(ReplayIngestFrame *frame);
+
+        ReplayIngestScheduler *sched;
+
+        Mutex commit_m;
+        Condition commit_done;
+        std::map<uint64_t, ReplayIngestFrame *> finished;
+        uint64_t next_seq;
+        uint64_t next_commit;
+        unsigned int in_flight;
+        bool committing; /* a worker is writing frames out */
+};
+
+/*
+ * Encodes frames for any number of ingests on one work pool sized to
+ * the machine, instead of one encoder thread per camera.
+ * Each worker keeps its own encoder.
+ */
+class ReplayIngestScheduler {
+    public:
+        ReplayIngestScheduler(unsigned int n_workers = 0);
+        ~ReplayIngestScheduler( );
+
+        ReplayIngest *add_source(InputAdapter *iadp, ReplayBuffer *buf,
+                ReplayGameData *gds = NULL);
+
+        unsigned int n_workers( ) { return pool.n_workers( ); }
+
+    protected:
+        void submit(ReplayIngestFrame *frame);
+
+        WorkPool pool;
+        std::vector<Mjpeg422Encoder *> encoders;
+        std::vector<ReplayIngest *> ingests;
+
+        friend class ReplayScheduledIngest;
+        friend class ReplayEncodeJob;
+};
+
+#endif
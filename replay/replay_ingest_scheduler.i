@@ -0,0 +1,35 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+%{
+    #include "replay_ingest.h"
+    #include "replay_ingest_scheduler.h"
+%}
+
+/* the encoder pool runs for the life of the process */
+%nodefaultdtor ReplayIngestScheduler;
+
+class ReplayIngestScheduler {
+    public:
+        ReplayIngestScheduler(unsigned int n_workers = 0);
+
+        ReplayIngest *add_source(InputAdapter *INPUT, ReplayBuffer *INPUT,
+                ReplayGameData *INPUT = NULL);
+        unsigned int n_workers( );
+};
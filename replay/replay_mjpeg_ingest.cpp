@@ -19,10 +19,12 @@
 
 #include "replay_mjpeg_ingest.h"
 #include "mjpeg_codec.h"
+#include "clocks.h"
 #include <assert.h>
 #include <string.h>
 
 #define BUFSIZE 1048576
+#define NO_JPEG ((size_t) -1)
 
 ReplayMjpegIngest::ReplayMjpegIngest(const char *cmd, 
         ReplayBuffer *buf_) {
@@ -65,7 +67,14 @@ ReplayMjpegIngest::ReplayMjpegIngest(const char *cmd,
         jpegbuf = new uint8_t[BUFSIZE];
         buf_size = BUFSIZE;
         buf_fill = 0;
+        scan_pos = 0;
+        jpg_start = NO_JPEG;
 
+        have_format = false;
+        n_rejected = 0;
+
+        thumbnails = new ReplayThumbnailStage(buf, &monitor, 
+                REPLAY_JPEG_THUMBNAIL_INTERVAL);
         start_thread( );
     }
 }
@@ -76,12 +85,8 @@ ReplayMjpegIngest::~ReplayMjpegIngest( ) {
 }
 
 void ReplayMjpegIngest::run_thread( ) {
-    Mjpeg422Decoder dec(1920, 1080);
-    Mjpeg422Encoder thm_enc(1920, 1080);
-    ReplayRawFrame *monitor_frame;
     ReplayFrameData dest;
-    RawFrame *decoded_monitor;
-    dest.pos = 0;
+    timecode_t pos;
 
     for (;;) {
         /* read M-JPEG data from child process */
@@ -89,85 +94,103 @@ void ReplayMjpegIngest::run_thread( ) {
             break; /* no more JPEG data */
         }
 
+        if (!check_header(dest)) {
+            n_rejected++;
+            continue;
+        }
+
         /* set field dominance if necessary */
         if (buf->field_dominance( ) == RawFrame::UNKNOWN) {
             /* assume progressive since we don't know what is coming in */
             buf->set_field_dominance(RawFrame::PROGRESSIVE);
         }
 
-        /* decode JPEG for monitor */
-        decoded_monitor = dec.decode(dest.video_data, dest.video_size, 480);
-        
-        /* encode thumbnail */
-        thm_enc.encode(decoded_monitor);
-        dest.thumbnail_data = (uint8_t *)thm_enc.get_data( );
-        dest.thumbnail_size = thm_enc.get_data_size( );
-
-        buf->write_frame(dest);
-        free(dest.video_data);
-
-        /* scale down frame to send to monitor */
-        monitor_frame = new ReplayRawFrame(decoded_monitor);
-        
-        /* fill in monitor status info */
-        monitor_frame->source_name = buf->get_name( );
-        monitor_frame->tc = dest.pos;
-        dest.pos ++;
-    
-        monitor.put(monitor_frame);
+        pos = buf->write_frame(dest);
+        tee(dest, buf->field_dominance( ), clock_realtime_msec( ));
+
+        /* the thumbnail stage takes a copy of every Nth frame only */
+        thumbnails->offer_jpeg_copy(dest.video_data, dest.video_size, pos);
+    }
+}
+
+/* 
+ * Anything we write must be decodable at playout; the first good frame
+ * fixes the size for the rest of the stream.
+ */
+bool ReplayMjpegIngest::check_header(const ReplayFrameData &data) {
+    Mjpeg422Header hdr;
+
+    if (!mjpeg_parse_422_header(data.video_data, data.video_size, hdr)) {
+        if (n_rejected == 0) {
+            fprintf(stderr, "%s: dropping JPEG that is not 4:2:2\n", 
+                    buf->get_name( ));
+        }
+        return false;
+    }
+
+    if (!have_format) {
+        format = hdr;
+        have_format = true;
+    } else if (hdr.w != format.w || hdr.h != format.h) {
+        if (n_rejected == 0) {
+            fprintf(stderr, "%s: dropping %dx%d JPEG in a %dx%d stream\n",
+                    buf->get_name( ), (int) hdr.w, (int) hdr.h, 
+                    (int) format.w, (int) format.h);
+        }
+        return false;
     }
+
+    return true;
 }
 
 int ReplayMjpegIngest::read_mjpeg_data(ReplayFrameData &dest) {
+    uint8_t *p, *end;
+    size_t keep;
     ssize_t ret;
-    size_t i, jpgend, jpgstart;
-    bool success_flag;
 
     for (;;) {
-        /* try to read more data into the buffer */
-        if (buf_fill < buf_size) {
-            ret = read(jpeg_fd, jpegbuf + buf_fill, buf_size - buf_fill);
-            if (ret < 0) {
-                throw POSIXError("ReplayMjpegIngest read()");
-            } else if (ret == 0) {
-                return 0;
+        /* 
+         * Look for the next FFD8 ... FFD9 pair in what we have. memchr 
+         * skips to each 0xff; inside entropy-coded data those are 
+         * always followed by a stuffed zero, so they're rare.
+         */
+        end = jpegbuf + buf_fill;
+        p = jpegbuf + scan_pos;
+
+        while (p + 1 < end) {
+            p = (uint8_t *) memchr(p, 0xff, end - 1 - p);
+            if (p == NULL) {
+                break;
             }
-            buf_fill += ret;
-        }
 
-        jpgstart = (size_t) -1;
-
-        /* scan the buffer for a JPEG end marker (0xffd9) */
-        for (i = 0; i < buf_fill - 1; i++) {
-            if (jpegbuf[i] == 0xff && jpegbuf[i+1] == 0xd8) {
-                jpgstart = i;
+            if (p[1] == 0xd8) {
+                jpg_start = p - jpegbuf;
+            } else if (p[1] == 0xd9 && jpg_start != NO_JPEG) {
+                dest.video_data = jpegbuf + jpg_start;
+                dest.video_size = (p + 2) - dest.video_data;
+                scan_pos = (p + 2) - jpegbuf;
+                jpg_start = NO_JPEG;
+                return 1;
             }
 
-            if (jpegbuf[i] == 0xff && jpegbuf[i+1] == 0xd9) {
-                jpgend = i+2;
-                
-                success_flag = false;
-
-                if (jpgstart != (size_t) -1) {
-                    /* copy JPEG data to frame buffer */
-                    dest.video_data = (uint8_t *)malloc(jpgend-jpgstart);
-                    dest.video_size = jpgend-jpgstart;
-                    memcpy(dest.video_data, jpegbuf+jpgstart, dest.video_size);
-
-                    success_flag = true;
-                }
-
-                /* move down data following the JPEG (or just discard data) */
-                memmove(jpegbuf, jpegbuf+jpgend, buf_fill-jpgend);
-                buf_fill -= jpgend;
-            
-                /* done! */
-                if (success_flag) {
-                    return 1;
-                } else {
-                    /* stop scanning for JPEGs and load buffer again */
-                    break; 
-                }
+            p++;
+        }
+
+        /* the last byte may be the first half of a marker */
+        scan_pos = (buf_fill > 0) ? buf_fill - 1 : 0;
+
+        /* 
+         * Move the partial JPEG (or just the unscanned byte) down to 
+         * the start of the buffer. This happens once per read, not 
+         * once per frame.
+         */
+        keep = (jpg_start != NO_JPEG) ? jpg_start : scan_pos;
+        if (keep > 0) {
+            memmove(jpegbuf, jpegbuf + keep, buf_fill - keep);
+            buf_fill -= keep;
+            scan_pos -= keep;
+            if (jpg_start != NO_JPEG) {
+                jpg_start -= keep;
             }
         }
 
@@ -178,6 +201,15 @@ int ReplayMjpegIngest::read_mjpeg_data(ReplayFrameData &dest) {
              */
             throw std::runtime_error("data stream appears not to be JPEG");
         }
+
+        /* read more data into the buffer */
+        ret = read(jpeg_fd, jpegbuf + buf_fill, buf_size - buf_fill);
+        if (ret < 0) {
+            throw POSIXError("ReplayMjpegIngest read()");
+        } else if (ret == 0) {
+            return 0;
+        }
+        buf_fill += ret;
     }
 }
 
@@ -25,15 +25,27 @@
 #include "adapter.h"
 #include "replay_data.h"
 #include "replay_ingest.h"
+#include "mjpeg_codec.h"
 
+#include <atomic>
+
+/*
+ * Records M-JPEG produced by an external encoder process. The JPEGs 
+ * are not decoded: once their headers check out (4:2:2, same size as
+ * the first frame) they go straight from the read buffer into the 
+ * replay buffer. Frames that fail the check are counted as dropped.
+ */
 class ReplayMjpegIngest : public ReplayIngest {
     public:
         ReplayMjpegIngest(const char *cmd, ReplayBuffer *buf_);
         ~ReplayMjpegIngest( );
 
         void trigger( );
+        uint64_t dropped_frames( ) { return n_rejected; }
+
     protected:
         void run_thread( );
+        bool check_header(const ReplayFrameData &data);
         
         InputAdapter *iadp;
         ReplayBuffer *buf;
@@ -41,10 +53,17 @@ class ReplayMjpegIngest : public ReplayIngest {
         int cmd_fd;
         pid_t child_pid;
 
+        /* data is left in jpegbuf, valid until the next call */
         int read_mjpeg_data(ReplayFrameData &dest);
         uint8_t *jpegbuf;
         size_t buf_size;
         size_t buf_fill;
+        size_t scan_pos;
+        size_t jpg_start;
+
+        bool have_format;
+        Mjpeg422Header format;
+        std::atomic<uint64_t> n_rejected;
 };
 
 #endif
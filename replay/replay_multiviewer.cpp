@@ -19,9 +19,14 @@
 
 #include "replay_multiviewer.h"
 #include "freetype_font.h"
-#include "rsvg_frame.h"
+#include "raster_cache.h"
+#include "scope.h"
+#include "replay_scope_filter.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <time.h>
+#include <errno.h>
 
 ReplayMultiviewer::ReplayMultiviewer(DisplaySurface *dpy_) {
     dpy = dpy_;
@@ -30,10 +35,14 @@ ReplayMultiviewer::ReplayMultiviewer(DisplaySurface *dpy_) {
     small_font = new FreetypeFont("../fonts/Inconsolata.otf");
     small_font->set_size(20);
 
-    waveform_graticule = RsvgFrame::render_svg_file("../assets/waveform.svg");
-    vector_graticule = RsvgFrame::render_svg_file("../assets/vectorscope.svg");
+    waveform_graticule = RasterCache::get( ).svg_file("../assets/waveform.svg");
+    vector_graticule = RasterCache::get( ).svg_file("../assets/vectorscope.svg");
 
     overlay_mode = NONE;
+
+    refresh_period = 1000000000 / 60;
+    next_refresh = 0;
+    vsync = true;
 }
 
 ReplayMultiviewer::~ReplayMultiviewer( ) {
@@ -41,11 +50,20 @@ ReplayMultiviewer::~ReplayMultiviewer( ) {
     delete small_font;
     delete waveform_graticule;
     delete vector_graticule;
+
+    for (unsigned int i = 0; i < tiles.size( ); i++) {
+        delete tiles[i].waveform;
+        delete tiles[i].vector;
+    }
 }
 
 void ReplayMultiviewer::add_source(
         const ReplayMultiviewerSourceParams &params) {
-    sources.push_back(params);
+    Tile tile;
+    tile.params = params;
+    tile.waveform = NULL;
+    tile.vector = NULL;
+    tiles.push_back(tile);
 }
 
 void ReplayMultiviewer::start( ) {
@@ -71,128 +89,231 @@ void ReplayMultiviewer::change_mode( ) {
     }
 }
 
+void ReplayMultiviewer::set_refresh_rate(unsigned int hz) {
+    MutexLock l(m);
+    if (hz == 0) {
+        throw std::runtime_error("refresh rate must be nonzero");
+    }
+    refresh_period = 1000000000 / hz;
+}
+
+static uint64_t monotonic_nsec( ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Sleep until the start of the next refresh period. If the display can
+ * wait for vertical blanking, wait for the first blank at (or just 
+ * short of) the end of the period, so we flip right after it.
+ */
+void ReplayMultiviewer::wait_refresh( ) {
+    uint64_t now = monotonic_nsec( );
+    uint64_t period;
+    struct timespec ts;
+
+    { MutexLock l(m);
+        period = refresh_period;
+    }
+
+    next_refresh += period;
+    if (next_refresh < now) {
+        /* fell behind (or just started): don't try to catch up */
+        next_refresh = now + period;
+    }
+
+    if (vsync) {
+        do {
+            if (!dpy->wait_vsync( )) {
+                vsync = false;
+                break;
+            }
+            now = monotonic_nsec( );
+        } while (now + period / 4 < next_refresh);
+
+        if (vsync) {
+            /* keep in phase with the display */
+            next_refresh = now;
+            return;
+        }
+    }
+
+    ts.tv_sec = next_refresh / 1000000000;
+    ts.tv_nsec = next_refresh % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) 
+            == EINTR) { }
+}
+
 void ReplayMultiviewer::run_thread( ) {
-    overlay_mode_t overlay;
+    overlay_mode_t overlay, last_overlay = OVERLAY_MAX;
+    bool fresh, changed;
 
     for (;;) {
         { MutexLock l(m);
             overlay = overlay_mode;
         }
-        for (unsigned int i = 0; i < sources.size( ); i++) {
-            const ReplayMultiviewerSourceParams &src = sources[i];
-            ReplayRawFrame *f = src.source->get( );
-
-            if (f != NULL) {
-                f->bgra_data = f->frame_data->convert->BGRAn8( );
-
-                if (f->frame_data->pixel_format( ) == RawFrame::CbYCrY8422) {
-                    if (overlay == VECTORSCOPE) {
-                        render_vector(f);
-                    } else if (overlay == WAVEFORM) {
-                        render_waveform(f);
-                    }
+
+        changed = false;
+        for (unsigned int i = 0; i < tiles.size( ); i++) {
+            Tile &tile = tiles[i];
+            ReplayScopeFilter *scopes = tile.params.scopes;
+            ReplayRawFrame *f = tile.params.source->get(fresh);
+            RawFrame *scope = NULL;
+            bool scope_fresh = false;
+
+            if (scopes != NULL) {
+                if (overlay != last_overlay) {
+                    scopes->select(overlay == WAVEFORM, 
+                            overlay == VECTORSCOPE);
                 }
 
-                render_text(f);
-                
-                dpy->draw->blit(src.x, src.y, f->bgra_data);
+                if (overlay == WAVEFORM) {
+                    scope = scopes->waveform.get(scope_fresh);
+                } else if (overlay == VECTORSCOPE) {
+                    scope = scopes->vectorscope.get(scope_fresh);
+                }
+            } else if (overlay != last_overlay) {
+                /* start the tile's scopes over with a clean trace */
+                if (tile.waveform != NULL) {
+                    tile.waveform->clear( );
+                }
+                if (tile.vector != NULL) {
+                    tile.vector->clear( );
+                }
+            }
 
-                delete f->bgra_data;
+            /* 
+             * the port hands back the last frame until there is a new
+             * one; that's only worth redrawing if the overlay changed
+             */
+            if (f != NULL && (fresh || scope_fresh 
+                    || overlay != last_overlay)) {
+                render_tile(tile, f, scope, overlay);
+                changed = true;
             }
         }
-        dpy->flip( );
+        last_overlay = overlay;
+
+        /* tiles are drawn off-screen; show them at the next refresh */
+        wait_refresh( );
+        if (changed) {
+            dpy->flip( );
+        }
     }
-    usleep(20000);
 }
 
-void ReplayMultiviewer::render_vector(ReplayRawFrame *f) {
-    /* make a copy of the graticule */
-    RawFrame *vector = vector_graticule->convert->BGRAn8( );
-    RawFrame *src = f->frame_data;
+void ReplayMultiviewer::render_tile(Tile &tile, ReplayRawFrame *f, 
+        RawFrame *scope, overlay_mode_t overlay) {
+    coord_t x = tile.params.x;
+    coord_t y = tile.params.y;
+
+    dpy->damage(Rect(x, y, f->frame_data->w( ), f->frame_data->h( )));
+    render_frame(f, x, y);
+
+    if (overlay != NONE && tile.params.scopes == NULL) {
+        scope = compute_scope(tile, f, overlay);
+    }
 
-    /* plot each Cb/Cr vector */
-    uint8_t cb, cr;
-    size_t s = src->size( );
-    uint8_t *d = src->data( );
-    for (size_t i = 0; i < s; i += 4) {
-        cb = d[i];
-        cr = d[i+2];
-
-        vector->scanline(255 - cb)[4*cr] = 0xff;
-        vector->scanline(255 - cb)[4*cr+1] = 0xff;
-        vector->scanline(255 - cb)[4*cr+2] = 0xff;
+    if (scope != NULL) {
+        render_scope(scope, overlay, x, y);
     }
 
-    f->bgra_data->draw->alpha_key(112, 7, vector, 255);
-    delete vector;
+    render_text(f, x, y);
 }
 
-void ReplayMultiviewer::render_waveform(ReplayRawFrame *f) {
-    RawFrame *wfm = waveform_graticule->convert->BGRAn8( );
+/* convert the frame straight into the display if we can */
+void ReplayMultiviewer::render_frame(ReplayRawFrame *f, 
+        coord_t x, coord_t y) {
     RawFrame *src = f->frame_data;
+    uint8_t *dst = dpy->pixel(x, y);
+
+    if (x + src->w( ) <= dpy->w( ) && y + src->h( ) <= dpy->h( )
+            && src->pitch( ) == src->w( ) * 2 
+            && src->pixel_format( ) == RawFrame::CbYCrY8422
+            && ((uintptr_t) dst % 16) == 0
+            && (dpy->pitch( ) % 16) == 0 && (src->pitch( ) % 16) == 0) {
+        src->unpack->BGRAn8(dst, dpy->pitch( ));
+    } else {
+        RawFrame *bgra = src->convert->BGRAn8( );
+        dpy->draw->blit(x, y, bgra);
+        delete bgra;
+    }
+}
+
+/* run the tile's own scope on its monitor frame */
+RawFrame *ReplayMultiviewer::compute_scope(Tile &tile, ReplayRawFrame *f,
+        overlay_mode_t overlay) {
+    Scope *scope;
+
+    if (f->frame_data->pixel_format( ) != RawFrame::CbYCrY8422) {
+        return NULL;
+    }
 
-    coord_t h = src->h( );      /* height */
-    coord_t w = src->w( );      /* source width */
-    coord_t st = w / 240;       /* stride */
-    uint8_t *s = src->data( );
-    uint8_t y, yw;              /* luma */
-    uint8_t *d;
-    const coord_t xofs = 20;
-
-    for (coord_t line = 0; line < h; line++) {
-        s = src->scanline(line);
-
-        for (coord_t x = 0, xw = 0; x < w && xw < 240; x += st, xw++) {
-            y = s[2*x+1];
-            yw = 127 - (y >> 1);
-
-            d = wfm->pixel(xofs + xw, yw);
-            d[0] = 0xff;
-            d[1] = 0xff;
-            d[2] = 0xff;            
+    if (overlay == WAVEFORM) {
+        if (tile.waveform == NULL) {
+            tile.waveform = new WaveformScope(waveform_graticule);
         }
+        scope = tile.waveform;
+    } else if (overlay == VECTORSCOPE) {
+        if (tile.vector == NULL) {
+            tile.vector = new VectorScope(vector_graticule);
+        }
+        scope = tile.vector;
+    } else {
+        return NULL;
     }
 
-    f->bgra_data->draw->alpha_key(112, 72, wfm, 255);
-    delete wfm;
+    scope->accumulate(f->frame_data);
+
+    /* nobody else holds it, so the scope keeps it until the next render */
+    return scope->render( ).get( );
+}
+
+void ReplayMultiviewer::render_scope(RawFrame *scope, 
+        overlay_mode_t overlay, coord_t x, coord_t y) {
+    if (overlay == WAVEFORM) {
+        dpy->draw->alpha_key(x + 112, y + 72, scope, 255);
+    } else if (overlay == VECTORSCOPE) {
+        dpy->draw->alpha_key(x + 112, y + 7, scope, 255);
+    }
 }
 
-void ReplayMultiviewer::render_text(ReplayRawFrame *f) {
-    int w = f->bgra_data->w( );
-    int h = f->bgra_data->h( );
+void ReplayMultiviewer::render_text(ReplayRawFrame *f, 
+        coord_t x, coord_t y) {
+    int w = f->frame_data->w( );
+    int h = f->frame_data->h( );
 
     int xt, yt;
 
     /* source names */
     if (f->source_name != NULL) {
-        RawFrame *text;
+        FreetypeFont *font;
         if (f->source_name2 == NULL) {
             /* 
              * a simple source, probably an ingest
              * just render its name centered at the bottom
              */
-            text = small_font->render_string(f->source_name);
+            font = small_font;
         } else {
             /*
              * complex source like program or preview
              * render its name larger... we'll render the subtitle later
              */
-            text = large_font->render_string(f->source_name);
+            font = large_font;
         }
-        xt = w / 2 - text->w( ) / 2;
-        yt = h - text->h( );
-        f->bgra_data->draw->alpha_key(xt, yt, text, 255);
-        delete text;
+        xt = w / 2 - font->string_width(f->source_name) / 2;
+        yt = h - font->h( );
+        font->draw_string(dpy, x + xt, y + yt, f->source_name);
 
         if (f->source_name2 != NULL) {
             /*
              * render the second source name on top of the primary
              */
-            text = small_font->render_string(f->source_name2);
-            xt = w / 2 - text->w( ) / 2;
-            yt = yt - text->h( );
-            f->bgra_data->draw->alpha_key(xt, yt, text, 255);
-            delete text;
+            xt = w / 2 - small_font->string_width(f->source_name2) / 2;
+            yt = yt - small_font->h( );
+            small_font->draw_string(dpy, x + xt, y + yt, 
+                    f->source_name2);
         }
     }
 
@@ -230,8 +351,6 @@ void ReplayMultiviewer::render_text(ReplayRawFrame *f) {
         );
     }
 
-    RawFrame *text = small_font->render_string(timecode_buf);
     /* draw timecode at top left corner */
-    f->bgra_data->draw->alpha_key(0, 0, text, 255);
-    delete text;
+    small_font->draw_string(dpy, x, y, timecode_buf);
 }
@@ -29,12 +29,30 @@
 
 class FreetypeFont;
 class RawFrame;
+class WaveformScope;
+class VectorScope;
+class ReplayScopeFilter;
 
 struct ReplayMultiviewerSourceParams {
     AsyncPort<ReplayRawFrame> *source;
     coord_t x, y;
+    /* 
+     * if set, scopes come from here (e.g. the full resolution program)
+     * instead of being computed from the monitor frames
+     */
+    ReplayScopeFilter *scopes;
 };
 
+/*
+ * Composites monitor frames from several sources into tiles on a 
+ * display. Retained-mode: a tile is redrawn only when its port delivers
+ * a new frame (or the overlay mode changes), frames are converted 
+ * straight into the display at the tile position, and the display is 
+ * flipped at most once per refresh period, only if something changed.
+ * Redrawn tiles are reported to the display as damage, and refresh is
+ * locked to vertical blanking when the display supports it.
+ * Each tile keeps its own scopes so their persistence doesn't mix.
+ */
 class ReplayMultiviewer : public Thread {
     public:
         ReplayMultiviewer(DisplaySurface *dpy_);
@@ -44,12 +62,27 @@ class ReplayMultiviewer : public Thread {
         void add_source(const ReplayMultiviewerSourceParams &params);
         void start( );
         void change_mode( );
+        void set_refresh_rate(unsigned int hz);
 
     protected:
+        enum overlay_mode_t { NONE, WAVEFORM, VECTORSCOPE, OVERLAY_MAX };
+
         void run_thread( );
-        void render_text(ReplayRawFrame *f);
-        void render_vector(ReplayRawFrame *f);
-        void render_waveform(ReplayRawFrame *f);
+        void wait_refresh( );
+        struct Tile {
+            ReplayMultiviewerSourceParams params;
+            WaveformScope *waveform;
+            VectorScope *vector;
+        };
+
+        void render_tile(Tile &tile, ReplayRawFrame *f, RawFrame *scope,
+                overlay_mode_t overlay);
+        void render_frame(ReplayRawFrame *f, coord_t x, coord_t y);
+        void render_text(ReplayRawFrame *f, coord_t x, coord_t y);
+        RawFrame *compute_scope(Tile &tile, ReplayRawFrame *f,
+                overlay_mode_t overlay);
+        void render_scope(RawFrame *scope, overlay_mode_t overlay,
+                coord_t x, coord_t y);
         DisplaySurface *dpy;
         
         FreetypeFont *large_font;
@@ -57,9 +90,14 @@ class ReplayMultiviewer : public Thread {
         RawFrame *waveform_graticule;
         RawFrame *vector_graticule;
 
-        enum overlay_mode_t { NONE, WAVEFORM, VECTORSCOPE, OVERLAY_MAX } overlay_mode;
+        overlay_mode_t overlay_mode;
+
+        std::vector<Tile> tiles;
 
-        std::vector<ReplayMultiviewerSourceParams> sources;
+        /* refresh pacing, CLOCK_MONOTONIC nanoseconds */
+        uint64_t refresh_period;
+        uint64_t next_refresh;
+        bool vsync;
 
         Mutex m;
 };
@@ -35,10 +35,12 @@ class ReplayMultiviewer : public Thread {
         void add_source(const ReplayMultiviewerSourceParams &INPUT);
         void start( );
         void change_mode( );
+        void set_refresh_rate(unsigned int hz);
 };
 
 struct ReplayMultiviewerSourceParams {
     AsyncPort<ReplayRawFrame> *source;
     coord_t x, y;
+    ReplayScopeFilter *scopes;
 };
 
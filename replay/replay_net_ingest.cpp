@@ -0,0 +1,154 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_net_ingest.h"
+#include "clocks.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+
+/* a sender that goes quiet this long is given up on */
+#define RECV_TIMEOUT_SEC 10
+
+ReplayNetIngest::ReplayNetIngest(const char *addr_, ReplayBuffer *buf_) 
+        : addr(addr_) {
+    buf = buf_;
+    conn_fd = -1;
+    stopping = false;
+    conn_fd_open = false;
+    n_received = 0;
+
+    /* fail here, where the caller can see it, if we can't listen */
+    listen_fd = replay_net_listen(addr_);
+
+    thumbnails = new ReplayThumbnailStage(buf, &monitor, 
+            REPLAY_JPEG_THUMBNAIL_INTERVAL);
+    start_thread( );
+}
+
+ReplayNetIngest::~ReplayNetIngest( ) {
+    /* wake the thread from accept( ) or a read, and wait for it */
+    { MutexLock l(conn_mutex);
+        stopping = true;
+        if (conn_fd != -1) {
+            shutdown(conn_fd, SHUT_RDWR);
+        }
+    }
+    shutdown(listen_fd, SHUT_RDWR);
+    join_thread( );
+
+    close(listen_fd);
+    delete thumbnails;
+}
+
+void ReplayNetIngest::run_thread( ) {
+    struct timeval tv;
+    int one = 1;
+    int fd;
+
+    for (;;) {
+        fd = accept(listen_fd, NULL, NULL);
+        if (stopping) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return;
+        } else if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("ReplayNetIngest accept()");
+            return;
+        }
+
+        /* don't let a sender that vanished hold the slot forever */
+        tv.tv_sec = RECV_TIMEOUT_SEC;
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+
+        { MutexLock l(conn_mutex);
+            if (stopping) {
+                close(fd);
+                return;
+            }
+            conn_fd = fd;
+        }
+
+        fprintf(stderr, "replay net: %s receiving on %s\n", 
+                buf->get_name( ), addr.c_str( ));
+        conn_fd_open = true;
+
+        try {
+            receive(fd);
+        } catch (std::exception &e) {
+            fprintf(stderr, "replay net: %s: %s\n", 
+                    buf->get_name( ), e.what( ));
+        }
+
+        conn_fd_open = false;
+        { MutexLock l(conn_mutex);
+            conn_fd = -1;
+            close(fd);
+        }
+    }
+}
+
+void ReplayNetIngest::receive(int fd) {
+    ReplayFrameData dest;
+    RawFrame::FieldDominance dominance;
+    uint64_t timestamp, now;
+    timecode_t pos;
+
+    while (replay_net_read_frame(fd, dest, dominance, timestamp) == 1) {
+        n_received++;
+
+        now = clock_realtime_msec( );
+        { MutexLock l(m);
+            last_backlog_age = (now > timestamp) ? now - timestamp : 0;
+            if (last_backlog_age > worst_backlog_age) {
+                worst_backlog_age = last_backlog_age;
+            }
+        }
+
+        if (buf->field_dominance( ) == RawFrame::UNKNOWN) {
+            buf->set_field_dominance(dominance);
+        }
+
+        try {
+            pos = buf->write_frame(dest);
+            tee(dest, dominance, timestamp);
+        } catch (...) {
+            free(dest.video_data);
+            delete dest.audio;
+            throw;
+        }
+
+        delete dest.audio;
+        dest.audio = NULL;
+
+        /* the thumbnail stage decodes at reduced size later, and frees */
+        thumbnails->offer_jpeg(dest.video_data, dest.video_size, pos);
+        dest.video_data = NULL;
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_NET_INGEST_H
+#define _REPLAY_NET_INGEST_H
+
+#include "replay_ingest.h"
+#include "replay_net_protocol.h"
+
+#include <atomic>
+#include <string>
+
+/*
+ * Receives already-compressed frames from a ReplayNetSender (on another
+ * machine, or another process over a Unix socket) and writes them
+ * straight into a replay buffer. Nothing is decoded except the reduced
+ * size thumbnails. One sender is served at a time; when it goes away
+ * the next connection is accepted.
+ *
+ * backlog_age( ) reports how old frames are on arrival, measured from
+ * the sender's capture timestamp (so both clocks should be in sync).
+ */
+class ReplayNetIngest : public ReplayIngest {
+    public:
+        ReplayNetIngest(const char *addr_, ReplayBuffer *buf_);
+        ~ReplayNetIngest( );
+
+        bool connected( ) { return conn_fd_open; }
+        uint64_t received_frames( ) { return n_received; }
+
+    protected:
+        void run_thread( );
+        void receive(int fd);
+
+        std::string addr;
+        int listen_fd;
+
+        Mutex conn_mutex; /* protects conn_fd against the destructor */
+        int conn_fd;
+        std::atomic<bool> stopping;
+        std::atomic<bool> conn_fd_open;
+        std::atomic<uint64_t> n_received;
+};
+
+#endif
@@ -17,27 +17,30 @@
  * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef _REPLAY_PLAYOUT_QUEUE_SOURCE_H
-#define _REPLAY_PLAYOUT_QUEUE_SOURCE_H
 
-#include "replay_playout_source.h"
-#include <list>
+%{
+    #include "replay_ingest.h"
+    #include "replay_net_ingest.h"
+    #include "replay_net_sender.h"
+%}
 
-class ReplayPlayoutQueueSource : public ReplayPlayoutSource {
-    public:
-        typedef std::list<ReplayPlayoutSource *> SourceQueue;
-        ReplayPlayoutQueueSource(SourceQueue &src);
-        virtual void read_frame(ReplayPlayoutFrame &frame_data, Rational speed);
-        virtual ~ReplayPlayoutQueueSource( );
+%rename("monitor") ReplayNetIngest::get_monitor( );
 
-        virtual timecode_t position( );
-        virtual timecode_t duration( );
+class ReplayNetIngest : public ReplayIngest {
+    public:
+        ReplayNetIngest(const char *INPUT, ReplayBuffer *INPUT);
+        ~ReplayNetIngest( );
 
-    protected:
-        SourceQueue sources;
-        timecode_t frames_rolled;
-        timecode_t total_duration;
-        bool duration_known;
+        bool connected( );
+        uint64_t received_frames( );
 };
 
-#endif
+class ReplayNetSender : public Thread {
+    public:
+        ReplayNetSender(const char *INPUT, unsigned int depth = 30);
+        ~ReplayNetSender( );
+
+        bool connected( );
+        uint64_t sent_frames( );
+        uint64_t dropped_frames( );
+};
@@ -0,0 +1,355 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_net_protocol.h"
+#include "posix_util.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+static bool is_unix_addr(const char *addr) {
+    return strncmp(addr, "unix:", 5) == 0;
+}
+
+static int fill_unix_addr(const char *addr, struct sockaddr_un &sun) {
+    const char *path = addr + 5;
+
+    if (strlen(path) >= sizeof(sun.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    strcpy(sun.sun_path, path);
+    return 0;
+}
+
+/* split "host:port" at the last colon; an empty host means any address */
+static struct addrinfo *lookup_inet_addr(const char *addr, bool passive) {
+    struct addrinfo ai_hints, *ai_results;
+    std::string host, port;
+    const char *colon;
+    int retval;
+
+    colon = strrchr(addr, ':');
+    if (colon == NULL) {
+        fprintf(stderr, "replay net: bad address %s\n", addr);
+        return NULL;
+    }
+
+    host.assign(addr, colon - addr);
+    port.assign(colon + 1);
+
+    memset(&ai_hints, 0, sizeof(ai_hints));
+    ai_hints.ai_family = AF_UNSPEC;
+    ai_hints.ai_socktype = SOCK_STREAM;
+    if (passive) {
+        ai_hints.ai_flags = AI_PASSIVE;
+    }
+
+    retval = getaddrinfo(
+        (host.empty( ) || host == "*") ? NULL : host.c_str( ),
+        port.c_str( ), &ai_hints, &ai_results
+    );
+
+    if (retval != 0) {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(retval));
+        return NULL;
+    }
+
+    return ai_results;
+}
+
+int replay_net_listen(const char *addr) {
+    struct addrinfo *ai_results, *ai;
+    int sockfd = -1;
+    int one = 1;
+
+    if (is_unix_addr(addr)) {
+        struct sockaddr_un sun;
+
+        if (fill_unix_addr(addr, sun) != 0) {
+            throw POSIXError("replay_net_listen");
+        }
+
+        /* a stale socket left by an earlier run would make bind() fail */
+        unlink(sun.sun_path);
+
+        sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sockfd == -1) {
+            throw POSIXError("replay_net_listen socket()");
+        }
+
+        if (bind(sockfd, (struct sockaddr *) &sun, sizeof(sun)) != 0) {
+            close(sockfd);
+            throw POSIXError("replay_net_listen bind()");
+        }
+    } else {
+        ai_results = lookup_inet_addr(addr, true);
+        if (ai_results == NULL) {
+            throw std::runtime_error("replay_net_listen: bad address");
+        }
+
+        for (ai = ai_results; ai != NULL && sockfd == -1; ai = ai->ai_next) {
+            sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (sockfd == -1) {
+                continue;
+            }
+
+            setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+            if (bind(sockfd, ai->ai_addr, ai->ai_addrlen) != 0) {
+                close(sockfd);
+                sockfd = -1;
+            }
+        }
+
+        freeaddrinfo(ai_results);
+
+        if (sockfd == -1) {
+            throw POSIXError("replay_net_listen bind()");
+        }
+    }
+
+    if (listen(sockfd, 4) != 0) {
+        close(sockfd);
+        throw POSIXError("replay_net_listen listen()");
+    }
+
+    return sockfd;
+}
+
+int replay_net_connect(const char *addr) {
+    struct addrinfo *ai_results, *ai;
+    int sockfd = -1;
+
+    if (is_unix_addr(addr)) {
+        struct sockaddr_un sun;
+
+        if (fill_unix_addr(addr, sun) != 0) {
+            return -1;
+        }
+
+        sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sockfd == -1) {
+            return -1;
+        }
+
+        if (connect(sockfd, (struct sockaddr *) &sun, sizeof(sun)) != 0) {
+            close(sockfd);
+            return -1;
+        }
+
+        return sockfd;
+    }
+
+    ai_results = lookup_inet_addr(addr, false);
+    if (ai_results == NULL) {
+        return -1;
+    }
+
+    for (ai = ai_results; ai != NULL && sockfd == -1; ai = ai->ai_next) {
+        sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sockfd == -1) {
+            continue;
+        }
+
+        if (connect(sockfd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(sockfd);
+            sockfd = -1;
+        }
+    }
+
+    freeaddrinfo(ai_results);
+    return sockfd;
+}
+
+/* 
+ * like write_all, but through send() so a vanished peer gives EPIPE 
+ * instead of killing the process; "more" lets TCP coalesce the pieces
+ */
+static ssize_t send_all(int fd, const void *data, size_t size, bool more) {
+    const uint8_t *p = (const uint8_t *) data;
+    int flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+    ssize_t ret;
+
+    while (size > 0) {
+        ret = send(fd, p, size, flags);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += ret;
+        size -= ret;
+    }
+
+    return 1;
+}
+
+ssize_t replay_net_write_frame(int fd, const ReplayFrameData &data,
+        RawFrame::FieldDominance dominance, uint64_t timestamp) {
+    ReplayNetFrameHeader hdr;
+    bool has_audio = (data.audio != NULL && data.audio->size_bytes( ) > 0);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = REPLAY_NET_MAGIC;
+    hdr.header_size = sizeof(hdr);
+    hdr.timestamp = timestamp;
+    hdr.video_size = data.video_size;
+    hdr.field_dominance = dominance;
+    if (has_audio) {
+        hdr.audio_channels = data.audio->channels( );
+        hdr.audio_samples = data.audio->size_samples( );
+    }
+
+    if (send_all(fd, &hdr, sizeof(hdr), true) != 1) {
+        return -1;
+    }
+
+    if (data.video_size > 0 && send_all(fd, data.video_data, 
+            data.video_size, has_audio) != 1) {
+        return -1;
+    }
+
+    if (has_audio && send_all(fd, data.audio->data( ), 
+            data.audio->size_bytes( ), false) != 1) {
+        return -1;
+    }
+
+    return 1;
+}
+
+/* 
+ * like read_all, but a receive timeout is an error rather than 
+ * something to retry forever
+ */
+static ssize_t recv_all(int fd, void *data, size_t size) {
+    uint8_t *p = (uint8_t *) data;
+    ssize_t ret;
+
+    while (size > 0) {
+        ret = recv(fd, p, size, 0);
+        if (ret == 0) {
+            return 0;
+        } else if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += ret;
+        size -= ret;
+    }
+
+    return 1;
+}
+
+static void throw_read_error( ) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        throw std::runtime_error("replay net: receive timed out");
+    }
+    throw POSIXError("replay_net_read_frame");
+}
+
+static void read_or_throw(int fd, void *data, size_t size) {
+    ssize_t ret = recv_all(fd, data, size);
+
+    if (ret < 0) {
+        throw_read_error( );
+    } else if (ret == 0) {
+        throw std::runtime_error("replay net: stream ended mid-frame");
+    }
+}
+
+int replay_net_read_frame(int fd, ReplayFrameData &dest,
+        RawFrame::FieldDominance &dominance, uint64_t &timestamp) {
+    ReplayNetFrameHeader hdr;
+    uint8_t skip[256];
+    size_t extra;
+    ssize_t ret;
+
+    ret = recv_all(fd, &hdr, sizeof(hdr));
+    if (ret < 0) {
+        throw_read_error( );
+    } else if (ret == 0) {
+        return 0;
+    }
+
+    if (hdr.magic != REPLAY_NET_MAGIC || hdr.header_size < sizeof(hdr)
+            || hdr.header_size > REPLAY_NET_MAX_HEADER) {
+        throw std::runtime_error("replay net: bad frame header");
+    }
+
+    if (hdr.video_size > REPLAY_NET_MAX_VIDEO 
+            || hdr.audio_channels > REPLAY_NET_MAX_AUDIO_CHANNELS
+            || hdr.audio_samples > REPLAY_NET_MAX_AUDIO_SAMPLES
+            || hdr.field_dominance > RawFrame::PROGRESSIVE) {
+        throw std::runtime_error("replay net: frame header out of range");
+    }
+
+    /* skip header fields added by newer senders */
+    extra = hdr.header_size - sizeof(hdr);
+    while (extra > 0) {
+        size_t n = (extra < sizeof(skip)) ? extra : sizeof(skip);
+        read_or_throw(fd, skip, n);
+        extra -= n;
+    }
+
+    dominance = (RawFrame::FieldDominance) hdr.field_dominance;
+    timestamp = hdr.timestamp;
+
+    dest.video_size = hdr.video_size;
+    dest.video_data = (uint8_t *) malloc(hdr.video_size > 0 
+            ? hdr.video_size : 1);
+    if (dest.video_data == NULL) {
+        throw std::bad_alloc( );
+    }
+    dest.audio = NULL;
+
+    try {
+        if (hdr.video_size > 0) {
+            read_or_throw(fd, dest.video_data, hdr.video_size);
+        }
+
+        if (hdr.audio_channels > 0 && hdr.audio_samples > 0) {
+            dest.audio = new IOAudioPacket(hdr.audio_samples, 
+                    hdr.audio_channels);
+            read_or_throw(fd, dest.audio->data( ), 
+                    dest.audio->size_bytes( ));
+        }
+    } catch (...) {
+        free(dest.video_data);
+        dest.video_data = NULL;
+        delete dest.audio;
+        dest.audio = NULL;
+        throw;
+    }
+
+    return 1;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_NET_PROTOCOL_H
+#define _REPLAY_NET_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "replay_data.h"
+
+/*
+ * Framed stream of compressed replay frames, for moving ingest between
+ * machines (or processes) without decoding anything.
+ *
+ * Every frame is a fixed header followed by video_size bytes of M-JPEG
+ * and then audio_samples * audio_channels interleaved int16 samples.
+ * Fields are in host (little-endian) byte order. A receiver skips any
+ * header bytes beyond those it knows, so the header may grow later.
+ */
+
+#define REPLAY_NET_MAGIC 0x464e524f /* "ORNF" */
+
+/* sanity limits, so a corrupt header can't make us allocate gigabytes */
+#define REPLAY_NET_MAX_HEADER 4096
+#define REPLAY_NET_MAX_VIDEO (64 << 20)
+#define REPLAY_NET_MAX_AUDIO_CHANNELS 64
+#define REPLAY_NET_MAX_AUDIO_SAMPLES 48000
+
+struct ReplayNetFrameHeader {
+    uint32_t magic;
+    uint32_t header_size;
+    uint64_t timestamp;         /* capture time, msec since the epoch */
+    uint32_t video_size;
+    uint16_t audio_channels;
+    uint16_t field_dominance;   /* RawFrame::FieldDominance */
+    uint32_t audio_samples;
+    uint32_t reserved;
+} __attribute__((packed));
+
+/*
+ * Addresses are either "unix:/path/to/socket" or "host:port".
+ * replay_net_listen throws on failure; replay_net_connect returns -1
+ * so callers can retry quietly.
+ */
+int replay_net_listen(const char *addr);
+int replay_net_connect(const char *addr);
+
+/*
+ * Send one frame. Returns 1 on success, -1 on error (check errno). 
+ * Never raises SIGPIPE if the peer has gone away.
+ */
+ssize_t replay_net_write_frame(int fd, const ReplayFrameData &data,
+        RawFrame::FieldDominance dominance, uint64_t timestamp);
+
+/*
+ * Receive one frame into dest (video_data is malloc'd, audio is new'd;
+ * the caller owns both). Returns 1 on success, 0 on a clean EOF between
+ * frames. Throws on I/O errors, on a receive timeout (SO_RCVTIMEO) or 
+ * on a malformed stream.
+ */
+int replay_net_read_frame(int fd, ReplayFrameData &dest,
+        RawFrame::FieldDominance &dominance, uint64_t &timestamp);
+
+#endif
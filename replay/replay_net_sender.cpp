@@ -0,0 +1,145 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_net_sender.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* give up on a receiver that stops reading, rather than wedge forever */
+#define SEND_TIMEOUT_SEC 5
+#define RECONNECT_INTERVAL_MSEC 1000
+
+ReplayNetSender::ReplayNetSender(const char *addr_, unsigned int depth) 
+        : addr(addr_), queue(depth + 1) {
+    sockfd = -1;
+    sockfd_open = false;
+    shutdown = false;
+    n_sent = 0;
+    n_dropped = 0;
+    start_thread( );
+}
+
+ReplayNetSender::~ReplayNetSender( ) {
+    Job job;
+
+    shutdown = true;
+    queue.done_writing( );
+    join_thread( );
+
+    /* try_get throws once the closed queue runs dry */
+    try {
+        while (queue.try_get(job)) {
+            free_job(job);
+        }
+    } catch (BrokenPipe &) { }
+
+    if (sockfd != -1) {
+        close(sockfd);
+    }
+}
+
+void ReplayNetSender::send(const ReplayFrameData &data,
+        RawFrame::FieldDominance dominance, uint64_t timestamp) {
+    Job job;
+
+    if (!sockfd_open) {
+        n_dropped++;
+        return;
+    }
+
+    job.data = new ReplayFrameData;
+    job.data->video_size = data.video_size;
+    job.data->video_data = (uint8_t *) malloc(data.video_size);
+    if (job.data->video_data == NULL) {
+        delete job.data;
+        n_dropped++;
+        return;
+    }
+    memcpy(job.data->video_data, data.video_data, data.video_size);
+    job.data->audio = data.audio ? data.audio->clone( ) : NULL;
+    job.dominance = dominance;
+    job.timestamp = timestamp;
+
+    enqueue(job);
+}
+
+/* never blocks: when full, drop the oldest job to make room */
+void ReplayNetSender::enqueue(const Job &job) {
+    Job old;
+
+    while (!queue.try_put(job)) {
+        if (queue.try_get(old)) {
+            free_job(old);
+            n_dropped++;
+        }
+    }
+}
+
+void ReplayNetSender::free_job(const Job &job) {
+    free(job.data->video_data);
+    delete job.data->audio;
+    delete job.data;
+}
+
+void ReplayNetSender::run_thread( ) {
+    struct timeval tv;
+    Job job;
+
+    while (!shutdown) {
+        if (sockfd == -1) {
+            sockfd = replay_net_connect(addr.c_str( ));
+            if (sockfd == -1) {
+                usleep(RECONNECT_INTERVAL_MSEC * 1000);
+                continue;
+            }
+
+            tv.tv_sec = SEND_TIMEOUT_SEC;
+            tv.tv_usec = 0;
+            setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+            fprintf(stderr, "replay net: sending to %s\n", addr.c_str( ));
+            sockfd_open = true;
+        }
+
+        try {
+            job = queue.get( );
+        } catch (BrokenPipe &) {
+            break;
+        }
+
+        if (replay_net_write_frame(sockfd, *job.data, 
+                job.dominance, job.timestamp) == 1) {
+            n_sent++;
+        } else {
+            perror("replay net: send");
+            sockfd_open = false;
+            close(sockfd);
+            sockfd = -1;
+            n_dropped++;
+        }
+
+        free_job(job);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_NET_SENDER_H
+#define _REPLAY_NET_SENDER_H
+
+#include "thread.h"
+#include "pipe.h"
+#include "replay_data.h"
+#include "replay_net_protocol.h"
+
+#include <atomic>
+#include <string>
+
+/*
+ * Streams a copy of an ingest's compressed frames to a ReplayNetIngest
+ * elsewhere (see replay_net_protocol.h). Frames are queued and sent by
+ * a background thread, so a slow or absent receiver never holds up the
+ * local ingest: when the queue is full the oldest frame is dropped, and
+ * while disconnected frames are dropped outright. The connection is 
+ * retried every second.
+ */
+class ReplayNetSender : public Thread {
+    public:
+        ReplayNetSender(const char *addr_, unsigned int depth = 30);
+        ~ReplayNetSender( );
+
+        /* copies the data; called from the ingest thread */
+        void send(const ReplayFrameData &data, 
+                RawFrame::FieldDominance dominance, uint64_t timestamp);
+
+        bool connected( ) { return sockfd_open; }
+        uint64_t sent_frames( ) { return n_sent; }
+        uint64_t dropped_frames( ) { return n_dropped; }
+
+    protected:
+        struct Job {
+            ReplayFrameData *data;
+            RawFrame::FieldDominance dominance;
+            uint64_t timestamp;
+        };
+
+        void run_thread( );
+        void enqueue(const Job &job);
+        static void free_job(const Job &job);
+
+        std::string addr;
+        Pipe<Job> queue;
+        int sockfd;
+
+        std::atomic<bool> sockfd_open;
+        std::atomic<bool> shutdown;
+        std::atomic<uint64_t> n_sent;
+        std::atomic<uint64_t> n_dropped;
+};
+
+#endif
@@ -21,22 +21,31 @@
 #include "replay_playout_buffer_source.h"
 #include "replay_playout_avspipe_source.h"
 #include "replay_playout_lavf_source.h"
-#include "replay_playout_queue_source.h"
+#include "replay_playout_playlist_source.h"
+#include "raw_frame_view.h"
 
-ReplayPlayout::ReplayPlayout(OutputAdapter *oadp_) {
+ReplayPlayout::ReplayPlayout(OutputAdapter *oadp_) 
+        : copies(REPLAY_FRAME_RING_SIZE), monitor_frames(4) {
     oadp = oadp_;
     idle_source = new ReplayPlayoutBarsSource;
     playout_source = NULL;
     new_speed = NULL;
+    rollout_preroll = 15;
     
     _source_position = 0;
     _source_duration = -1;
+    _source_item = 0;
+    _source_item_position = 0;
+    _source_item_duration = -1;
 
     start_thread( );
 }
 
 ReplayPlayout::~ReplayPlayout( ) {
     delete idle_source;
+    for (unsigned i = 0; i < outputs.size( ); i++) {
+        delete outputs[i];
+    }
 }
 
 void ReplayPlayout::run_thread( ) {
@@ -44,6 +53,10 @@ void ReplayPlayout::run_thread( ) {
     ReplayPlayoutSource *next_source;
     ReplayPlayoutFrame frame_data;
     ReplayRawFrame *monitor_frame;
+    RawFrameView *shared_frame;
+    ref<RawFrame> monitored; /* what the last monitor frame showed */
+    const char *monitored_name = NULL;
+    timecode_t monitored_tc = 0;
     Rational current_speed(1,1);
     Rational *next_speed;
 
@@ -63,6 +76,7 @@ void ReplayPlayout::run_thread( ) {
                 active_source->read_frame(frame_data, current_speed);
                 if (frame_data.video_data != NULL) {
                     idle_source->set_frame(frame_data.video_data);
+                    delete frame_data.audio_data;
                 }
             }
 
@@ -90,28 +104,57 @@ void ReplayPlayout::run_thread( ) {
         if (frame_data.video_data != NULL) {
             /* apply filters to frame */
             { MutexLock l(filters_mutex);
-                for (unsigned i = 0; i < filters.size( ); i++) {
-                    filters[i]->process_frame(frame_data);
+                shared_frame = dynamic_cast<RawFrameView *>(
+                        frame_data.video_data);
+                if (outputs.empty( ) && shared_frame == NULL) {
+                    /* draw first, then let the others look */
+                    for (unsigned i = 0; i < filters.size( ); i++) {
+                        if (filters[i]->modifies_frame( )) {
+                            filters[i]->process_frame(frame_data);
+                        }
+                    }
+                    for (unsigned i = 0; i < filters.size( ); i++) {
+                        if (!filters[i]->modifies_frame( )) {
+                            filters[i]->process_frame(frame_data);
+                        }
+                    }
+                } else {
+                    fan_out(frame_data);
                 }
             }
 
-            /* create monitor frame */
-            monitor_frame = new ReplayRawFrame(
-                frame_data.video_data->convert->BGRAn8_scale_1_2( )
-            );
-            monitor_frame->source_name = "Program";
-            monitor_frame->source_name2 = frame_data.source_name;
-            monitor_frame->tc = frame_data.tc;
-            monitor_frame->fractional_tc = frame_data.fractional_tc;
-            monitor.put(monitor_frame);
-
-            /* write data to output */
-            oadp->input_pipe( ).put(frame_data.video_data);
-            if (oadp->audio_input_pipe( )) {
-                oadp->audio_input_pipe( )->put(frame_data.audio_data);
+            /* 
+             * create monitor frame, unless this is the same picture
+             * the multiviewer already has (e.g. the idle source)
+             */
+            shared_frame = dynamic_cast<RawFrameView *>(
+                    frame_data.video_data);
+            if (shared_frame != NULL 
+                    && shared_frame->target( ).get( ) == monitored.get( )
+                    && frame_data.source_name == monitored_name
+                    && frame_data.tc == monitored_tc) {
+                /* nothing changed */
             } else {
-                delete frame_data.audio_data;
+                monitor_frame = new ReplayRawFrame(
+                    make_monitor_frame(frame_data.video_data)
+                );
+                monitor_frame->source_name = "Program";
+                monitor_frame->source_name2 = frame_data.source_name;
+                monitor_frame->tc = frame_data.tc;
+                monitor_frame->fractional_tc = frame_data.fractional_tc;
+                monitor.put(monitor_frame);
+
+                if (shared_frame != NULL) {
+                    monitored = shared_frame->target( );
+                } else {
+                    monitored.reset( );
+                }
+                monitored_name = frame_data.source_name;
+                monitored_tc = frame_data.tc;
             }
+
+            /* write data to output, keeping audio with its video */
+            oadp->write_frame(frame_data.video_data, frame_data.audio_data);
         } else {        
             if (active_source != idle_source) {
                 delete active_source;
@@ -122,7 +165,44 @@ void ReplayPlayout::run_thread( ) {
         /* Update source state */
         _source_position = active_source->position( );
         _source_duration = active_source->duration( );
+        _source_item = active_source->item_index( );
+        _source_item_position = active_source->item_position( );
+        _source_item_duration = active_source->item_duration( );
+    }
+}
+
+/*
+ * Share the decoded frame with the extra outputs, then filter our own
+ * copy (or view) of it. Called with filters_mutex held.
+ */
+void ReplayPlayout::fan_out(ReplayPlayoutFrame &frame_data) {
+    RawFrameView *view = dynamic_cast<RawFrameView *>(frame_data.video_data);
+    ref<RawFrame> shared;
+    IOAudioPacket *audio;
+
+    /* share what a view shows rather than the view */
+    if (view != NULL) {
+        shared = view->target( );
+        delete view;
+    } else {
+        shared = ref<RawFrame>(frame_data.video_data);
     }
+
+    for (unsigned i = 0; i < outputs.size( ); i++) {
+        audio = frame_data.audio_data ? frame_data.audio_data->clone( ) 
+                : NULL;
+        outputs[i]->offer(shared, audio, frame_data);
+    }
+
+    ReplayPlayoutOutput::apply_filters(filters, shared, frame_data, copies);
+}
+
+/* half-scale BGRA copy of f for the multiviewer, in a recycled buffer */
+RawFrame *ReplayPlayout::make_monitor_frame(RawFrame *f) {
+    RawFrame *ret = monitor_frames.get(f->w( ) / 2, f->h( ) / 2, 
+            RawFrame::BGRAn8);
+    f->unpack->BGRAn8_scale_1_2(ret->data( ));
+    return ret;
 }
 
 void ReplayPlayout::set_source(ReplayPlayoutSource *src) {
@@ -171,27 +251,36 @@ void ReplayPlayout::register_filter(ReplayPlayoutFilter *filt) {
     filters.push_back(filt);
 }
 
+ReplayPlayoutOutput *ReplayPlayout::add_output(OutputAdapter *oadp_) {
+    ReplayPlayoutOutput *output = new ReplayPlayoutOutput(oadp_);
+    MutexLock l(filters_mutex);
+    outputs.push_back(output);
+    return output;
+}
+
 void ReplayPlayout::avspipe_playout(const char *cmd) {
     set_source(new ReplayPlayoutAvspipeSource(cmd));
 }
 
 void ReplayPlayout::lavf_playout(const char *file) {
-    set_source(new ReplayPlayoutLavfSource(file));
+    ReplayPlayoutLavfSource *src = new ReplayPlayoutLavfSource(file);
+    src->start(rollout_preroll);
+    set_source(src);
 }
 
 void ReplayPlayout::lavf_playout(const char *file, int64_t seek) {
     ReplayPlayoutLavfSource *src = new ReplayPlayoutLavfSource(file);
     src->seek(seek);
+    src->start(rollout_preroll);
     set_source(src);
 }
 
 void ReplayPlayout::lavf_playout_list(const StringList &files) {
-    ReplayPlayoutQueueSource::SourceQueue sources;
-    for (auto i = files.begin(); i != files.end(); i++) {
-        sources.push_back(new ReplayPlayoutLavfSource(*i));
-    }
+    set_source(new ReplayPlayoutPlaylistSource(files, rollout_preroll));
+}
 
-    set_source(new ReplayPlayoutQueueSource(sources));
+void ReplayPlayout::set_rollout_preroll(unsigned int frames) {
+    rollout_preroll = frames;
 }
 
 timecode_t ReplayPlayout::source_position( ) {
@@ -202,3 +291,15 @@ timecode_t ReplayPlayout::source_duration( ) {
     return _source_duration;
 }
 
+int ReplayPlayout::source_item( ) {
+    return _source_item;
+}
+
+timecode_t ReplayPlayout::source_item_position( ) {
+    return _source_item_position;
+}
+
+timecode_t ReplayPlayout::source_item_duration( ) {
+    return _source_item_duration;
+}
+
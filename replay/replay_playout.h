@@ -29,6 +29,8 @@
 #include "replay_playout_source.h"
 #include "replay_playout_filter.h"
 #include "replay_playout_bars_source.h"
+#include "replay_playout_output.h"
+#include "replay_frame_ring.h"
 
 #include <list>
 #include <vector>
@@ -68,6 +70,12 @@ class ReplayPlayout : public Thread {
          */
         void register_filter(ReplayPlayoutFilter *filt);
 
+        /*
+         * Add another output fed from the same decoded frames, with 
+         * its own filters. The playout owns the returned object.
+         */
+        ReplayPlayoutOutput *add_output(OutputAdapter *oadp_);
+
         /*
          * Stop, or more precisely, return to idle source.
          */
@@ -97,11 +105,20 @@ class ReplayPlayout : public Thread {
          */
         void lavf_playout_list(const StringList &files);
 
+        /*
+         * Number of frames to decode ahead before a lavf rollout 
+         * goes to air (default 15).
+         */
+        void set_rollout_preroll(unsigned int frames);
+
         /*
          * Get information about the current playout source state
          */
         timecode_t source_position( );
         timecode_t source_duration( );
+        int source_item( );
+        timecode_t source_item_position( );
+        timecode_t source_item_duration( );
 
         /* Multiviewer ports. */
         AsyncPort<ReplayRawFrame> monitor;
@@ -109,6 +126,8 @@ class ReplayPlayout : public Thread {
 
     protected:
         void run_thread( );
+        void fan_out(ReplayPlayoutFrame &frame_data);
+        RawFrame *make_monitor_frame(RawFrame *f);
 
         struct SourceState {
             timecode_t position;
@@ -123,11 +142,23 @@ class ReplayPlayout : public Thread {
         OutputAdapter *oadp;
         ReplayPlayoutBarsSource *idle_source;
         std::vector<ReplayPlayoutFilter *> filters;
+        std::vector<ReplayPlayoutOutput *> outputs;
         std::atomic<ReplayPlayoutSource *> playout_source;
         std::atomic<Rational *> new_speed;
         std::atomic<timecode_t> _source_position;
         std::atomic<timecode_t> _source_duration;
-        Mutex filters_mutex;
+        std::atomic<int> _source_item;
+        std::atomic<timecode_t> _source_item_position;
+        std::atomic<timecode_t> _source_item_duration;
+        Mutex filters_mutex; /* also protects outputs */
+        unsigned int rollout_preroll;
+
+        /* 
+         * recycled buffers for frames the playout makes itself: copies
+         * for filters to draw on, and multiviewer frames
+         */
+        ReplayFrameRing copies;
+        ReplayFrameRing monitor_frames;
 
         std::vector<ChannelMapEntry> channel_map;
 };
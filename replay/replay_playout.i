@@ -23,6 +23,7 @@
 
 %include "typemaps.i"
 %include "replay_playout_filter.i"
+%include "replay_playout_output.i"
 %include "string_list.i"
 
 %rename("shot=") ReplayPlayout::roll_shot(const ReplayShot &);
@@ -39,15 +40,20 @@ class ReplayPlayout : public Thread {
         void set_speed(int, int);
         AsyncPort<ReplayRawFrame> *get_monitor( );
         void register_filter(ReplayPlayoutFilter *INPUT);
+        ReplayPlayoutOutput *add_output(OutputAdapter *INPUT);
         void stop( );
         void avspipe_playout(const char *INPUT);
         void lavf_playout(const char *INPUT);
         void lavf_playout(const char *INPUT, int64_t);
         void lavf_playout_list(const StringList &INPUT);
+        void set_rollout_preroll(unsigned int);
         void map_channel(unsigned int, ReplayBuffer *INPUT);
         void clear_channel_map( );
         timecode_t source_position( );
         timecode_t source_duration( );
+        int source_item( );
+        timecode_t source_item_position( );
+        timecode_t source_item_duration( );
 };
 
 
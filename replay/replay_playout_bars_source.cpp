@@ -19,6 +19,7 @@
 
 #include "replay_playout_bars_source.h"
 #include "posix_util.h"
+#include "raw_frame_view.h"
 #include <math.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -26,44 +27,48 @@
 
 ReplayPlayoutBarsSource::ReplayPlayoutBarsSource( ) {
     int barsfd;
+    RawFrame *bars_frame;
 
-    bars = new RawFrame(1920, 1080, RawFrame::CbYCrY8422);
+    bars_frame = new RawFrame(1920, 1080, RawFrame::CbYCrY8422);
+    bars = ref<RawFrame>(bars_frame);
 
     barsfd = open("../files/1080p_bars.uyvy", O_RDONLY);
     if (barsfd == -1) {
         throw POSIXError("cannot load color bars");
     }
 
-    bars->read_from_fd(barsfd);
+    bars_frame->read_from_fd(barsfd);
     close(barsfd);
 
     phase = 0;
 }
 
 ReplayPlayoutBarsSource::~ReplayPlayoutBarsSource( ) {
-    delete bars;
+
 }
 
 void ReplayPlayoutBarsSource::read_frame(ReplayPlayoutFrame &frame_data, 
         Rational speed) {
     (void) speed;
 
-    frame_data.video_data = bars->copy( );
+    frame_data.video_data = new RawFrameView(bars);
     frame_data.audio_data = audio_allocator.allocate( );
     frame_data.tc = 0;
     frame_data.fractional_tc = 0;
     frame_data.source_name = "No Source";
-    memset(frame_data.audio_data->data( ), 0, 
-        frame_data.audio_data->size_bytes( ));
+    frame_data.audio_data->zero( );
 }
 
 void ReplayPlayoutBarsSource::set_frame(RawFrame *frame) {
-    if (bars) {
-        delete bars;
-        bars = NULL;
+    RawFrameView *view = dynamic_cast<RawFrameView *>(frame);
+
+    /* hold on to the frame itself rather than a view of a view */
+    if (view != NULL) {
+        bars = view->target( );
+        delete view;
+    } else {
+        bars = ref<RawFrame>(frame);
     }
-
-    bars = frame;
 }
 
 void ReplayPlayoutBarsSource::oscillate(IOAudioPacket *pkt, float frequency) {
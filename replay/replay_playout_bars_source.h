@@ -22,7 +22,13 @@
 
 #include "replay_playout_source.h"
 #include "avspipe_allocators.h"
+#include "ref.h"
 
+/*
+ * The idle source. Every frame is a read-only view of one held frame
+ * (bars, or the last frame of whatever was stopped), so idling costs
+ * no copying.
+ */
 class ReplayPlayoutBarsSource : public ReplayPlayoutSource {
     public:
         ReplayPlayoutBarsSource( );
@@ -34,7 +40,7 @@ class ReplayPlayoutBarsSource : public ReplayPlayoutSource {
         timecode_t position( );
 
     protected:
-        RawFrame *bars;
+        ref<RawFrame> bars;
         AvspipeNTSCSyncAudioAllocator audio_allocator;
 
         void oscillate(IOAudioPacket *pkt, float frequency);
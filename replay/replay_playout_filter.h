@@ -28,6 +28,15 @@ class ReplayPlayoutFilter {
         virtual void disable( ) = 0;
         virtual bool is_enabled( ) = 0;
         virtual void process_frame(ReplayPlayoutFrame &frame) = 0;
+
+        /* 
+         * Filters that only look at the video (scopes, say) return 
+         * false, so a frame shared between outputs need not be copied.
+         * They run after the filters that draw, so they may keep a 
+         * reference to the frame (replacing it with a RawFrameView of 
+         * itself if it isn't one already).
+         */
+        virtual bool modifies_frame( ) { return true; }
         virtual ~ReplayPlayoutFilter( ) { }
 };
 
@@ -18,7 +18,7 @@
  */
 
 #include "replay_playout_image_filter.h"
-#include "rsvg_frame.h"
+#include "raster_cache.h"
 
 ReplayPlayoutImageFilter::ReplayPlayoutImageFilter(
         RawFrame *image_,
@@ -58,7 +58,7 @@ ReplayPlayoutImageFilter *ReplayPlayoutImageFilter::from_svg(
         coord_t x,
         coord_t y
 ) {
-    RawFrame *image = RsvgFrame::render_svg_file(path);
+    RawFrame *image = RasterCache::get( ).svg_file(path);
     return new ReplayPlayoutImageFilter(image, x, y);
 }
 
@@ -67,6 +67,6 @@ ReplayPlayoutImageFilter *ReplayPlayoutImageFilter::from_png(
         coord_t x,
         coord_t y
 ) {
-    RawFrame *image = RawFrame::from_image_file(path);
+    RawFrame *image = RasterCache::get( ).image_file(path);
     return new ReplayPlayoutImageFilter(image, x, y);
 }
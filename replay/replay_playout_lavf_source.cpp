@@ -20,11 +20,14 @@
 /* based on github.com/chelyaev/ffmpeg-tutorial */
 
 #include "replay_playout_lavf_source.h"
+#include "lavc_raw_frame.h"
+#include "raw_frame_view.h"
 
 timecode_t ReplayPlayoutLavfSource::get_file_duration(
         const char *filename 
 ) {
     timecode_t n_frames = 0;
+    int video_stream = -1;
 
     AVFormatContext *format_ctx = NULL;
     ensure_registered( );
@@ -39,15 +42,28 @@ timecode_t ReplayPlayoutLavfSource::get_file_duration(
 
     for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
         if (format_ctx->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO) {
-            n_frames = format_ctx->streams[i]->nb_frames;
+            video_stream = i;
         }
     }
     
     avformat_close_input(&format_ctx);
+
+    /* 
+     * count frames the way playback does; nb_frames is only the 
+     * container's claim (and often 0). The index is saved, so opening
+     * the file for playback later does not scan it again.
+     */
+    if (video_stream >= 0) {
+        n_frames = LavfFrameIndex(filename, video_stream).frames( );
+    }
+
     return n_frames;
 }
 
-ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(const char *filename) : 
+ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(
+        const char *filename_, 
+        unsigned int queue_depth_
+) : 
     format_ctx(NULL),
     video_stream(-1),
     audio_stream(-1),
@@ -57,7 +73,15 @@ ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(const char *filename) :
     audio_codecctx(NULL),
     audio_codec(NULL),
     n_frames(0),
-    pending_audio(2 /* stereo */)
+    pending_audio(2 /* stereo */),
+    filename(filename_),
+    index(NULL),
+    skip_pts(AV_NOPTS_VALUE),
+    started(false),
+    queue_depth(queue_depth_),
+    ready(queue_depth_ + 1),
+    decoded(0),
+    decode_done(false)
 {
 	ensure_registered( );
 	
@@ -67,7 +91,7 @@ ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(const char *filename) :
     }
 
     // Try to open file
-    if (avformat_open_input(&format_ctx, filename, NULL, NULL) != 0) {
+    if (avformat_open_input(&format_ctx, filename_, NULL, NULL) != 0) {
         throw std::runtime_error("avformat_open_input failed");
     }
 
@@ -75,7 +99,7 @@ ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(const char *filename) :
         throw std::runtime_error("avformat_find_stream_info failed");
     }
 
-    av_dump_format(format_ctx, 0, filename, 0);
+    av_dump_format(format_ctx, 0, filename_, 0);
 
     // find video stream
     video_stream = -1;
@@ -104,6 +128,16 @@ ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(const char *filename) :
         throw std::runtime_error("unsupported video codec!");   
     }
 
+    /* 
+     * let libavcodec use all the cores: frame threading adds a little 
+     * latency, which the decode-ahead queue hides 
+     */
+    video_codecctx->thread_count = 0;
+    video_codecctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    /* so decoded pictures can be handed on without copying */
+    video_codecctx->refcounted_frames = 1;
+
     if (avcodec_open2(video_codecctx, video_codec, NULL) < 0) {
         throw std::runtime_error("failed to open codec!");
     }
@@ -124,6 +158,30 @@ ReplayPlayoutLavfSource::ReplayPlayoutLavfSource(const char *filename) :
 }
 
 ReplayPlayoutLavfSource::~ReplayPlayoutLavfSource( ) {
+    LavfFrame f;
+
+    if (started) {
+        /* kick the decoder out of put( ) and wait for it to finish */
+        ready.done_reading( );
+        join_thread( );
+
+        try {
+            while (ready.try_get(f)) {
+                delete f.video;
+                delete f.audio;
+            }
+        } catch (BrokenPipe &) {
+            /* drained */
+        }
+    }
+
+    delete index;
+
+    while (!pending_video_frames.empty( )) {
+        delete pending_video_frames.front( );
+        pending_video_frames.pop_front( );
+    }
+
     av_free(lavc_frame);
     avcodec_close(video_codecctx);
     avformat_close_input(&format_ctx);
@@ -136,20 +194,115 @@ void ReplayPlayoutLavfSource::ensure_registered( ) {
     }
 }
 
+LavfFrameIndex *ReplayPlayoutLavfSource::frame_index( ) {
+    if (index == NULL) {
+        index = new LavfFrameIndex(filename.c_str( ), video_stream);
+    }
+
+    return index;
+}
+
 void ReplayPlayoutLavfSource::seek(int64_t usec) {
-	int ret;
+    seek_frame(frame_at(usec));
+}
+
+void ReplayPlayoutLavfSource::seek_frame(timecode_t frame) {
+    LavfFrameIndex *idx = frame_index( );
+    size_t key;
+
+    if (started) {
+        throw std::runtime_error("cannot seek after decoding has started");
+    }
 
-	ret = av_seek_frame(format_ctx, -1, usec, 0);
+    if (frame < 0) {
+        frame = 0;
+    } else if ((size_t) frame >= idx->frames( )) {
+        frame = idx->frames( ) - 1;
+    }
+
+    key = idx->keyframe_before(frame);
+
+    if (av_seek_frame(format_ctx, video_stream, idx->seek_timestamp(key), 
+                AVSEEK_FLAG_BACKWARD) < 0
+            && av_seek_frame(format_ctx, video_stream, 
+                idx->seek_position(key), AVSEEK_FLAG_BYTE) < 0) {
+        fprintf(stderr, "av_seek_frame() failed!\n");
+        return;
+    }
+
+    avcodec_flush_buffers(video_codecctx);
+    avcodec_flush_buffers(audio_codecctx);
+
+    /* throw away whatever was decoded before the seek */
+    while (!pending_video_frames.empty( )) {
+        delete pending_video_frames.front( );
+        pending_video_frames.pop_front( );
+    }
+    pending_audio.pop_samples(pending_audio.fill_samples( ));
 
-	if (ret < 0) {
-		fprintf(stderr, "av_seek_frame() failed!\n");
-	}
+    /* then decode forward from the keyframe to the one we want */
+    skip_pts = idx->pts(frame);
+    n_frames = frame;
+}
+
+timecode_t ReplayPlayoutLavfSource::frame_at(int64_t usec) {
+    AVStream *stream = format_ctx->streams[video_stream];
+    AVRational usec_base = { 1, 1000000 };
+    int64_t ts = av_rescale_q(usec, usec_base, stream->time_base);
+
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        ts += stream->start_time;
+    }
+
+    return frame_index( )->frame_at(ts);
+}
+
+timecode_t ReplayPlayoutLavfSource::keyframe_before(timecode_t frame) {
+    LavfFrameIndex *idx = frame_index( );
+
+    if (frame < 0) {
+        frame = 0;
+    } else if ((size_t) frame >= idx->frames( )) {
+        frame = idx->frames( ) - 1;
+    }
+
+    return idx->keyframe_before(frame);
+}
+
+timecode_t ReplayPlayoutLavfSource::frames( ) {
+    return frame_index( )->frames( );
+}
+
+void ReplayPlayoutLavfSource::start(unsigned int prime_frames) {
+    if (started) {
+        return;
+    }
+
+    if (prime_frames > queue_depth) {
+        prime_frames = queue_depth;
+    }
+
+    /* 
+     * build the index here rather than on the playout thread, 
+     * which asks for duration( ) every frame
+     */
+    frame_index( );
+
+    started = true;
+    start_thread( );
+
+    MutexLock l(m);
+    while (decoded < prime_frames && !decode_done) {
+        decoded_cond.wait(m);
+    }
 }
 
 void ReplayPlayoutLavfSource::read_frame(
         ReplayPlayoutFrame &frame_data, 
         Rational speed
 ) {
+    LavfFrame f;
+    bool got;
 
     frame_data.tc = 0;
     frame_data.fractional_tc = Rational(0);
@@ -157,26 +310,109 @@ void ReplayPlayoutLavfSource::read_frame(
     frame_data.video_data = NULL;
     frame_data.audio_data = NULL;
 
-    IOAudioPacket *audio = audio_allocator.allocate( );
-
     (void) speed;
 
+    if (!started) {
+        if (decode_frame(frame_data.video_data, frame_data.audio_data)) {
+            n_frames++;
+        }
+        return;
+    }
+
+    try {
+        got = ready.try_get(f);
+        if (!got && last_video.is_null( )) {
+            /* nothing to fall back on, so we have to wait */
+            f = ready.get( );
+            got = true;
+        }
+    } catch (BrokenPipe &) {
+        /* decoder reached the end of the file */
+        return;
+    }
+
+    if (!got) {
+        /* decoder fell behind: repeat the last frame with silence */
+        fprintf(stderr, "ReplayPlayoutLavfSource: underrun\n");
+        frame_data.video_data = new RawFrameView(last_video);
+        frame_data.audio_data = underrun_allocator.allocate( );
+        memset(frame_data.audio_data->data( ), 0, 
+                frame_data.audio_data->size_bytes( ));
+        return;
+    }
+
+    /* keep a reference in case the next frame isn't ready in time */
+    last_video = ref<RawFrame>(f.video);
+
+    frame_data.video_data = new RawFrameView(last_video);
+    frame_data.audio_data = f.audio;
+    n_frames++;
+}
+
+bool ReplayPlayoutLavfSource::decode_frame(
+        RawFrame *&video, 
+        IOAudioPacket *&audio
+) {
+    audio = audio_allocator.allocate( );
+
     while (pending_video_frames.size( ) == 0 
             || pending_audio.fill_samples( ) < audio->size_samples( )) {
         if (run_lavc( ) == 0) {
+            if (pending_video_frames.size( ) > 0) {
+                /* 
+                 * end of file with the audio running out first: 
+                 * still play the last frames, with silence
+                 */
+                std::vector<int16_t> silence(audio->channels( ) * 
+                    (audio->size_samples( ) - pending_audio.fill_samples( )));
+                pending_audio.add_packed_samples(&silence[0], 
+                    silence.size( ) / audio->channels( ));
+                break;
+            }
+
             delete audio;
-            return;
+            audio = NULL;
+            video = NULL;
+            return false;
         }
     }
 
-    frame_data.video_data = pending_video_frames.front( );
+    video = pending_video_frames.front( );
     pending_video_frames.pop_front( );
     
     /* something something dequeue sample frames... */
     pending_audio.fill_packet(audio);
-    frame_data.audio_data = audio;
+    return true;
+}
 
-    n_frames++;
+void ReplayPlayoutLavfSource::run_thread( ) {
+    LavfFrame f;
+
+    try {
+        while (decode_frame(f.video, f.audio)) {
+            try {
+                ready.put(f);
+            } catch (BrokenPipe &) {
+                /* source is being destroyed */
+                delete f.video;
+                delete f.audio;
+                break;
+            }
+
+            MutexLock l(m);
+            decoded++;
+            decoded_cond.signal( );
+        }
+    } catch (std::exception &e) {
+        fprintf(stderr, "ReplayPlayoutLavfSource: decode failed: %s\n", 
+                e.what( ));
+    }
+
+    ready.done_writing( );
+
+    MutexLock l(m);
+    decode_done = true;
+    decoded_cond.signal( );
 }
 
 static void copy_fltp(
@@ -199,6 +435,16 @@ static void copy_fltp(
     }
 }
 
+bool ReplayPlayoutLavfSource::audio_before_skip(const AVPacket &packet) {
+    if (skip_pts == AV_NOPTS_VALUE || packet.pts == AV_NOPTS_VALUE) {
+        return false;
+    }
+
+    return av_rescale_q(packet.pts, 
+            format_ctx->streams[audio_stream]->time_base,
+            format_ctx->streams[video_stream]->time_base) < skip_pts;
+}
+
 int ReplayPlayoutLavfSource::run_lavc( ) {
     AVPacket packet;
     int frame_finished = 0;
@@ -208,12 +454,36 @@ int ReplayPlayoutLavfSource::run_lavc( ) {
      * read stream until we get a video frame, 
      * possibly also decoding some audio along the way
      */
-    while (frame_finished == 0 && audio_finished == 0 &&
-            av_read_frame(format_ctx, &packet) >= 0) {
+    while (frame_finished == 0 && audio_finished == 0) {
+        if (av_read_frame(format_ctx, &packet) < 0) {
+            /* 
+             * end of file: flush out any frames still inside 
+             * the (frame-threaded) decoder, one per call
+             */
+            av_init_packet(&packet);
+            packet.data = NULL;
+            packet.size = 0;
+            avcodec_decode_video2(video_codecctx, lavc_frame, 
+                    &frame_finished, &packet);
+            break;
+        }
+
         if (packet.stream_index == video_stream) {
             avcodec_decode_video2(video_codecctx, lavc_frame, 
                     &frame_finished, &packet);
-        } else if (packet.stream_index == audio_stream) {
+
+            /* decoding forward after a seek: drop frames until the target */
+            if (frame_finished && skip_pts != AV_NOPTS_VALUE) {
+                int64_t ts = av_frame_get_best_effort_timestamp(lavc_frame);
+                if (ts != AV_NOPTS_VALUE && ts < skip_pts) {
+                    av_frame_unref(lavc_frame);
+                    frame_finished = 0;
+                } else {
+                    skip_pts = AV_NOPTS_VALUE;
+                }
+            }
+        } else if (packet.stream_index == audio_stream 
+                && !audio_before_skip(packet)) {
             avcodec_decode_audio4(audio_codecctx, audio_frame, 
                     &audio_finished, &packet);
         }
@@ -222,54 +492,9 @@ int ReplayPlayoutLavfSource::run_lavc( ) {
     }
 
     if (frame_finished) {
-        /* make a RawFrame out of lavc_frame */
-        RawFrame *fr = new RawFrame(1920, 1080, RawFrame::CbYCrY8422);
-        switch (lavc_frame->format) {
-            case AV_PIX_FMT_YUVJ422P:
-            case AV_PIX_FMT_YUV422P:
-                fr->pack->YCbCr8P422(
-                    lavc_frame->data[0], 
-                    lavc_frame->data[1],
-                    lavc_frame->data[2],
-                    lavc_frame->linesize[0],
-                    lavc_frame->linesize[1],
-                    lavc_frame->linesize[2]
-                );
-                break;
-
-            case AV_PIX_FMT_UYVY422:
-                /* copy stuff */
-                memcpy(fr->data( ), lavc_frame->data[0], fr->size( ));
-                break;
-
-            case AV_PIX_FMT_YUV422P10LE:
-                fr->pack->YCbCr10P422(
-                    (uint16_t *)lavc_frame->data[0],
-                    (uint16_t *)lavc_frame->data[1],
-                    (uint16_t *)lavc_frame->data[2],
-                    lavc_frame->linesize[0] / 2,
-                    lavc_frame->linesize[1] / 2,
-                    lavc_frame->linesize[2] / 2
-                );
-                break;
-
-            case AV_PIX_FMT_YUV420P:
-                fr->pack->YCbCr8P420(
-                    lavc_frame->data[0],
-                    lavc_frame->data[1],
-                    lavc_frame->data[2],
-                    lavc_frame->linesize[0],
-                    lavc_frame->linesize[1],
-                    lavc_frame->linesize[2]
-                );
-                break;
-
-            default:
-                fprintf(stderr, "ReplayPlayoutLavfSource doesn't know how "
-                    "to handle AVPixelFormat %d\n", lavc_frame->format);
-                memset(fr->data( ), 128, fr->size( ));
-                break;
-        }
+        /* wraps lavc_frame directly if it's already CbYCrY8422 */
+        RawFrame *fr = LavcRawFrame::from_avframe(lavc_frame);
+        av_frame_unref(lavc_frame);
 
         pending_video_frames.push_back(fr);
         return 1;
@@ -312,6 +537,6 @@ timecode_t ReplayPlayoutLavfSource::position( ) {
 }
 
 timecode_t ReplayPlayoutLavfSource::duration( ) {
-    return format_ctx->streams[video_stream]->nb_frames;
+    return frames( );
 }
 int ReplayPlayoutLavfSource::registered = 0;
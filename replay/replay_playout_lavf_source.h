@@ -23,7 +23,14 @@
 #include "replay_playout_source.h"
 #include "avspipe_allocators.h"
 #include "audio_fifo.h"
+#include "thread.h"
+#include "pipe.h"
+#include "mutex.h"
+#include "condition.h"
+#include "lavf_frame_index.h"
+#include "ref.h"
 #include <list>
+#include <string>
 
 /* silly ffmpeg... */
 extern "C" {
@@ -34,13 +41,41 @@ extern "C" {
     #undef PixelFormat
 }
 
-class ReplayPlayoutLavfSource : public ReplayPlayoutSource {
+/*
+ * Plays out a file through libavformat/libavcodec.
+ *
+ * Until start( ) is called, frames are decoded synchronously in 
+ * read_frame( ). After start( ), a background thread decodes ahead into
+ * a bounded queue, so a slow GOP or a big I-frame is absorbed by the
+ * queue rather than landing on the playout thread. If the queue ever
+ * runs dry anyway, the last frame is repeated instead of stalling output.
+ */
+class ReplayPlayoutLavfSource : public ReplayPlayoutSource, public Thread {
     public:
-        ReplayPlayoutLavfSource(const char *filename);
+        ReplayPlayoutLavfSource(const char *filename, 
+                unsigned int queue_depth = 30);
         ~ReplayPlayoutLavfSource( );
 
-        /* dirty hack job to test out seeking */
+        /* 
+         * Seek so the next frame read is exactly the given frame,
+         * decoding forward from the keyframe before it. Seeking by 
+         * time goes to the frame presented at that time. Both build 
+         * (or load) the file's frame index on first use, and are only
+         * valid before start( ).
+         */
         void seek(int64_t usec);
+        void seek_frame(timecode_t frame);
+
+        /* frame numbers, as used by seek_frame */
+        timecode_t frame_at(int64_t usec);
+        timecode_t keyframe_before(timecode_t frame);
+        timecode_t frames( );
+
+        /* 
+         * Start decoding ahead, and block until prime_frames frames 
+         * are ready (or the file ends).
+         */
+        void start(unsigned int prime_frames);
 
         void read_frame(ReplayPlayoutFrame &frame_data, Rational speed);
         static timecode_t get_file_duration(const char *filename);
@@ -50,8 +85,21 @@ class ReplayPlayoutLavfSource : public ReplayPlayoutSource {
         /* call first, makes sure av_register_all has been called */
         static void ensure_registered( );
 
+        LavfFrameIndex *frame_index( );
+
         /* try to put more stuff in the queues */
         int run_lavc( );
+        bool audio_before_skip(const AVPacket &packet);
+
+        /* decode the next frame of video and its audio */
+        bool decode_frame(RawFrame *&video, IOAudioPacket *&audio);
+
+        void run_thread( );
+
+        struct LavfFrame {
+            RawFrame *video;
+            IOAudioPacket *audio;
+        };
 
         AVFormatContext *format_ctx;
         int video_stream;
@@ -68,11 +116,33 @@ class ReplayPlayoutLavfSource : public ReplayPlayoutSource {
         timecode_t n_frames;
         AudioFIFO<int16_t> pending_audio;
 
+        std::string filename;
+        LavfFrameIndex *index;
+
+        /* after a seek, decoded output before this is dropped */
+        int64_t skip_pts;
+
         /* uninitialized / static data */
         AvspipeNTSCSyncAudioAllocator audio_allocator;
         static int registered;
 
         std::list<RawFrame *> pending_video_frames;
+
+        /* decode-ahead state */
+        bool started;
+        unsigned int queue_depth;
+        Pipe<LavfFrame> ready;
+        Mutex m;
+        Condition decoded_cond;
+        unsigned int decoded;
+        bool decode_done;
+
+        /* 
+         * the frame played last, to repeat if the decoder falls behind;
+         * it goes out as RawFrameViews so it's never copied
+         */
+        ref<RawFrame> last_video;
+        AvspipeNTSCSyncAudioAllocator underrun_allocator;
 };
 
 #endif
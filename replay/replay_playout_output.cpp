@@ -0,0 +1,135 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_playout_output.h"
+#include "raw_frame_view.h"
+
+ReplayPlayoutOutput::ReplayPlayoutOutput(OutputAdapter *oadp_, 
+        unsigned int depth) : copies(REPLAY_FRAME_RING_SIZE), 
+        queue(depth + 1) {
+    oadp = oadp_;
+    n_dropped = 0;
+    start_thread( );
+}
+
+ReplayPlayoutOutput::~ReplayPlayoutOutput( ) {
+    Job job;
+
+    queue.done_writing( );
+    join_thread( );
+
+    /* try_get throws once the closed queue runs dry */
+    try {
+        while (queue.try_get(job)) {
+            free_job(job);
+        }
+    } catch (BrokenPipe &) { }
+}
+
+void ReplayPlayoutOutput::register_filter(ReplayPlayoutFilter *filt) {
+    MutexLock l(filters_mutex);
+    filters.push_back(filt);
+}
+
+void ReplayPlayoutOutput::apply_filters(
+        const std::vector<ReplayPlayoutFilter *> &filters,
+        const ref<RawFrame> &shared,
+        ReplayPlayoutFrame &frame_data,
+        ReplayFrameRing &ring) {
+    std::vector<ReplayPlayoutFilter *> enabled, watching;
+    bool writes;
+
+    /* 
+     * A filter may be switched on from another thread at any time.
+     * Decide on one set up front, so none draws into a shared frame.
+     * Those that only look go last and see the finished frame.
+     */
+    for (unsigned i = 0; i < filters.size( ); i++) {
+        if (filters[i]->is_enabled( )) {
+            if (filters[i]->modifies_frame( )) {
+                enabled.push_back(filters[i]);
+            } else {
+                watching.push_back(filters[i]);
+            }
+        }
+    }
+
+    writes = !enabled.empty( );
+    enabled.insert(enabled.end( ), watching.begin( ), watching.end( ));
+
+    /* copy on write: only outputs that draw pay for a copy */
+    if (writes) {
+        frame_data.video_data = ring.clone(shared.get( ));
+    } else {
+        frame_data.video_data = new RawFrameView(shared);
+    }
+
+    for (unsigned i = 0; i < enabled.size( ); i++) {
+        enabled[i]->process_frame(frame_data);
+    }
+}
+
+/* never blocks the playout: when full, drop the oldest frame */
+void ReplayPlayoutOutput::offer(const ref<RawFrame> &video,
+        IOAudioPacket *audio, const ReplayPlayoutFrame &info) {
+    Job job, old;
+
+    job.video = video;
+    job.audio = audio;
+    job.info = info;
+
+    while (!queue.try_put(job)) {
+        if (queue.try_get(old)) {
+            free_job(old);
+            n_dropped++;
+        }
+    }
+}
+
+void ReplayPlayoutOutput::free_job(const Job &job) {
+    delete job.audio;
+}
+
+void ReplayPlayoutOutput::run_thread( ) {
+    ReplayPlayoutFrame frame_data;
+    Job job;
+
+    priority(SCHED_RR, 40);
+
+    for (;;) {
+        try {
+            job = queue.get( );
+        } catch (BrokenPipe &) {
+            break;
+        }
+
+        frame_data = job.info;
+        frame_data.audio_data = job.audio;
+
+        { MutexLock l(filters_mutex);
+            apply_filters(filters, job.video, frame_data, copies);
+        }
+
+        /* let go of the shared frame before possibly blocking below */
+        job.video.reset( );
+
+        oadp->write_frame(frame_data.video_data, frame_data.audio_data);
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_PLAYOUT_OUTPUT_H
+#define _REPLAY_PLAYOUT_OUTPUT_H
+
+#include "thread.h"
+#include "mutex.h"
+#include "pipe.h"
+#include "adapter.h"
+#include "replay_data.h"
+#include "replay_playout_filter.h"
+#include "replay_frame_ring.h"
+
+#include "ref.h"
+
+#include <atomic>
+#include <vector>
+
+/*
+ * An additional output of a ReplayPlayout, with a filter chain of its
+ * own (e.g. a clean feed next to the graphics feed, from one decode).
+ *
+ * The playout hands every decoded frame to each output by reference.
+ * An output whose filters would draw on the frame takes a private copy
+ * first; one without such filters sends the shared frame as it is. 
+ * Each output runs its own thread, so a slow adapter drops (oldest 
+ * first) instead of holding up the program output.
+ */
+class ReplayPlayoutOutput : public Thread {
+    public:
+        ReplayPlayoutOutput(OutputAdapter *oadp_, unsigned int depth = 4);
+        ~ReplayPlayoutOutput( );
+
+        void register_filter(ReplayPlayoutFilter *filt);
+
+        /* called from the playout thread; takes ownership of audio */
+        void offer(const ref<RawFrame> &video, 
+                IOAudioPacket *audio, const ReplayPlayoutFrame &info);
+
+        OutputAdapter *adapter( ) { return oadp; }
+        uint64_t dropped_frames( ) { return n_dropped; }
+
+        /* 
+         * Run a filter chain on frame_data, first swapping the shared
+         * video for a private copy (taken from ring) if some filter is 
+         * going to draw. Callers hold the lock protecting the chain.
+         */
+        static void apply_filters(
+                const std::vector<ReplayPlayoutFilter *> &filters,
+                const ref<RawFrame> &shared,
+                ReplayPlayoutFrame &frame_data,
+                ReplayFrameRing &ring);
+
+    protected:
+        struct Job {
+            ref<RawFrame> video;
+            IOAudioPacket *audio;
+            ReplayPlayoutFrame info;
+        };
+
+        void run_thread( );
+        static void free_job(const Job &job);
+
+        OutputAdapter *oadp;
+        std::vector<ReplayPlayoutFilter *> filters;
+        Mutex filters_mutex;
+        ReplayFrameRing copies;
+
+        Pipe<Job> queue;
+        std::atomic<uint64_t> n_dropped;
+};
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_playout_playlist_source.h"
+#include <stdio.h>
+
+ReplayPlayoutPlaylistSource::ReplayPlayoutPlaylistSource(
+    const std::list<const char *> &files_,
+    unsigned int preroll_,
+    unsigned int lookahead_
+) {
+    for (auto i = files_.begin( ); i != files_.end( ); i++) {
+        files.push_back(*i);
+        durations.push_back(-1);
+    }
+
+    preroll = preroll_;
+    lookahead = (lookahead_ > 0) ? lookahead_ : 1;
+
+    current = NULL;
+    current_index = -1;
+    frames_rolled = 0;
+
+    next_to_open = 0;
+    n_probed = 0;
+    stop = false;
+
+    start_thread( );
+
+    /* wait for the first item to be opened and pre-rolled */
+    next_item( );
+}
+
+ReplayPlayoutPlaylistSource::~ReplayPlayoutPlaylistSource( ) {
+    { MutexLock l(m);
+        stop = true;
+        cond.broadcast( );
+    }
+
+    join_thread( );
+
+    delete current;
+
+    while (!opened.empty( )) {
+        delete opened.front( ).source;
+        opened.pop_front( );
+    }
+
+    while (!finished.empty( )) {
+        delete finished.front( );
+        finished.pop_front( );
+    }
+}
+
+void ReplayPlayoutPlaylistSource::read_frame(
+    ReplayPlayoutFrame &frame_data,
+    Rational speed
+) {
+    frame_data.video_data = NULL;
+    frame_data.audio_data = NULL;
+
+    while (current != NULL) {
+        current->read_frame(frame_data, speed);
+
+        if (frame_data.video_data != NULL) {
+            frames_rolled++;
+            return;
+        }
+
+        /* this item is done; cut straight to the next one */
+        if (!next_item( )) {
+            return;
+        }
+    }
+}
+
+bool ReplayPlayoutPlaylistSource::next_item( ) {
+    MutexLock l(m);
+
+    /* retire the current item; the opener thread deletes it */
+    if (current != NULL) {
+        finished.push_back(current);
+        current = NULL;
+        cond.broadcast( );
+    }
+
+    /* 
+     * normally the next item is already waiting. If it isn't,
+     * it's being opened right now, so there's nothing better to do.
+     */
+    while (opened.empty( ) && next_to_open < files.size( ) && !stop) {
+        cond.wait(m);
+    }
+
+    if (opened.empty( )) {
+        return false;
+    }
+
+    current = opened.front( ).source;
+    current_index = opened.front( ).index;
+    opened.pop_front( );
+    cond.broadcast( );
+
+    return true;
+}
+
+void ReplayPlayoutPlaylistSource::run_thread( ) {
+    std::list<ReplayPlayoutSource *> to_delete;
+    ReplayPlayoutLavfSource *src;
+    Item item;
+    size_t to_open, to_probe;
+    timecode_t duration;
+
+    for (;;) {
+        to_open = files.size( );
+        to_probe = files.size( );
+
+        { MutexLock l(m);
+            for (;;) {
+                if (stop) {
+                    return;
+                }
+
+                to_delete.swap(finished);
+
+                if (opened.size( ) < lookahead 
+                        && next_to_open < files.size( )) {
+                    to_open = next_to_open;
+                } else {
+                    /* skip items whose duration we already know */
+                    while (n_probed < files.size( ) 
+                            && durations[n_probed] >= 0) {
+                        n_probed++;
+                    }
+
+                    if (n_probed < files.size( )) {
+                        to_probe = n_probed++;
+                    }
+                }
+
+                if (!to_delete.empty( ) || to_open < files.size( ) 
+                        || to_probe < files.size( )) {
+                    break;
+                }
+
+                cond.wait(m);
+            }
+        }
+
+        while (!to_delete.empty( )) {
+            delete to_delete.front( );
+            to_delete.pop_front( );
+        }
+
+        if (to_open < files.size( )) {
+            src = NULL;
+
+            try {
+                src = new ReplayPlayoutLavfSource(files[to_open].c_str( ));
+                src->start(preroll);
+            } catch (std::exception &e) {
+                fprintf(stderr, "ReplayPlayoutPlaylistSource: "
+                    "failed to open %s: %s\n", files[to_open].c_str( ),
+                    e.what( ));
+                delete src;
+                src = NULL;
+            }
+
+            MutexLock l(m);
+            if (src != NULL) {
+                item.source = src;
+                item.index = to_open;
+                opened.push_back(item);
+                durations[to_open] = src->duration( );
+            } else {
+                durations[to_open] = 0;
+            }
+
+            next_to_open++;
+            cond.broadcast( );
+        } else if (to_probe < files.size( )) {
+            try {
+                duration = ReplayPlayoutLavfSource::get_file_duration(
+                    files[to_probe].c_str( )
+                );
+            } catch (std::exception &e) {
+                duration = 0;
+            }
+
+            MutexLock l(m);
+            if (durations[to_probe] < 0) {
+                durations[to_probe] = duration;
+            }
+        }
+    }
+}
+
+timecode_t ReplayPlayoutPlaylistSource::position( ) {
+    return frames_rolled;
+}
+
+timecode_t ReplayPlayoutPlaylistSource::duration( ) {
+    timecode_t total = 0;
+
+    MutexLock l(m);
+    for (size_t i = 0; i < durations.size( ); i++) {
+        if (durations[i] < 0) {
+            return -1;
+        }
+        total += durations[i];
+    }
+
+    return total;
+}
+
+timecode_t ReplayPlayoutPlaylistSource::item_position( ) {
+    if (current != NULL) {
+        return current->position( );
+    } else {
+        return 0;
+    }
+}
+
+timecode_t ReplayPlayoutPlaylistSource::item_duration( ) {
+    MutexLock l(m);
+    if (current_index >= 0) {
+        return durations[current_index];
+    } else {
+        return -1;
+    }
+}
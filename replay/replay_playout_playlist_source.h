@@ -0,0 +1,93 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_PLAYOUT_PLAYLIST_SOURCE_H
+#define _REPLAY_PLAYOUT_PLAYLIST_SOURCE_H
+
+#include "replay_playout_source.h"
+#include "replay_playout_lavf_source.h"
+#include "thread.h"
+#include "mutex.h"
+#include "condition.h"
+#include <deque>
+#include <list>
+#include <string>
+#include <vector>
+
+/*
+ * Plays a list of files back to back.
+ *
+ * Files are opened lazily by a background thread, which keeps the next 
+ * few items opened and pre-rolled while the current one plays. When an
+ * item runs out, the next one is already decoding, so the cut happens 
+ * on the very next frame. The constructor waits only for the first 
+ * item to be ready.
+ */
+class ReplayPlayoutPlaylistSource : public ReplayPlayoutSource, 
+        public Thread {
+    public:
+        ReplayPlayoutPlaylistSource(
+            const std::list<const char *> &files, 
+            unsigned int preroll = 15,
+            unsigned int lookahead = 2
+        );
+        ~ReplayPlayoutPlaylistSource( );
+
+        void read_frame(ReplayPlayoutFrame &frame_data, Rational speed);
+
+        timecode_t position( );
+        timecode_t duration( );
+
+        int item_index( ) { return current_index; }
+        timecode_t item_position( );
+        timecode_t item_duration( );
+
+    protected:
+        void run_thread( );
+
+        struct Item {
+            ReplayPlayoutLavfSource *source;
+            int index;
+        };
+
+        /* take the next opened item, waiting for it if need be */
+        bool next_item( );
+
+        std::vector<std::string> files;
+        std::vector<timecode_t> durations;
+        unsigned int preroll;
+        unsigned int lookahead;
+
+        /* owned by the playout thread */
+        ReplayPlayoutLavfSource *current;
+        int current_index;
+        timecode_t frames_rolled;
+
+        /* shared with the opener thread */
+        Mutex m;
+        Condition cond;
+        std::deque<Item> opened;
+        std::list<ReplayPlayoutSource *> finished;
+        size_t next_to_open;
+        size_t n_probed;
+        bool stop;
+};
+
+#endif
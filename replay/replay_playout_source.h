@@ -34,6 +34,14 @@ class ReplayPlayoutSource {
         virtual timecode_t position( ) = 0;
         virtual timecode_t duration( ) = 0;
 
+        /* 
+         * Sources that play a list of items report which item is
+         * playing, and the position within it.
+         */
+        virtual int item_index( ) { return 0; }
+        virtual timecode_t item_position( ) { return position( ); }
+        virtual timecode_t item_duration( ) { return duration( ); }
+
     protected:
         RawFrame::FieldDominance output_dominance;
 };
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_scope_filter.h"
+#include "raster_cache.h"
+#include "raw_frame_view.h"
+
+ReplayScopeFilter::ReplayScopeFilter( ) {
+    RawFrame *graticule;
+
+    graticule = RasterCache::get( ).svg_file("../assets/waveform.svg");
+    waveform_scope = new WaveformScope(graticule);
+    delete graticule;
+
+    graticule = RasterCache::get( ).svg_file("../assets/vectorscope.svg");
+    vector_scope = new VectorScope(graticule);
+    delete graticule;
+
+    enabled = true;
+    busy = false;
+    want_waveform = false;
+    want_vectorscope = false;
+    stop = false;
+
+    start_thread( );
+}
+
+ReplayScopeFilter::~ReplayScopeFilter( ) {
+    { MutexLock l(m);
+        stop = true;
+        c.signal( );
+    }
+
+    join_thread( );
+
+    delete waveform_scope;
+    delete vector_scope;
+}
+
+void ReplayScopeFilter::enable( ) {
+    enabled = true;
+}
+
+void ReplayScopeFilter::disable( ) {
+    enabled = false;
+}
+
+bool ReplayScopeFilter::is_enabled( ) {
+    return enabled;
+}
+
+void ReplayScopeFilter::select(bool waveform_, bool vectorscope_) {
+    MutexLock l(m);
+    want_waveform = waveform_;
+    want_vectorscope = vectorscope_;
+}
+
+void ReplayScopeFilter::process_frame(ReplayPlayoutFrame &frame) {
+    RawFrameView *view;
+
+    if (!enabled || frame.video_data->pixel_format( ) 
+            != RawFrame::CbYCrY8422) {
+        return;
+    }
+
+    MutexLock l(m);
+    if (!busy && pending.is_null( ) 
+            && (want_waveform || want_vectorscope)) {
+        view = dynamic_cast<RawFrameView *>(frame.video_data);
+        if (view != NULL) {
+            pending = view->target( );
+        } else {
+            /* 
+             * Hold on to the frame itself and pass on a view of it.
+             * Filters that draw have already run (see modifies_frame).
+             */
+            pending = ref<RawFrame>(frame.video_data);
+            frame.video_data = new RawFrameView(pending);
+        }
+        c.signal( );
+    }
+}
+
+void ReplayScopeFilter::run_thread( ) {
+    ref<RawFrame> frame;
+    bool do_waveform, do_vectorscope;
+    bool did_waveform = false, did_vectorscope = false;
+
+    for (;;) {
+        { MutexLock l(m);
+            busy = false;
+            while (pending.is_null( ) && !stop) {
+                c.wait(m);
+            }
+
+            if (stop) {
+                break;
+            }
+
+            frame = pending;
+            pending.reset( );
+            busy = true;
+            do_waveform = want_waveform;
+            do_vectorscope = want_vectorscope;
+        }
+
+        /* don't bring back a stale trace when a scope is reselected */
+        if (did_waveform && !do_waveform) {
+            waveform_scope->clear( );
+        }
+        if (did_vectorscope && !do_vectorscope) {
+            vector_scope->clear( );
+        }
+
+        if (do_waveform) {
+            waveform_scope->accumulate(frame.get( ));
+            waveform.put(new RawFrameView(waveform_scope->render( )));
+        }
+
+        if (do_vectorscope) {
+            vector_scope->accumulate(frame.get( ));
+            vectorscope.put(new RawFrameView(vector_scope->render( )));
+        }
+
+        did_waveform = do_waveform;
+        did_vectorscope = do_vectorscope;
+        frame.reset( );
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_SCOPE_FILTER_H
+#define _REPLAY_SCOPE_FILTER_H
+
+#include "replay_playout_filter.h"
+#include "thread.h"
+#include "mutex.h"
+#include "condition.h"
+#include "async_port.h"
+#include "scope.h"
+#include <atomic>
+
+/*
+ * Runs the waveform and vectorscope on the full-resolution program 
+ * video in a thread of its own. process_frame( ) takes a reference to
+ * a frame only when the worker is idle and some scope is selected, so
+ * playout never waits for the scopes (they just skip frames under 
+ * load). Rendered scopes come out of the waveform and vectorscope ports
+ * as views of the scopes' own outputs.
+ */
+class ReplayScopeFilter : public ReplayPlayoutFilter, public Thread {
+    public:
+        ReplayScopeFilter( );
+        ~ReplayScopeFilter( );
+
+        virtual void enable( );
+        virtual void disable( );
+        virtual bool is_enabled( );
+        virtual void process_frame(ReplayPlayoutFrame &frame);
+        virtual bool modifies_frame( ) { return false; }
+
+        /* Choose which scopes to compute. Initially neither. */
+        void select(bool waveform_, bool vectorscope_);
+
+        AsyncPort<RawFrame> waveform;
+        AsyncPort<RawFrame> vectorscope;
+
+    protected:
+        void run_thread( );
+
+        std::atomic<bool> enabled;
+
+        WaveformScope *waveform_scope;
+        VectorScope *vector_scope;
+
+        Mutex m;
+        Condition c;
+        ref<RawFrame> pending;
+        bool busy;
+        bool want_waveform, want_vectorscope;
+        bool stop;
+};
+
+#endif
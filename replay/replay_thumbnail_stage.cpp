@@ -0,0 +1,241 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "replay_thumbnail_stage.h"
+#include "mjpeg_codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THUMBNAIL_W 480
+#define THUMBNAIL_H 270
+/* decoder planes need room for a whole number of 8-line MCU rows */
+#define THUMBNAIL_ENC_H 272
+
+ReplayThumbnailStage::ReplayThumbnailStage(ReplayBuffer *buf_,
+        AsyncPort<ReplayRawFrame> *monitor_, unsigned int interval_,
+        unsigned int depth) : queue(depth + 1) {
+    buf = buf_;
+    monitor = monitor_;
+    counter = 0;
+    n_skipped = 0;
+    enc_w = enc_h = 0;
+    set_interval(interval_);
+    start_thread( );
+}
+
+ReplayThumbnailStage::~ReplayThumbnailStage( ) {
+    Job job;
+
+    queue.done_writing( );
+    join_thread( );
+
+    /* try_get throws once the closed queue runs dry */
+    try {
+        while (queue.try_get(job)) {
+            free_job(job);
+        }
+    } catch (BrokenPipe &) { }
+}
+
+/* decide if this frame gets a thumbnail (called from the ingest thread) */
+bool ReplayThumbnailStage::wanted( ) {
+    bool ret = (counter % interval == 0);
+    counter++;
+    return ret;
+}
+
+void ReplayThumbnailStage::offer(RawFrame *frame, timecode_t pos) {
+    Job job;
+
+    if (!wanted( )) {
+        delete frame;
+        return;
+    }
+
+    job.frame = frame;
+    job.jpeg = NULL;
+    job.jpeg_size = 0;
+    job.pos = pos;
+    enqueue(job);
+}
+
+void ReplayThumbnailStage::offer_jpeg(uint8_t *data, size_t size, 
+        timecode_t pos) {
+    Job job;
+
+    if (!wanted( )) {
+        free(data);
+        return;
+    }
+
+    job.frame = NULL;
+    job.jpeg = data;
+    job.jpeg_size = size;
+    job.pos = pos;
+    enqueue(job);
+}
+
+void ReplayThumbnailStage::offer_jpeg_copy(const uint8_t *data, 
+        size_t size, timecode_t pos) {
+    Job job;
+    uint8_t *copy;
+
+    if (!wanted( )) {
+        return;
+    }
+
+    copy = (uint8_t *) malloc(size);
+    if (copy == NULL) {
+        n_skipped++;
+        return;
+    }
+    memcpy(copy, data, size);
+
+    job.frame = NULL;
+    job.jpeg = copy;
+    job.jpeg_size = size;
+    job.pos = pos;
+    enqueue(job);
+}
+
+/* never blocks: when full, drop the oldest job to make room */
+void ReplayThumbnailStage::enqueue(const Job &job) {
+    Job old;
+
+    while (!queue.try_put(job)) {
+        if (queue.try_get(old)) {
+            free_job(old);
+            n_skipped++;
+        }
+    }
+}
+
+void ReplayThumbnailStage::free_job(const Job &job) {
+    delete job.frame;
+    free(job.jpeg);
+}
+
+/* 
+ * Double a small CbYCrY8422 frame in both directions by repeating 
+ * pixels. Only used on 1/8-scale decodes, so speed hardly matters.
+ */
+static RawFrame *pixel_double(RawFrame *src) {
+    RawFrame *dst = new RawFrame(src->w( ) * 2, src->h( ) * 2, 
+            RawFrame::CbYCrY8422);
+
+    for (coord_t y = 0; y < src->h( ); y++) {
+        const uint8_t *s = src->scanline(y);
+        uint8_t *d = dst->scanline(2 * y);
+
+        for (coord_t x = 0; x < src->w( ); x += 2) {
+            /* Cb Y0 Cr Y1 becomes Cb Y0 Cr Y0 Cb Y1 Cr Y1 */
+            d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[1];
+            d[4] = s[0]; d[5] = s[3]; d[6] = s[2]; d[7] = s[3];
+            s += 4;
+            d += 8;
+        }
+
+        memcpy(dst->scanline(2 * y + 1), dst->scanline(2 * y), 
+                dst->w( ) * 2);
+    }
+
+    return dst;
+}
+
+void ReplayThumbnailStage::run_thread( ) {
+    /* an 1/8 scale decode fits for sources up to 8 * THUMBNAIL_W wide */
+    Mjpeg422Decoder dec(THUMBNAIL_W, THUMBNAIL_ENC_H);
+    Mjpeg422Encoder *enc = NULL;
+    RawFrame *small;
+    ReplayRawFrame *monitor_frame;
+    RawFrame *thumb;
+    Job job;
+
+    for (;;) {
+        try {
+            job = queue.get( );
+        } catch (BrokenPipe &) {
+            break;
+        }
+        thumb = NULL;
+
+        try {
+            if (job.frame != NULL) {
+                thumb = job.frame->convert->CbYCrY8422_scaled(
+                    THUMBNAIL_W, THUMBNAIL_H
+                );
+                if (thumb == NULL) {
+                    throw std::runtime_error("cannot scale this frame size");
+                }
+            } else {
+                /* 
+                 * at 1/8 scale libjpeg uses only the DC coefficient of
+                 * each block, skipping the IDCT entirely
+                 */
+                thumb = dec.decode(job.jpeg, job.jpeg_size, 8);
+                if (thumb->w( ) * 2 <= THUMBNAIL_W) {
+                    small = thumb;
+                    thumb = pixel_double(small);
+                    delete small;
+                }
+            }
+
+            /* release the source (perhaps a capture buffer) early */
+            free_job(job);
+            job.frame = NULL;
+            job.jpeg = NULL;
+
+            /* 
+             * the encoder works on exactly its own width, so follow the
+             * thumbnail size (always 480x270 for 1080-line sources)
+             */
+            if (enc == NULL || enc_w != thumb->w( ) 
+                    || enc_h < thumb->h( )) {
+                delete enc;
+                enc = NULL;
+                if (thumb->w( ) % 16 != 0) {
+                    throw std::runtime_error("thumbnail width not coded");
+                }
+                enc_w = thumb->w( );
+                enc_h = (thumb->h( ) + 7) & ~7;
+                enc = new Mjpeg422Encoder(enc_w, enc_h, 30);
+            }
+
+            enc->encode(thumb);
+            buf->write_thumbnail(job.pos, 
+                    enc->get_data( ), enc->get_data_size( ));
+        } catch (std::exception &e) {
+            fprintf(stderr, "thumbnail for %s failed: %s\n", 
+                    buf->get_name( ), e.what( ));
+            free_job(job);
+            delete thumb;
+            continue;
+        }
+
+        monitor_frame = new ReplayRawFrame(thumb);
+        monitor_frame->source_name = buf->get_name( );
+        monitor_frame->tc = job.pos;
+        monitor->put(monitor_frame);
+    }
+
+    delete enc;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _REPLAY_THUMBNAIL_STAGE_H
+#define _REPLAY_THUMBNAIL_STAGE_H
+
+#include "thread.h"
+#include "pipe.h"
+#include "async_port.h"
+#include "replay_data.h"
+#include "replay_buffer.h"
+
+#include <atomic>
+
+/*
+ * Ingests that pass compressed frames straight through have nothing
+ * else to do per frame, so they can afford to make thumbnails less often.
+ */
+#define REPLAY_JPEG_THUMBNAIL_INTERVAL 4
+
+/*
+ * Background thumbnail generation for an ingest. Frames are offered 
+ * after they have been committed to the buffer; every Nth one is scaled
+ * (or, for M-JPEG input, decoded at 1/8 size from just the DC 
+ * coefficients and pixel-doubled), JPEG-encoded, 
+ * written as the buffer's thumbnail and sent to the monitor port.
+ *
+ * The queue is bounded. When the stage falls behind, the oldest queued
+ * frame is discarded so thumbnails catch back up to live.
+ */
+class ReplayThumbnailStage : public Thread {
+    public:
+        ReplayThumbnailStage(ReplayBuffer *buf_, 
+                AsyncPort<ReplayRawFrame> *monitor_, 
+                unsigned int interval_ = 2, unsigned int depth = 4);
+        ~ReplayThumbnailStage( );
+
+        /* these take ownership of the frame or (malloc'd) JPEG data */
+        void offer(RawFrame *frame, timecode_t pos);
+        void offer_jpeg(uint8_t *data, size_t size, timecode_t pos);
+
+        /* copies the JPEG, but only if it will be used */
+        void offer_jpeg_copy(const uint8_t *data, size_t size, 
+                timecode_t pos);
+
+        void set_interval(unsigned int n) { interval = (n > 0) ? n : 1; }
+        uint64_t skipped( ) { return n_skipped; }
+
+    protected:
+        struct Job {
+            RawFrame *frame;
+            uint8_t *jpeg;
+            size_t jpeg_size;
+            timecode_t pos;
+        };
+
+        void run_thread( );
+        bool wanted( );
+        void enqueue(const Job &job);
+        static void free_job(const Job &job);
+
+        ReplayBuffer *buf;
+        AsyncPort<ReplayRawFrame> *monitor;
+        Pipe<Job> queue;
+
+        coord_t enc_w, enc_h;
+        unsigned int interval;
+        unsigned int counter;
+        std::atomic<uint64_t> n_skipped;
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replay_vocoder_config.h"
+#include <math.h>
+#include <stdexcept>
+
+static const uint32_t config_version = 1;
+
+ReplayVocoderConfig::ReplayVocoderConfig( ) {
+    _fft_size = 1024;
+    _fft_hop = 128;
+    _window = HANN;
+}
+
+ReplayVocoderConfig::ReplayVocoderConfig(
+    size_t fft_size, 
+    size_t fft_hop,
+    WindowType window
+) {
+    _fft_size = fft_size;
+    _fft_hop = fft_hop;
+    _window = window;
+    validate( );
+}
+
+ReplayVocoderConfig::ReplayVocoderConfig(DeserializeStream &str) {
+    deserialize(str);
+}
+
+ReplayVocoderConfig ReplayVocoderConfig::legacy( ) {
+    return ReplayVocoderConfig(1024, 128, RECTANGULAR);
+}
+
+static bool is_power_of_two(size_t x) {
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+void ReplayVocoderConfig::validate( ) const {
+    if (!is_power_of_two(_fft_size) || _fft_size < 64 || _fft_size > 65536) {
+        throw std::runtime_error("vocoder FFT size must be a power of 2");
+    }
+
+    if (!is_power_of_two(_fft_hop) || _fft_hop > _fft_size) {
+        throw std::runtime_error(
+            "vocoder hop must be a power of 2 no larger than the FFT size"
+        );
+    }
+
+    /* 
+     * a squared Hann window only overlap-adds to a constant when 
+     * at least four frames overlap
+     */
+    if (_window == HANN && _fft_hop > _fft_size / 4) {
+        throw std::runtime_error("Hann window needs hop <= fft_size / 4");
+    }
+
+    if (_window != RECTANGULAR && _window != HANN) {
+        throw std::runtime_error("unknown vocoder window type");
+    }
+}
+
+void ReplayVocoderConfig::make_window(float *w) const {
+    const double pi = 3.14159265358979323846;
+
+    for (size_t i = 0; i < _fft_size; i++) {
+        switch (_window) {
+            case HANN:
+                /* periodic Hann, so overlapping copies sum evenly */
+                w[i] = 0.5 - 0.5 * cos(2.0 * pi * i / _fft_size);
+                break;
+            case RECTANGULAR:
+            default:
+                w[i] = 1.0f;
+                break;
+        }
+    }
+}
+
+float ReplayVocoderConfig::synthesis_scale( ) const {
+    /*
+     * The inverse FFT is unnormalized (gain fft_size), and each output 
+     * sample is the sum of fft_size / fft_hop windowed frames, each
+     * weighted by both the analysis and synthesis windows.
+     */
+    float *w = new float[_fft_size];
+    double power = 0.0;
+
+    make_window(w);
+    for (size_t i = 0; i < _fft_size; i++) {
+        power += double(w[i]) * double(w[i]);
+    }
+    delete [] w;
+
+    return float(_fft_hop) / (float(_fft_size) * float(power));
+}
+
+bool ReplayVocoderConfig::operator==(const ReplayVocoderConfig &other) const {
+    return _fft_size == other._fft_size 
+        && _fft_hop == other._fft_hop 
+        && _window == other._window;
+}
+
+void ReplayVocoderConfig::serialize(SerializeStream &str) const {
+    uint32_t window = _window;
+
+    str << config_version;
+    str << _fft_size;
+    str << _fft_hop;
+    str << window;
+}
+
+void ReplayVocoderConfig::deserialize(DeserializeStream &str) {
+    uint32_t version, window;
+
+    str >> version;
+    if (version != config_version) {
+        throw std::runtime_error("unknown vocoder config version");
+    }
+
+    str >> _fft_size;
+    str >> _fft_hop;
+    str >> window;
+    _window = (WindowType) window;
+
+    validate( );
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REPLAY_VOCODER_CONFIG_H
+#define _REPLAY_VOCODER_CONFIG_H
+
+#include "serialize.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define REPLAY_PVOC_CONFIG_BLOCK "ReplPvcf"
+
+/*
+ * Phase vocoder parameters. ReplayAudioIngest writes these alongside
+ * every vocoder frame, so ReplayAudioBufferPlayout always synthesizes
+ * with the same FFT size, hop and window that were used for analysis.
+ * Buffers recorded before this block existed are read using legacy( ).
+ */
+class ReplayVocoderConfig : public Serializable {
+    public:
+        enum WindowType { RECTANGULAR = 0, HANN = 1 };
+
+        /* defaults: 1024-point Hann window, 128 sample hop */
+        ReplayVocoderConfig( );
+        ReplayVocoderConfig(size_t fft_size, size_t fft_hop, 
+                WindowType window = HANN);
+        ReplayVocoderConfig(DeserializeStream &str);
+
+        /* the unwindowed 1024/128 setup used by older buffer files */
+        static ReplayVocoderConfig legacy( );
+
+        size_t fft_size( ) const { return _fft_size; }
+        size_t fft_hop( ) const { return _fft_hop; }
+        WindowType window_type( ) const { return _window; }
+
+        /* 
+         * fill w[0..fft_size-1] with the window function. 
+         * The same window is used for analysis and synthesis.
+         */
+        void make_window(float *w) const;
+
+        /*
+         * Gain to apply to the (unnormalized) inverse FFT output so that
+         * windowed overlap-add at fft_hop reconstructs unity gain.
+         */
+        float synthesis_scale( ) const;
+
+        /* throws std::runtime_error if the parameters are unusable */
+        void validate( ) const;
+
+        bool operator==(const ReplayVocoderConfig &other) const;
+        bool operator!=(const ReplayVocoderConfig &other) const {
+            return !(*this == other);
+        }
+
+        void serialize(SerializeStream &str) const;
+        void deserialize(DeserializeStream &str);
+
+    protected:
+        uint32_t _fft_size;
+        uint32_t _fft_hop;
+        WindowType _window;
+};
+
+#endif
@@ -10,6 +10,7 @@ module Replay
             params.source = opts[:port] || fail("Need some kind of input")
             params.x = opts[:x] || 0
             params.y = opts[:y] || 0
+            params.scopes = opts[:scopes]
 
             real_add_source(params)
         end
@@ -17,7 +18,7 @@ module Replay
 
     class RolloutApp
         def initialize
-            @dpys = FramebufferDisplaySurface.new
+            @dpys = BufferedFramebufferDisplaySurface.new
             @multiviewer = ReplayMultiviewer.new(@dpys)
 
             output = Replay::create_decklink_output_adapter_with_audio(2, 0, RawFrame::CbYCrY8422)
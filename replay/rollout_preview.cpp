@@ -22,11 +22,12 @@
 #include <stdio.h>
 
 RolloutPreview::RolloutPreview( ) {
+    source_next = 0;
     start_thread( );
 }
 
 RolloutPreview::~RolloutPreview( ) {
-
+    clear_cache( );
 }
 
 void RolloutPreview::load_file(const char *fn) {
@@ -52,8 +53,6 @@ void RolloutPreview::run_thread( ) {
     std::string current_file;
     std::string new_file;
     ReplayPlayoutLavfSource *current_source = NULL;
-    ReplayPlayoutFrame frame_data;
-    Rational speed(1,1);
     RawFrame *img;
     ReplayRawFrame *monitor_frame;
 
@@ -72,42 +71,110 @@ void RolloutPreview::run_thread( ) {
                 current_source = NULL;
             }
 
+            clear_cache( );
             current_source = new ReplayPlayoutLavfSource(new_file.c_str());
             current_file = new_file;
             current_pos = 0;
+            source_next = 0;
             do_update = true;
         }
 
-        /* if we have a new position, seek the file */
         if (new_pos != current_pos) {
             current_pos = new_pos;
             do_update = true;
-
-            if (current_source != NULL) {
-                current_source->seek(new_pos);
-            }
         }
 
         if (do_update && current_source != NULL) {
-            /* decode a frame of video */
-            current_source->read_frame(frame_data, speed);
-            
-            img = frame_data.video_data;
+            img = preview_frame(current_source, 
+                    current_source->frame_at(current_pos));
             
             /* put 1/2 scale version to multiviewer */
-            monitor_frame = new ReplayRawFrame(img->convert->BGRAn8_scale_1_2());
-            monitor_frame->source_name = "Preview";
-            monitor_frame->source_name2 = current_file.c_str();
-            monitor_frame->tc = 0;
-            monitor.put(monitor_frame);
-
-            /* delete decoded data so we don't leak it */
-            delete frame_data.video_data;
-            delete frame_data.audio_data;
+            if (img != NULL) {
+                monitor_frame = new ReplayRawFrame(img->copy( ));
+                monitor_frame->source_name = "Preview";
+                monitor_frame->source_name2 = current_file.c_str();
+                monitor_frame->tc = 0;
+                monitor.put(monitor_frame);
+            }
+        }
+    }
+}
+
+
+RawFrame *RolloutPreview::preview_frame(
+    ReplayPlayoutLavfSource *src, 
+    timecode_t frame
+) {
+    ReplayPlayoutFrame frame_data;
+    Rational speed(1,1);
+    std::map<timecode_t, RawFrame *>::iterator it;
+    timecode_t key;
+
+    it = cache.find(frame);
+    if (it != cache.end( )) {
+        return it->second;
+    }
+
+    /* 
+     * unless the frame is just ahead of where the source is, in the
+     * same GOP, go back to its keyframe and decode forward from there
+     */
+    key = src->keyframe_before(frame);
+    if (frame < source_next || key > source_next) {
+        src->seek_frame(key);
+        source_next = key;
+    }
+
+    while (source_next <= frame) {
+        src->read_frame(frame_data, speed);
+        if (frame_data.video_data == NULL) {
+            break;
+        }
+
+        /* keep what jogging is likely to come back to */
+        if (frame - source_next < (timecode_t) cache_size
+                && cache.find(source_next) == cache.end( )) {
+            cache[source_next] = 
+                frame_data.video_data->convert->BGRAn8_scale_1_2( );
+        }
+
+        /* delete decoded data so we don't leak it */
+        delete frame_data.video_data;
+        delete frame_data.audio_data;
+        source_next++;
+    }
+
+    /* drop the frames farthest from where we are now */
+    while (cache.size( ) > cache_size) {
+        if (frame - cache.begin( )->first > cache.rbegin( )->first - frame) {
+            delete cache.begin( )->second;
+            cache.erase(cache.begin( ));
+        } else {
+            delete cache.rbegin( )->second;
+            cache.erase(--cache.end( ));
         }
     }
+
+    it = cache.find(frame);
+    if (it != cache.end( )) {
+        return it->second;
+    } else if (!cache.empty( )) {
+        /* ran off the end of the file; show the last frame we have */
+        return cache.rbegin( )->second;
+    } else {
+        return NULL;
+    }
 }
 
+void RolloutPreview::clear_cache( ) {
+    std::map<timecode_t, RawFrame *>::iterator it;
+
+    for (it = cache.begin( ); it != cache.end( ); it++) {
+        delete it->second;
+    }
+
+    cache.clear( );
+}
 
 void RolloutPreview::wait_update(std::string &fn, int64_t &new_pos) {
     MutexLock l(m);
@@ -27,10 +27,18 @@
 #include "replay_data.h"
 #include <stdexcept>
 #include <string>
+#include <map>
+
+class ReplayPlayoutLavfSource;
 
 /* 
  * RolloutPreview objects allow interactive seeking of 
- * ReplayPlayoutLavfSources in the multiviewer
+ * ReplayPlayoutLavfSources in the multiviewer.
+ *
+ * Seeks are frame-exact. Every frame decoded on the way to the target
+ * is kept (at monitor size), so jogging back and forth around a GOP 
+ * doesn't decode it again, and jogging forward just carries on 
+ * decoding from where the source already is.
  */
 class RolloutPreview : public Thread {
     public:
@@ -48,6 +56,18 @@ class RolloutPreview : public Thread {
         void run_thread( );
         void wait_update(std::string &new_filename, int64_t &new_pos);
 
+        /* get the monitor-size picture of a frame, decoding as needed */
+        RawFrame *preview_frame(ReplayPlayoutLavfSource *src, 
+                timecode_t frame);
+        void clear_cache( );
+
+        /* frames decoded around the current position */
+        std::map<timecode_t, RawFrame *> cache;
+        static const size_t cache_size = 48;
+
+        /* the frame the source will decode next */
+        timecode_t source_next;
+
 	std::string filename;
 	int64_t pos;
 
@@ -34,7 +34,13 @@ class RolloutServer < Patchbay
     get '/rollstate.json' do
         position = @program.source_position
         duration = @program.source_duration
-        data = { 'position' => position, 'duration' => duration}
+        data = { 
+            'position' => position, 
+            'duration' => duration,
+            'item' => @program.source_item,
+            'item_position' => @program.source_item_position,
+            'item_duration' => @program.source_item_duration
+        }
         render :json => data.to_json
     end
 
@@ -19,6 +19,7 @@ replay_replay_test_OBJECTS = \
     replay/replay_preview.o \
     replay/replay_playout.o \
     replay/replay_multiviewer.o \
+    replay/replay_scope_filter.o \
     replay/replay_test.o
 
 replay_base_OBJECTS = \
@@ -35,10 +36,18 @@ replay_base_OBJECTS = \
 	replay/replay_buffer.o \
 	replay/replay_buffer_index.o \
 	replay/replay_ingest.o \
+	replay/replay_ingest_scheduler.o \
+	replay/replay_thumbnail_stage.o \
         replay/replay_mjpeg_ingest.o \
+	replay/replay_net_protocol.o \
+	replay/replay_net_sender.o \
+	replay/replay_net_ingest.o \
         replay/replay_audio_ingest.o \
+        replay/replay_vocoder_config.o \
 	replay/replay_preview.o \
 	replay/replay_playout.o \
+	replay/replay_playout_output.o \
+	replay/replay_frame_ring.o \
 	replay/replay_multiviewer.o \
 	replay/replay_frame_extractor.o \
 	replay/replay_gamedata.o \
@@ -49,8 +58,10 @@ replay_base_OBJECTS = \
 	replay/replay_playout_buffer_source.o \
 	replay/replay_playout_avspipe_source.o \
 	replay/replay_playout_lavf_source.o \
-	replay/replay_playout_queue_source.o \
+	replay/lavf_frame_index.o \
+	replay/replay_playout_playlist_source.o \
 	replay/replay_playout_image_filter.o \
+	replay/replay_scope_filter.o \
 	replay/rollout_preview.o \
 
 replay_replay_so_OBJECTS = \
@@ -66,7 +77,7 @@ replay/replay_playout_lavf_source_test: $(replay_base_OBJECTS) replay/replay_pla
 replay/replay_buffer_to_mjpeg: $(common_OBJECTS) $(thread_OBJECTS) replay/replay_buffer_to_mjpeg.o
 	$(CXX) $(LDFLAGS) -o $@ $^ -lpthread $(common_LIBS)
 
-replay/replay_buffer_to_audio: $(common_OBJECTS) $(thread_OBJECTS) replay/replay_buffer_to_audio.o
+replay/replay_buffer_to_audio: $(common_OBJECTS) $(thread_OBJECTS) replay/replay_vocoder_config.o replay/replay_buffer_to_audio.o
 	$(CXX) $(LDFLAGS) -o $@ $^ -lpthread $(common_LIBS)
 
 all_TARGETS += replay/replay.so
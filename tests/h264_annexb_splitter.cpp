@@ -0,0 +1,120 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Feeds a small Annex B stream to H264AnnexBSplitter in every possible
+ * pair of pieces and byte by byte, and checks that the same access 
+ * units come out each time, including when a start code or the NAL 
+ * header after it is split across reads.
+ */
+
+#include "h264_annexb_splitter.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+class TestSplitter : public H264AnnexBSplitter {
+    public:
+        std::vector<std::vector<uint8_t> > units;
+
+        void feed(const uint8_t *data, size_t size) {
+            uint8_t *dst;
+            size_t space;
+
+            dst = read_space(size, space);
+            memcpy(dst, data, size);
+            commit_read(size);
+        }
+
+    protected:
+        void access_unit(const uint8_t *data, size_t size) {
+            units.push_back(std::vector<uint8_t>(data, data + size));
+        }
+};
+
+static int failures = 0;
+
+static void check(bool cond, const char *what, size_t split) {
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s (split at %zu)\n", what, split);
+        failures++;
+    }
+}
+
+/* access unit delimiter, then two slices of one picture */
+static const uint8_t picture[] = {
+    0, 0, 0, 1, 0x09, 0xf0,
+    0, 0, 1, 0x65, 0x88, 1, 2, 3,
+    0, 0, 1, 0x65, 0x00, 4, 5
+};
+
+#define N_PICTURES 4
+
+static void check_units(const TestSplitter &s, size_t split) {
+    /* the last picture stays buffered until the next one starts */
+    check(s.units.size( ) == N_PICTURES, "number of access units", split);
+
+    for (size_t i = 0; i < s.units.size( ); i++) {
+        check(s.units[i].size( ) == sizeof(picture) 
+                && memcmp(&s.units[i][0], picture, sizeof(picture)) == 0,
+                "access unit contents", split);
+    }
+}
+
+int main( ) {
+    std::vector<uint8_t> stream;
+    static const uint8_t aud[] = { 0, 0, 0, 1, 0x09, 0xf0 };
+
+    for (int i = 0; i < N_PICTURES; i++) {
+        stream.insert(stream.end( ), picture, picture + sizeof(picture));
+    }
+    stream.insert(stream.end( ), aud, aud + sizeof(aud));
+
+    /* all at once, and in two pieces split at every offset */
+    for (size_t split = 0; split <= stream.size( ); split++) {
+        TestSplitter s;
+        if (split > 0) {
+            s.feed(&stream[0], split);
+        }
+        if (split < stream.size( )) {
+            s.feed(&stream[split], stream.size( ) - split);
+        }
+        check_units(s, split);
+    }
+
+    /* one byte at a time */
+    TestSplitter s;
+    for (size_t i = 0; i < stream.size( ); i++) {
+        s.feed(&stream[i], 1);
+    }
+    check_units(s, 1);
+
+    /* after reset_parser( ), a partial picture is forgotten */
+    TestSplitter r;
+    r.feed(&stream[0], 10);
+    r.reset_parser( );
+    r.feed(&stream[0], stream.size( ));
+    check_units(r, 10);
+
+    if (failures == 0) {
+        printf("h264_annexb_splitter: ok\n");
+    }
+    return failures != 0;
+}
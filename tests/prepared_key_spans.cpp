@@ -0,0 +1,154 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * PreparedKey span classification: each row of the prepared alpha is
+ * split into 8-pixel spans that are clear, solid or mixed, taking the
+ * chroma filter's bleed into neighboring pixels into account. Only 
+ * rows inside the key's damage rectangle are reclassified.
+ */
+
+#include "prepared_key.h"
+#include "raw_frame.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+struct ExpectedSpan {
+    coord_t start, end;
+    KeyCoverage::SpanType type;
+};
+
+static void check_row(const PreparedKey &pk, coord_t y, 
+        const ExpectedSpan *expected, size_t n, const char *what) {
+    const PreparedKey::SpanList &spans = pk.row(y);
+    bool ok = (spans.size( ) == n);
+
+    for (size_t i = 0; ok && i < n; i++) {
+        ok = spans[i].start == expected[i].start 
+                && spans[i].end == expected[i].end
+                && spans[i].type == expected[i].type;
+    }
+
+    if (!ok) {
+        fprintf(stderr, "row %d:", y);
+        for (size_t i = 0; i < spans.size( ); i++) {
+            fprintf(stderr, " [%d,%d)=%d", spans[i].start, spans[i].end,
+                    spans[i].type);
+        }
+        fprintf(stderr, "\n");
+    }
+    check(ok, what);
+}
+
+/* set the alpha of pixels [x0, x1) of row y, with a white fill */
+static void fill_alpha(RawFrame *key, coord_t y, coord_t x0, coord_t x1,
+        uint8_t alpha) {
+    for (coord_t x = x0; x < x1; x++) {
+        uint8_t *p = key->scanline(y) + 4 * x;
+        p[0] = p[1] = p[2] = 0xff;
+        p[3] = alpha;
+    }
+}
+
+#define W 64
+#define H 5
+
+int main( ) {
+    RawFrame *key = new RawFrame(W, H, RawFrame::BGRAn8);
+    PreparedKey pk;
+
+    memset(key->data( ), 0, key->size( ));
+    fill_alpha(key, 1, 0, W, 0xff);
+    fill_alpha(key, 2, 16, 32, 0xff);
+    fill_alpha(key, 3, 0, W, 0x80);
+    fill_alpha(key, 4, 20, 21, 0xff);
+
+    pk.update(key);
+    check(pk.valid( ) && pk.w( ) == W && pk.h( ) == H, "geometry");
+
+    static const ExpectedSpan clear[] = { 
+        { 0, W, KeyCoverage::CLEAR } 
+    };
+    static const ExpectedSpan solid[] = { 
+        { 0, W, KeyCoverage::SOLID } 
+    };
+    static const ExpectedSpan mixed[] = { 
+        { 0, W, KeyCoverage::MIXED } 
+    };
+
+    /* 
+     * the chroma filter spreads alpha one pixel pair beyond the edges 
+     * of the opaque run, which makes the blocks on either side mixed 
+     */
+    static const ExpectedSpan bar[] = {
+        { 0, 16, KeyCoverage::CLEAR },
+        { 16, 24, KeyCoverage::MIXED },
+        { 24, 32, KeyCoverage::SOLID },
+        { 32, 40, KeyCoverage::MIXED },
+        { 40, W, KeyCoverage::CLEAR },
+    };
+
+    /* a single opaque pixel can never make a solid block */
+    static const ExpectedSpan dot[] = {
+        { 0, 16, KeyCoverage::CLEAR },
+        { 16, 24, KeyCoverage::MIXED },
+        { 24, W, KeyCoverage::CLEAR },
+    };
+
+    check_row(pk, 0, clear, 1, "transparent row is one clear span");
+    check_row(pk, 1, solid, 1, "opaque row is one solid span");
+    check_row(pk, 2, bar, 5, "opaque bar");
+    check_row(pk, 3, mixed, 1, "translucent row is one mixed span");
+    check_row(pk, 4, dot, 3, "single pixel");
+
+    check(pk.alpha_line(1)[0] == 0xff && pk.alpha_line(0)[0] == 0
+            && pk.alpha_line(3)[1] == 0x80, "prepared alpha");
+
+    /* change rows 0 and 1, but only declare row 1 damaged */
+    fill_alpha(key, 0, 0, W, 0xff);
+    fill_alpha(key, 1, 0, W, 0);
+    key->set_damage(Rect(0, 1, W, 1));
+    pk.update(key);
+
+    check_row(pk, 0, clear, 1, "undamaged row not reclassified");
+    check_row(pk, 1, clear, 1, "damaged row reclassified");
+    check_row(pk, 2, bar, 5, "other rows kept");
+
+    /* invalidate( ) forces a full update again */
+    pk.invalidate( );
+    pk.update(key);
+    check_row(pk, 0, solid, 1, "full update after invalidate");
+
+    delete key;
+
+    if (failures == 0) {
+        printf("prepared_key_spans: ok\n");
+    }
+    return failures != 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * ref<T> reference counting and copy on write, with a counted test 
+ * type and with RawFrame itself.
+ */
+
+#include "ref.h"
+#include "raw_frame.h"
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+class Counted : public RefCounted {
+    public:
+        Counted(int v) : value(v) { live++; }
+        Counted(const Counted &other) 
+                : RefCounted(other), value(other.value) { 
+            live++;
+            clones++;
+        }
+        ~Counted( ) { live--; }
+
+        Counted *clone( ) const { return new Counted(*this); }
+
+        int value;
+
+        static int live;
+        static int clones;
+};
+
+int Counted::live = 0;
+int Counted::clones = 0;
+
+static void test_counting( ) {
+    {
+        ref<Counted> a(new Counted(1));
+        check(a->ref_count( ) == 1 && a.unique( ), "new ref is unique");
+
+        {
+            ref<Counted> b(a);
+            check(a.get( ) == b.get( ), "copies share the object");
+            check(a->ref_count( ) == 2 && !a.unique( ), "copy counts");
+
+            ref<Counted> c(std::move(b));
+            check(b.is_null( ) && a->ref_count( ) == 2, "move transfers");
+        }
+
+        check(a->ref_count( ) == 1, "copies released");
+        check(Counted::live == 1, "object alive while referenced");
+
+        a.reset(new Counted(2));
+        check(Counted::live == 1 && a->value == 2, "reset replaces");
+    }
+
+    check(Counted::live == 0, "last ref deletes");
+}
+
+static void test_copy_on_write( ) {
+    Counted::clones = 0;
+
+    {
+        ref<Counted> a(new Counted(1));
+        ref<Counted> b(a);
+
+        b.make_writable( );
+        check(Counted::clones == 1, "shared object copied");
+        check(a.get( ) != b.get( ) && a.unique( ) && b.unique( ), 
+                "writer has a private copy");
+
+        b->value = 2;
+        check(a->value == 1 && b->value == 2, "other holder unaffected");
+
+        b.make_writable( );
+        check(Counted::clones == 1, "unique object not copied");
+
+        ref<Counted> n;
+        n.make_writable( );
+        check(n.is_null( ), "null ref stays null");
+    }
+
+    check(Counted::live == 0, "no leaks");
+}
+
+static void test_raw_frame( ) {
+    ref<RawFrame> a(new RawFrame(16, 2, RawFrame::CbYCrY8422));
+    memset(a->data( ), 0x10, a->size( ));
+    a->set_capture_time(1234);
+
+    ref<RawFrame> b(a);
+    b.make_writable( );
+    check(a.get( ) != b.get( ), "shared frame copied");
+    check(b->w( ) == 16 && b->h( ) == 2 
+            && b->pixel_format( ) == RawFrame::CbYCrY8422
+            && b->capture_time( ) == 1234, "copy keeps format and metadata");
+
+    b->data( )[0] = 0x20;
+    check(a->data( )[0] == 0x10 && b->data( )[1] == 0x10, 
+            "copy has its own pixels");
+}
+
+int main( ) {
+    test_counting( );
+    test_copy_on_write( );
+    test_raw_frame( );
+
+    if (failures == 0) {
+        printf("ref_copy_on_write: ok\n");
+    }
+    return failures != 0;
+}
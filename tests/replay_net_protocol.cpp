@@ -0,0 +1,214 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Round trip of the replay net frame protocol over a socket pair: 
+ * frames with and without audio, a header grown by a later version,
+ * clean EOF, and rejection of malformed or truncated frames.
+ */
+
+#include "replay_net_protocol.h"
+#include "replay_frame_data.h"
+#include "posix_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <stdexcept>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void make_socketpair(int fds[2]) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        exit(1);
+    }
+}
+
+static bool read_fails(int fd) {
+    ReplayFrameData dest;
+    RawFrame::FieldDominance dominance;
+    uint64_t timestamp;
+
+    try {
+        replay_net_read_frame(fd, dest, dominance, timestamp);
+    } catch (std::exception &) {
+        return true;
+    }
+
+    free(dest.video_data);
+    delete dest.audio;
+    return false;
+}
+
+static void test_round_trip( ) {
+    uint8_t video[1000];
+    int fds[2];
+
+    make_socketpair(fds);
+
+    for (int i = 0; i < 6; i++) {
+        ReplayFrameData src;
+        IOAudioPacket audio(800, 2);
+
+        memset(video, i, sizeof(video));
+        src.video_data = video;
+        src.video_size = 500 + i;
+
+        for (size_t j = 0; j < audio.size_words( ); j++) {
+            audio.data( )[j] = i * 100 + j;
+        }
+        src.audio = (i % 2) ? &audio : NULL;
+
+        check(replay_net_write_frame(fds[0], src, 
+                RawFrame::TOP_FIELD_FIRST, 1000 + i) == 1, "write frame");
+    }
+    close(fds[0]);
+
+    for (int i = 0; i < 6; i++) {
+        ReplayFrameData dest;
+        RawFrame::FieldDominance dominance;
+        uint64_t timestamp;
+
+        check(replay_net_read_frame(fds[1], dest, dominance, timestamp) 
+                == 1, "read frame");
+
+        check(timestamp == (uint64_t) (1000 + i), "timestamp");
+        check(dominance == RawFrame::TOP_FIELD_FIRST, "field dominance");
+        check(dest.video_size == (size_t) (500 + i), "video size");
+        check(dest.video_data != NULL && dest.video_data[0] == i
+                && dest.video_data[dest.video_size - 1] == i, 
+                "video data");
+
+        if (i % 2) {
+            check(dest.audio != NULL && dest.audio->size_samples( ) == 800
+                    && dest.audio->channels( ) == 2
+                    && dest.audio->data( )[1599] == i * 100 + 1599,
+                    "audio");
+        } else {
+            check(dest.audio == NULL, "no audio");
+        }
+
+        free(dest.video_data);
+        delete dest.audio;
+    }
+
+    /* nothing left: a clean EOF between frames */
+    ReplayFrameData dest;
+    RawFrame::FieldDominance dominance;
+    uint64_t timestamp;
+    check(replay_net_read_frame(fds[1], dest, dominance, timestamp) == 0,
+            "EOF between frames");
+
+    close(fds[1]);
+}
+
+/* a longer header from a newer sender is skipped */
+static void test_grown_header( ) {
+    ReplayNetFrameHeader hdr;
+    uint8_t extra[16];
+    uint8_t video[4] = { 1, 2, 3, 4 };
+    int fds[2];
+
+    make_socketpair(fds);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = REPLAY_NET_MAGIC;
+    hdr.header_size = sizeof(hdr) + sizeof(extra);
+    hdr.timestamp = 42;
+    hdr.video_size = sizeof(video);
+    memset(extra, 0xee, sizeof(extra));
+
+    write_all(fds[0], &hdr, sizeof(hdr));
+    write_all(fds[0], extra, sizeof(extra));
+    write_all(fds[0], video, sizeof(video));
+    close(fds[0]);
+
+    ReplayFrameData dest;
+    RawFrame::FieldDominance dominance;
+    uint64_t timestamp;
+    check(replay_net_read_frame(fds[1], dest, dominance, timestamp) == 1
+            && timestamp == 42 && dest.video_size == sizeof(video)
+            && memcmp(dest.video_data, video, sizeof(video)) == 0,
+            "grown header");
+    free(dest.video_data);
+
+    close(fds[1]);
+}
+
+static void test_malformed( ) {
+    ReplayNetFrameHeader hdr;
+    int fds[2];
+
+    /* wrong magic */
+    make_socketpair(fds);
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.header_size = sizeof(hdr);
+    write_all(fds[0], &hdr, sizeof(hdr));
+    check(read_fails(fds[1]), "bad magic rejected");
+    close(fds[0]);
+    close(fds[1]);
+
+    /* header too large to be real */
+    make_socketpair(fds);
+    hdr.magic = REPLAY_NET_MAGIC;
+    hdr.header_size = REPLAY_NET_MAX_HEADER + 1;
+    write_all(fds[0], &hdr, sizeof(hdr));
+    check(read_fails(fds[1]), "oversized header rejected");
+    close(fds[0]);
+    close(fds[1]);
+
+    /* video larger than the limit */
+    make_socketpair(fds);
+    hdr.header_size = sizeof(hdr);
+    hdr.video_size = REPLAY_NET_MAX_VIDEO + 1;
+    write_all(fds[0], &hdr, sizeof(hdr));
+    check(read_fails(fds[1]), "oversized video rejected");
+    close(fds[0]);
+    close(fds[1]);
+
+    /* stream ends in the middle of a frame */
+    make_socketpair(fds);
+    hdr.video_size = 100;
+    write_all(fds[0], &hdr, sizeof(hdr));
+    write_all(fds[0], &hdr, 10);
+    close(fds[0]);
+    check(read_fails(fds[1]), "truncated frame rejected");
+    close(fds[1]);
+}
+
+int main( ) {
+    test_round_trip( );
+    test_grown_header( );
+    test_malformed( );
+
+    if (failures == 0) {
+        printf("replay_net_protocol: ok\n");
+    }
+    return failures != 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * ReplayVocoderConfig parameter checks and the synthesis gain that
+ * ReplayAudioBufferPlayout applies to the inverse FFT output.
+ */
+
+#include "replay_vocoder_config.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdexcept>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static bool accepted(size_t size, size_t hop, 
+        ReplayVocoderConfig::WindowType window) {
+    try {
+        ReplayVocoderConfig config(size, hop, window);
+        return true;
+    } catch (std::runtime_error &) {
+        return false;
+    }
+}
+
+static void test_validate( ) {
+    check(accepted(1024, 128, ReplayVocoderConfig::HANN), 
+            "1024/128 Hann accepted");
+    check(accepted(2048, 512, ReplayVocoderConfig::HANN), 
+            "Hann with hop == size / 4 accepted");
+
+    check(!accepted(1000, 125, ReplayVocoderConfig::RECTANGULAR), 
+            "non power of two size rejected");
+    check(!accepted(1536, 128, ReplayVocoderConfig::HANN), 
+            "non power of two size rejected (Hann)");
+    check(!accepted(1024, 96, ReplayVocoderConfig::RECTANGULAR), 
+            "non power of two hop rejected");
+    check(!accepted(1024, 0, ReplayVocoderConfig::RECTANGULAR), 
+            "zero hop rejected");
+    check(!accepted(1024, 2048, ReplayVocoderConfig::RECTANGULAR), 
+            "hop larger than size rejected");
+
+    check(!accepted(1024, 512, ReplayVocoderConfig::HANN), 
+            "Hann with hop == size / 2 rejected");
+    check(!accepted(1024, 1024, ReplayVocoderConfig::HANN), 
+            "Hann with hop == size rejected");
+    check(accepted(1024, 512, ReplayVocoderConfig::RECTANGULAR), 
+            "rectangular with hop == size / 2 accepted");
+}
+
+static void test_hann_scale( ) {
+    const size_t size = 2048, hop = 256;
+    ReplayVocoderConfig config(size, hop, ReplayVocoderConfig::HANN);
+    float w[size];
+    double power = 0.0;
+
+    config.make_window(w);
+    for (size_t i = 0; i < size; i++) {
+        power += double(w[i]) * double(w[i]);
+    }
+
+    /* sum of squares of a periodic Hann window is 3N/8 */
+    check(fabs(power - 3.0 * size / 8.0) < 1e-3, "Hann window power");
+
+    double expected = double(hop) / (double(size) * power);
+    check(fabs(config.synthesis_scale( ) - expected) < 1e-6 * expected,
+            "Hann synthesis scale is hop / (size * sum(w^2))");
+
+    check(w[0] == 0.0f && fabs(w[size / 2] - 1.0f) < 1e-6, 
+            "periodic Hann endpoints");
+}
+
+static void test_legacy_scale( ) {
+    ReplayVocoderConfig legacy = ReplayVocoderConfig::legacy( );
+
+    check(legacy.fft_size( ) == 1024 && legacy.fft_hop( ) == 128
+            && legacy.window_type( ) == ReplayVocoderConfig::RECTANGULAR,
+            "legacy parameters");
+
+    /* the scale factor ReplayAudioBufferPlayout used before configs */
+    size_t fft_size = 1024, fft_hop = 128;
+    float old_scale = float(fft_hop) / (float(fft_size) * float(fft_size));
+    check(legacy.synthesis_scale( ) == old_scale, 
+            "legacy synthesis scale matches the old constant exactly");
+
+    check(ReplayVocoderConfig( ) != legacy, "default is not legacy");
+}
+
+int main( ) {
+    test_validate( );
+    test_hann_scale( );
+    test_legacy_scale( );
+
+    if (failures == 0) {
+        printf("replay_vocoder_config: ok\n");
+    }
+    return failures != 0;
+}
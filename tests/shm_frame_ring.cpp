@@ -0,0 +1,126 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * ShmFrameRing slot selection: the producer must never be handed the 
+ * slot the consumer holds or the latest published one, and the consumer
+ * always gets the latest frame. One ring object plays both parts, so 
+ * slot addresses can be compared; a second one attached to the same 
+ * memory checks what another process would see.
+ */
+
+#include "shm_frame_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <set>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+    if (!cond) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void publish_frame(ShmFrameRing &ring, int tag, void *&slot) {
+    ShmFrameInfo info;
+
+    ring.begin_write(slot);
+    memset(slot, tag, ring.slot_size( ));
+
+    memset(&info, 0, sizeof(info));
+    info.x = tag;
+    ring.publish(info);
+}
+
+static void test_slots(unsigned int n_slots) {
+    ShmFrameRing ring(4096, n_slots);
+    ShmFrameRing &producer = ring, &consumer = ring;
+    ShmFrameRing other;
+    ShmFrameInfo info;
+    const void *held, *got;
+    void *slot, *again, *latest;
+    std::set<void *> used;
+
+    check(!consumer.acquire(0, got, info), "nothing published yet");
+
+    /* begin_write is idempotent until publish */
+    producer.begin_write(slot);
+    producer.begin_write(again);
+    check(slot == again, "same slot until publish");
+
+    publish_frame(producer, 1, latest);
+    check(latest == slot, "published the slot from begin_write");
+
+    check(consumer.acquire(0, held, info), "acquire first frame");
+    check(info.sequence == 1 && info.x == 1 && info.timestamp != 0, 
+            "first frame metadata");
+    check(((const uint8_t *) held)[0] == 1, "first frame data");
+
+    /* 
+     * while the consumer holds a slot, the producer keeps going 
+     * without ever touching it or the latest frame
+     */
+    for (int i = 2; i < 50; i++) {
+        producer.begin_write(slot);
+        check(slot != held, "producer avoids the held slot");
+        check(slot != latest, "producer avoids the latest slot");
+        used.insert(slot);
+        publish_frame(producer, i, latest);
+    }
+    check(used.size( ) == n_slots - 1, 
+            "producer uses every free slot");
+    check(((const uint8_t *) held)[0] == 1, "held frame untouched");
+    consumer.release( );
+
+    /* frames in between are skipped: the consumer gets the latest */
+    check(consumer.acquire(1, got, info), "acquire latest frame");
+    check(info.sequence == 49 && info.x == 49 && got == latest,
+            "latest frame metadata");
+    check(((const uint8_t *) got)[0] == 49, "latest frame data");
+    consumer.release( );
+
+    other.init_from_fd(ring.get_fd( ));
+    check(other.n_slots( ) == n_slots && other.slot_size( ) >= 4096,
+            "attached ring geometry");
+    check(other.acquire(0, got, info) && info.sequence == 49 
+            && ((const uint8_t *) got)[0] == 49, "attached ring sees latest");
+    other.release( );
+
+    /* nothing newer than what we have: hold nothing */
+    check(!consumer.acquire(49, got, info), "no newer frame");
+    producer.begin_write(slot);
+    check(slot != latest, "released slot free again, latest kept");
+
+    check(producer.published( ) == 49, "publish count");
+    check(!consumer.wait_for_publish(49, 10), "wait times out");
+    check(consumer.wait_for_publish(48, 10), "wait sees a new count");
+}
+
+int main( ) {
+    test_slots(3);
+    test_slots(5);
+
+    if (failures == 0) {
+        printf("shm_frame_ring: ok\n");
+    }
+    return failures != 0;
+}
@@ -320,3 +320,83 @@ test_BGRAn8_BGRAn8_composite_chunk_sse2_OBJECTS = \
 tests/test_BGRAn8_BGRAn8_composite_chunk_sse2: $(test_BGRAn8_BGRAn8_composite_chunk_sse2_OBJECTS)
 	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS) $(raw_frame_LIBS)
 
+
+test_prepared_key_spans_OBJECTS = \
+	$(common_OBJECTS) \
+	$(raw_frame_OBJECTS) \
+	tests/prepared_key_spans.o
+
+tests/prepared_key_spans: $(test_prepared_key_spans_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS) $(raw_frame_LIBS)
+
+all_TARGETS += tests/prepared_key_spans
+
+test_h264_annexb_splitter_OBJECTS = \
+	drivers/h264_annexb_splitter.o \
+	tests/h264_annexb_splitter.o
+
+tests/h264_annexb_splitter: $(test_h264_annexb_splitter_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^
+
+all_TARGETS += tests/h264_annexb_splitter
+
+test_shm_frame_ring_OBJECTS = \
+	$(common_OBJECTS) \
+	$(ipc_OBJECTS) \
+	tests/shm_frame_ring.o
+
+tests/shm_frame_ring: $(test_shm_frame_ring_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS)
+
+all_TARGETS += tests/shm_frame_ring
+
+test_replay_net_protocol_OBJECTS = \
+	$(common_OBJECTS) \
+	replay/replay_net_protocol.o \
+	replay/replay_frame_data.o \
+	tests/replay_net_protocol.o
+
+tests/replay_net_protocol: $(test_replay_net_protocol_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS)
+
+all_TARGETS += tests/replay_net_protocol
+
+test_ref_copy_on_write_OBJECTS = \
+	$(common_OBJECTS) \
+	$(raw_frame_OBJECTS) \
+	tests/ref_copy_on_write.o
+
+tests/ref_copy_on_write: $(test_ref_copy_on_write_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS) $(raw_frame_LIBS)
+
+all_TARGETS += tests/ref_copy_on_write
+
+test_replay_vocoder_config_OBJECTS = \
+	$(common_OBJECTS) \
+	replay/replay_vocoder_config.o \
+	tests/replay_vocoder_config.o
+
+tests/replay_vocoder_config: $(test_replay_vocoder_config_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS)
+
+all_TARGETS += tests/replay_vocoder_config
+
+test_YCbCr_CbYCrY8422_sse2_OBJECTS = \
+	$(common_OBJECTS) \
+	$(raw_frame_OBJECTS) \
+	tests/test_YCbCr_CbYCrY8422_sse2.o
+
+tests/test_YCbCr_CbYCrY8422_sse2: $(test_YCbCr_CbYCrY8422_sse2_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS) $(raw_frame_LIBS)
+
+all_TARGETS += tests/test_YCbCr_CbYCrY8422_sse2
+
+test_BGRAn8_coverage_blend_sse2_OBJECTS = \
+	$(common_OBJECTS) \
+	$(raw_frame_OBJECTS) \
+	tests/test_BGRAn8_coverage_blend_sse2.o
+
+tests/test_BGRAn8_coverage_blend_sse2: $(test_BGRAn8_coverage_blend_sse2_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ $(common_LIBS) $(raw_frame_LIBS)
+
+all_TARGETS += tests/test_BGRAn8_coverage_blend_sse2
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Compare the SSE2 coverage blend against the default C version: 
+ * partially transparent colors, all-zero coverage blocks that the
+ * kernel skips, a repeated coverage row (pitch 0), widths that leave
+ * a C tail, and clipping at the right edge.
+ */
+
+#include "raw_frame.h"
+#include "cpu_dispatch.h"
+#include "draw_BGRAn8.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+	if (!cond) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static const coord_t frame_w = 40, frame_h = 6;
+
+static void fill_random(RawFrame *f) {
+	for (size_t i = 0; i < f->size( ); i++) {
+		f->data( )[i] = rand( );
+	}
+}
+
+static void test_blend(coord_t x, coord_t y, coord_t w, coord_t h, 
+		size_t pitch, const uint8_t *coverage, const uint8_t *bgra) {
+	char what[128];
+	RawFrame sse2(frame_w, frame_h, RawFrame::BGRAn8);
+	RawFrame def(frame_w, frame_h, RawFrame::BGRAn8);
+	RawFrame orig(frame_w, frame_h, RawFrame::BGRAn8);
+
+	fill_random(&orig);
+	memcpy(sse2.data( ), orig.data( ), orig.size( ));
+	memcpy(def.data( ), orig.data( ), orig.size( ));
+
+	BGRAn8_coverage_blend_sse2(&sse2, x, y, coverage, w, h, pitch, bgra);
+	BGRAn8_coverage_blend_default(&def, x, y, coverage, w, h, pitch, bgra);
+
+	snprintf(what, sizeof(what), 
+			"sse2 matches default (x=%d w=%d h=%d pitch=%zu alpha=%d)",
+			(int) x, (int) w, (int) h, pitch, bgra[3]);
+	check(memcmp(sse2.data( ), def.data( ), def.size( )) == 0, what);
+
+	/* pixels without coverage, or outside the rectangle, are untouched */
+	for (coord_t row = 0; row < frame_h; row++) {
+		for (coord_t col = 0; col < frame_w; col++) {
+			bool inside = row >= y && row < y + h && col >= x && col < x + w;
+			bool covered = inside && coverage[pitch * (row - y) + col - x];
+			if (!covered && memcmp(sse2.pixel(col, row), 
+					orig.pixel(col, row), 4) != 0) {
+				snprintf(what, sizeof(what), 
+						"uncovered pixel %d,%d unchanged", 
+						(int) col, (int) row);
+				check(false, what);
+			}
+		}
+	}
+}
+
+int main( ) {
+	static const uint8_t colors[][4] = {
+		{ 0x20, 0x80, 0xe0, 0xff },
+		{ 0xff, 0x00, 0x40, 0x80 },
+		{ 0x10, 0xf0, 0x70, 0x01 },
+		{ 0x90, 0x30, 0xc0, 0xfe }
+	};
+	static const coord_t widths[] = { 1, 3, 4, 5, 7, 8, 13, 17, 31 };
+	uint8_t coverage[frame_w * frame_h];
+
+	srand(7);
+
+	for (size_t ci = 0; ci < sizeof(colors) / sizeof(colors[0]); ci++) {
+		for (size_t wi = 0; wi < sizeof(widths) / sizeof(widths[0]); wi++) {
+			coord_t w = widths[wi];
+
+			/* 
+			 * random coverage with 0 and 255 mixed in, and some 
+			 * all-zero groups of four the kernel skips
+			 */
+			for (size_t i = 0; i < sizeof(coverage); i++) {
+				switch (rand( ) % 4) {
+					case 0: coverage[i] = 0; break;
+					case 1: coverage[i] = 255; break;
+					default: coverage[i] = rand( ); break;
+				}
+			}
+			memset(coverage + 4, 0, 4);
+			memset(coverage + frame_w + 8, 0, 8);
+
+			test_blend(2, 1, w, 4, frame_w, coverage, colors[ci]);
+			test_blend(1, 0, w, frame_h, 0, coverage, colors[ci]);
+
+			/* clipped at the right edge */
+			test_blend(frame_w - w / 2 - 1, 0, w, 2, frame_w, 
+					coverage, colors[ci]);
+		}
+
+		memset(coverage, 0, sizeof(coverage));
+		test_blend(0, 0, frame_w, frame_h, frame_w, coverage, colors[ci]);
+	}
+
+	if (failures == 0) {
+		printf("BGRAn8_coverage_blend_sse2: ok\n");
+	}
+	return failures != 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Compare the SSE2 planar to CbYCrY8422 packers against the default C
+ * versions and a straightforward reference. Widths that are not a
+ * multiple of 16 exercise the C tail after the vector kernel, and
+ * every source plane ends right before an inaccessible page so that
+ * reading past the last line faults.
+ */
+
+#include "pack_CbYCrY8422.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what, size_t w, size_t h) {
+	if (!cond) {
+		fprintf(stderr, "FAIL: %s (w=%zu h=%zu)\n", what, w, h);
+		failures++;
+	}
+}
+
+/* 
+ * Allocate size bytes ending exactly at a PROT_NONE guard page.
+ */
+static void *guarded_alloc(size_t size) {
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t pages = (size + page - 1) / page + 1;
+	uint8_t *base = (uint8_t *) mmap(NULL, pages * page, 
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (base == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+
+	mprotect(base + (pages - 1) * page, page, PROT_NONE);
+	return base + (pages - 1) * page - size;
+}
+
+static void guarded_free(void *ptr, size_t size) {
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t pages = (size + page - 1) / page + 1;
+	uint8_t *end = (uint8_t *)ptr + size;
+	munmap(end - (pages - 1) * page, pages * page);
+}
+
+/* a plane of lines lines, pitch apart, with the last one cut to width */
+template <typename T>
+static T *make_plane(size_t width, size_t lines, size_t pitch, 
+		unsigned int max) {
+	size_t n = (lines - 1) * pitch + width;
+	T *plane = (T *) guarded_alloc(n * sizeof(T));
+
+	for (size_t i = 0; i < n; i++) {
+		plane[i] = rand( ) % (max + 1);
+	}
+	return plane;
+}
+
+template <typename T>
+static void free_plane(T *plane, size_t width, size_t lines, size_t pitch) {
+	guarded_free(plane, ((lines - 1) * pitch + width) * sizeof(T));
+}
+
+/*
+ * Reference packing. chroma_line maps an output line to its chroma line.
+ */
+template <typename T, int shift>
+static void pack_reference(size_t w, size_t h, 
+		size_t Ypitch, size_t Cbpitch, size_t Crpitch,
+		T *Y, T *Cb, T *Cr, uint8_t *dst, bool subsampled) {
+	for (size_t line = 0; line < h; line++) {
+		size_t cline = subsampled ? line / 2 : line;
+		for (size_t i = 0; i < w; i += 2) {
+			*(dst++) = Cb[cline * Cbpitch + i/2] >> shift;
+			*(dst++) = Y[line * Ypitch + i] >> shift;
+			*(dst++) = Cr[cline * Crpitch + i/2] >> shift;
+			*(dst++) = Y[line * Ypitch + i + 1] >> shift;
+		}
+	}
+}
+
+typedef void (*pack8_fn)(size_t, size_t, size_t, size_t, size_t,
+		uint8_t *, uint8_t *, uint8_t *, uint8_t *);
+typedef void (*pack16_fn)(size_t, size_t, size_t, size_t, size_t,
+		uint16_t *, uint16_t *, uint16_t *, uint8_t *);
+
+template <typename T, int shift, typename F>
+static void test_one(const char *name, F sse2, F def, bool subsampled,
+		size_t w, size_t h, size_t Ypad, size_t Cpad) {
+	size_t Ypitch = w + Ypad;
+	size_t Cpitch = w / 2 + Cpad;
+	size_t clines = subsampled ? (h + 1) / 2 : h;
+	unsigned int max = (shift == 0) ? 255 : 1023;
+	char what[128];
+
+	T *Y = make_plane<T>(w, h, Ypitch, max);
+	T *Cb = make_plane<T>(w / 2, clines, Cpitch, max);
+	T *Cr = make_plane<T>(w / 2, clines, Cpitch, max);
+
+	uint8_t *expected = (uint8_t *) guarded_alloc(2 * w * h);
+	uint8_t *out_sse2 = (uint8_t *) guarded_alloc(2 * w * h);
+	uint8_t *out_default = (uint8_t *) guarded_alloc(2 * w * h);
+
+	pack_reference<T, shift>(w, h, Ypitch, Cpitch, Cpitch, 
+			Y, Cb, Cr, expected, subsampled);
+
+	memset(out_sse2, 0xaa, 2 * w * h);
+	memset(out_default, 0x55, 2 * w * h);
+	sse2(w, h, Ypitch, Cpitch, Cpitch, Y, Cb, Cr, out_sse2);
+	def(w, h, Ypitch, Cpitch, Cpitch, Y, Cb, Cr, out_default);
+
+	snprintf(what, sizeof(what), "%s sse2 matches reference", name);
+	check(memcmp(out_sse2, expected, 2 * w * h) == 0, what, w, h);
+	snprintf(what, sizeof(what), "%s default matches reference", name);
+	check(memcmp(out_default, expected, 2 * w * h) == 0, what, w, h);
+
+	guarded_free(expected, 2 * w * h);
+	guarded_free(out_sse2, 2 * w * h);
+	guarded_free(out_default, 2 * w * h);
+	free_plane(Y, w, h, Ypitch);
+	free_plane(Cb, w / 2, clines, Cpitch);
+	free_plane(Cr, w / 2, clines, Cpitch);
+}
+
+/*
+ * 4:2:0 with one distinct value per chroma line: output lines 2k and 
+ * 2k+1 must both carry chroma line k.
+ */
+static void test_420_stepping(pack8_fn fn, const char *name) {
+	const size_t w = 20, h = 7, clines = 4;
+	char what[128];
+
+	uint8_t *Y = make_plane<uint8_t>(w, h, w, 255);
+	uint8_t *Cb = (uint8_t *) guarded_alloc(clines * w / 2);
+	uint8_t *Cr = (uint8_t *) guarded_alloc(clines * w / 2);
+	uint8_t *dst = (uint8_t *) guarded_alloc(2 * w * h);
+
+	for (size_t line = 0; line < clines; line++) {
+		memset(Cb + line * w / 2, 0x10 + line, w / 2);
+		memset(Cr + line * w / 2, 0x80 + line, w / 2);
+	}
+
+	fn(w, h, w, w / 2, w / 2, Y, Cb, Cr, dst);
+
+	for (size_t line = 0; line < h; line++) {
+		bool ok = true;
+		for (size_t i = 0; i < w; i += 2) {
+			uint8_t *px = dst + 2 * w * line + 2 * i;
+			if (px[0] != 0x10 + line / 2 || px[2] != 0x80 + line / 2) {
+				ok = false;
+			}
+		}
+		snprintf(what, sizeof(what), 
+				"%s output line %zu uses chroma line %zu", 
+				name, line, line / 2);
+		check(ok, what, w, h);
+	}
+
+	guarded_free(dst, 2 * w * h);
+	guarded_free(Cr, clines * w / 2);
+	guarded_free(Cb, clines * w / 2);
+	free_plane(Y, w, h, w);
+}
+
+int main( ) {
+	static const size_t widths[] = { 2, 6, 14, 16, 22, 32, 34, 50, 1920 };
+	static const size_t heights[] = { 1, 2, 3, 5 };
+	static const size_t pads[][2] = { { 0, 0 }, { 1, 3 }, { 7, 5 } };
+
+	srand(42);
+
+	for (size_t wi = 0; wi < sizeof(widths) / sizeof(widths[0]); wi++) {
+	for (size_t hi = 0; hi < sizeof(heights) / sizeof(heights[0]); hi++) {
+	for (size_t pi = 0; pi < sizeof(pads) / sizeof(pads[0]); pi++) {
+		size_t w = widths[wi], h = heights[hi];
+
+		test_one<uint8_t, 0, pack8_fn>("YCbCr8P422", 
+				YCbCr8P422_CbYCrY8422_A_sse2, 
+				YCbCr8P422_CbYCrY8422_A_default, 
+				false, w, h, pads[pi][0], pads[pi][1]);
+		test_one<uint16_t, 2, pack16_fn>("YCbCr10P422", 
+				YCbCr10P422_CbYCrY8422_A_sse2, 
+				YCbCr10P422_CbYCrY8422_A_default, 
+				false, w, h, pads[pi][0], pads[pi][1]);
+		test_one<uint8_t, 0, pack8_fn>("YCbCr8P420", 
+				YCbCr8P420_CbYCrY8422_A_sse2, 
+				YCbCr8P420_CbYCrY8422_A_default, 
+				true, w, h, pads[pi][0], pads[pi][1]);
+	}
+	}
+	}
+
+	test_420_stepping(YCbCr8P420_CbYCrY8422_A_default, "YCbCr8P420 default");
+	test_420_stepping(YCbCr8P420_CbYCrY8422_A_sse2, "YCbCr8P420 sse2");
+
+	if (failures == 0) {
+		printf("YCbCr_CbYCrY8422_sse2: ok\n");
+	}
+	return failures != 0;
+}
@@ -54,6 +54,10 @@ class BrokenPipe : public virtual std::exception {
  *  This may also block until a thread tries to get( ).
  *  Returns 1 when the object is put. Zero if the pipe has been closed.
  *
+ * bool try_get(T& obj), bool try_put(const T& obj):
+ *  Non-blocking variants. Return false instead of waiting when the
+ *  pipe is empty (resp. full).
+ *
  * void close_read(void):
  *  Close reader end of the pipe.
  *
@@ -131,6 +135,48 @@ class PipeLocked {
             }
         }
 
+        bool try_get(T& obj) {
+            MutexLock lock(mut);
+            if (empty( )) {
+                if (write_done) {
+                    throw BrokenPipe( );
+                }
+                return false;
+            }
+
+            assert(buf[read_ptr] != NULL);
+            obj = *(buf[read_ptr]);
+            delete buf[read_ptr];
+            buf[read_ptr] = NULL;
+
+            read_ptr = advance(read_ptr);
+            pipe_not_full.signal( );
+            return true;
+        }
+
+        bool try_put(const T& obj) {
+            MutexLock lock(mut);
+            if (read_done) {
+                throw BrokenPipe( );
+            }
+
+            if (full( )) {
+                return false;
+            }
+
+            assert(buf[write_ptr] == NULL);
+            buf[write_ptr] = new T(obj);
+
+            write_ptr = advance(write_ptr);
+            pipe_not_empty.signal( );
+            return true;
+        }
+
+        /* Maximum number of objects the pipe can hold. */
+        unsigned int capacity( ) const {
+            return buf_len - 1;
+        }
+
         void done_reading(void) {
             { MutexLock lock(mut);
                 read_done = true;
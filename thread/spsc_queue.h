@@ -0,0 +1,124 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SPSC_QUEUE_H
+#define _SPSC_QUEUE_H
+
+#include <atomic>
+#include <stdexcept>
+#include <semaphore.h>
+#include <errno.h>
+
+/*
+ * Bounded single-producer, single-consumer queue.
+ *
+ * Neither side ever takes a lock, so the consumer may safely be a 
+ * hardware driver callback (e.g. DeckLink's frame completion thread).
+ * The producer may optionally block while the queue is full; the 
+ * consumer wakes it with sem_post( ), which does not block either.
+ *
+ * Methods:
+ *
+ * bool try_put(const T& obj): put obj if there is room. Never blocks.
+ * void put(const T& obj): put obj, waiting for the consumer if full.
+ * bool try_get(T& obj): take the oldest object if any. Never blocks.
+ * unsigned int fill( ): approximate number of queued objects.
+ */
+template <class T>
+class SpscQueue {
+    public:
+        SpscQueue(unsigned int size_) {
+            /* one slot is always left empty to tell full from empty */
+            size = size_ + 1;
+            array = new T[size];
+            read_ptr = 0;
+            write_ptr = 0;
+
+            if (sem_init(&free_slots, 0, size_) != 0) {
+                throw std::runtime_error("sem_init failed");
+            }
+        }
+
+        ~SpscQueue( ) {
+            sem_destroy(&free_slots);
+            delete [] array;
+        }
+
+        bool try_put(const T& obj) {
+            if (sem_trywait(&free_slots) != 0) {
+                return false;
+            }
+            do_put(obj);
+            return true;
+        }
+
+        void put(const T& obj) {
+            while (sem_wait(&free_slots) != 0) {
+                if (errno != EINTR) {
+                    throw std::runtime_error("sem_wait failed");
+                }
+            }
+            do_put(obj);
+        }
+
+        bool try_get(T& obj) {
+            unsigned int r = read_ptr.load(std::memory_order_relaxed);
+
+            if (r == write_ptr.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            obj = array[r];
+            read_ptr.store(next(r), std::memory_order_release);
+            sem_post(&free_slots);
+            return true;
+        }
+
+        unsigned int fill( ) const {
+            unsigned int r = read_ptr.load(std::memory_order_acquire);
+            unsigned int w = write_ptr.load(std::memory_order_acquire);
+
+            if (w >= r) {
+                return w - r;
+            } else {
+                return size - r + w;
+            }
+        }
+
+        unsigned int capacity( ) const { return size - 1; }
+
+    protected:
+        /* caller has already reserved a slot through free_slots */
+        void do_put(const T& obj) {
+            unsigned int w = write_ptr.load(std::memory_order_relaxed);
+            array[w] = obj;
+            write_ptr.store(next(w), std::memory_order_release);
+        }
+
+        unsigned int next(unsigned int i) const {
+            return (i + 1 == size) ? 0 : i + 1;
+        }
+
+        T *array;
+        unsigned int size;
+        std::atomic<unsigned int> read_ptr, write_ptr;
+        sem_t free_slots;
+};
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "work_pool.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdexcept>
+
+/* set in each worker thread so that work it submits stays local */
+static __thread WorkPool *current_pool = NULL;
+static __thread unsigned int current_worker = 0;
+
+WorkPool::WorkPool(unsigned int n_workers) {
+    long n_cpus;
+
+    pending = 0;
+    next_queue = 0;
+
+    if (n_workers == 0) {
+        n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_workers = (n_cpus > 0) ? n_cpus : 1;
+    }
+
+    for (unsigned int i = 0; i < n_workers; i++) {
+        workers.push_back(new Worker(this, i));
+    }
+}
+
+WorkPool::~WorkPool( ) {
+    /* 
+     * Like the other threads in this codebase the workers run for the
+     * life of the process, so there is nothing we can safely free here.
+     */
+}
+
+void WorkPool::submit(WorkItem *item) {
+    unsigned int q;
+
+    if (current_pool == this) {
+        q = current_worker;
+    } else {
+        MutexLock l(m);
+        q = next_queue;
+        next_queue = (next_queue + 1) % workers.size( );
+    }
+
+    { MutexLock l(workers[q]->m);
+        workers[q]->queue.push_back(item);
+    }
+
+    { MutexLock l(m);
+        pending++;
+        work_ready.signal( );
+    }
+}
+
+void WorkPool::priority(int policy, int prio) {
+    for (unsigned int i = 0; i < workers.size( ); i++) {
+        workers[i]->priority(policy, prio);
+    }
+}
+
+/*
+ * Take the oldest item from our own queue, or failing that the newest 
+ * from someone else's. The caller has already reserved one of the 
+ * pending items, so this only has to retry if it loses a race.
+ */
+WorkItem *WorkPool::take(unsigned int worker) {
+    WorkItem *item;
+    unsigned int n = workers.size( );
+
+    for (;;) {
+        { MutexLock l(workers[worker]->m);
+            if (!workers[worker]->queue.empty( )) {
+                item = workers[worker]->queue.front( );
+                workers[worker]->queue.pop_front( );
+                return item;
+            }
+        }
+
+        for (unsigned int i = 1; i < n; i++) {
+            Worker *victim = workers[(worker + i) % n];
+            MutexLock l(victim->m);
+            if (!victim->queue.empty( )) {
+                item = victim->queue.back( );
+                victim->queue.pop_back( );
+                return item;
+            }
+        }
+
+        sched_yield( );
+    }
+}
+
+void WorkPool::run_worker(unsigned int worker) {
+    WorkItem *item;
+
+    current_pool = this;
+    current_worker = worker;
+
+    for (;;) {
+        { MutexLock l(m);
+            while (pending == 0) {
+                work_ready.wait(m);
+            }
+            pending--;
+        }
+
+        item = take(worker);
+
+        try {
+            item->run(worker);
+        } catch (std::exception &e) {
+            fprintf(stderr, "work pool: item failed: %s\n", e.what( ));
+        }
+
+        delete item;
+    }
+}
+
+WorkPool::Worker::Worker(WorkPool *pool_, unsigned int index_) {
+    pool = pool_;
+    index = index_;
+    start_thread( );
+}
+
+void WorkPool::Worker::run_thread( ) {
+    pool->run_worker(index);
+}
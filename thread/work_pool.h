@@ -0,0 +1,84 @@
+/*
+ * Copyright 2013 Exavideo LLC.
+ * 
+ * This file is part of openreplay.
+ * 
+ * openreplay is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * openreplay is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with openreplay.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _WORK_POOL_H
+#define _WORK_POOL_H
+
+#include "thread.h"
+#include "mutex.h"
+#include "condition.h"
+
+#include <deque>
+#include <vector>
+
+/*
+ * A unit of work for a WorkPool. run( ) is told the index of the worker 
+ * executing it, so callers can keep per-worker state (e.g. encoders) 
+ * without locking. The pool deletes each item after it has run.
+ */
+class WorkItem {
+    public:
+        virtual ~WorkItem( ) { }
+        virtual void run(unsigned int worker) = 0;
+};
+
+/*
+ * A fixed set of worker threads sharing a stream of WorkItems.
+ * Each worker has its own queue; idle workers steal from the others, 
+ * so a burst from one producer spreads across the whole machine.
+ */
+class WorkPool {
+    public:
+        /* n_workers = 0 means one worker per online CPU */
+        WorkPool(unsigned int n_workers = 0);
+        ~WorkPool( );
+
+        void submit(WorkItem *item);
+        unsigned int n_workers( ) const { return workers.size( ); }
+        void priority(int policy, int priority);
+
+    protected:
+        class Worker : public Thread {
+            public:
+                Worker(WorkPool *pool_, unsigned int index_);
+
+                Mutex m;
+                std::deque<WorkItem *> queue;
+
+            protected:
+                void run_thread( );
+                WorkPool *pool;
+                unsigned int index;
+        };
+
+        WorkItem *take(unsigned int worker);
+        void run_worker(unsigned int worker);
+
+        std::vector<Worker *> workers;
+
+        Mutex m;
+        Condition work_ready;
+        unsigned int pending;
+        unsigned int next_queue;
+
+        friend class Worker;
+};
+
+#endif
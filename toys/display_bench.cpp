@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "memory_display_surface.h"
+
+/*
+ * Headless multiviewer-style load: a 4x4 grid of 480x270 tiles, a few
+ * of which change every frame. Reports flip rate and bytes copied.
+ */
+
+static double now( ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    MemoryDisplaySurface dpy(1920, 1080);
+    RawFrame tile(480, 270, RawFrame::BGRAn8);
+    int changed_per_frame = (argc > 1) ? atoi(argv[1]) : 3;
+    const int n_frames = 1000;
+    double start, elapsed;
+
+    memset(tile.data( ), 0x80, tile.size( ));
+
+    start = now( );
+    for (int i = 0; i < n_frames; i++) {
+        for (int j = 0; j < changed_per_frame; j++) {
+            int t = (i * changed_per_frame + j) % 16;
+            coord_t x = (t % 4) * 480;
+            coord_t y = (t / 4) * 270;
+
+            dpy.damage(Rect(x, y, tile.w( ), tile.h( )));
+            dpy.draw->blit(x, y, &tile);
+        }
+        dpy.flip( );
+    }
+    elapsed = now( ) - start;
+
+    printf("%d tiles/frame: %.1f flips/s, %.1f MB copied per flip\n",
+            changed_per_frame, n_frames / elapsed, 
+            dpy.bytes_copied( ) / 1e6 / dpy.flips( ));
+
+    return 0;
+}
@@ -24,3 +24,12 @@ toys_pipes_toy_OBJECTS = \
 
 toys/pipes_toy: $(toys_pipes_toy_OBJECTS)
 	$(CXX) $(LDFLAGS) -o $@ $^ -ldl -pthread $(graphics_LIBS)
+
+toys_display_bench_OBJECTS = \
+	toys/display_bench.o \
+	$(common_OBJECTS) \
+	$(raw_frame_OBJECTS) \
+	$(display_surface_OBJECTS) \
+
+toys/display_bench: $(toys_display_bench_OBJECTS)
+	$(CXX) $(LDFLAGS) -o $@ $^ -ldl -pthread $(raw_frame_LIBS)